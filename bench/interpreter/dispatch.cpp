@@ -0,0 +1,110 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/switch_evaluator.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+namespace {
+
+// Loops with expression heavy bodies, where dispatch is most of the work
+struct dispatch_benchmark {
+    const char *name;
+    int64_t iterations;
+    std::string program;
+};
+
+const dispatch_benchmark benchmarks[] = {
+    { "arithmetic", 5'000'000, R"(
+        i = 0;
+        s = 0;
+        while (i < 5000000) {
+            s = (s * 3 + i * 7 - (i - 5) * (i + 5)) / 5;
+            i += 1;
+        }
+        print(s);
+    )" },
+
+    { "comparisons", 5'000'000, R"(
+        i = 0;
+        a = 0;
+        while (i < 5000000) {
+            a = a + (i < 100) + (i > 200) * 2 + (i == a) * 4 + (i <= a) * 8 - (i >= a) * 8;
+            i += 1;
+        }
+        print(a);
+    )" },
+
+    { "branches", 5'000'000, R"(
+        i = 0;
+        odd = 0;
+        even = 0;
+        while (i < 5000000) {
+            if (i / 2 * 2 == i) {
+                even += 1;
+            }
+            if (i / 2 * 2 == i - 1) {
+                odd -= -1;
+            }
+            i += 1;
+        }
+        print(odd - even);
+    )" },
+};
+
+// Runs program, returns iterations per second, its output is written to result
+template <typename run_type>
+double measure(const dispatch_benchmark &benchmark, run_type run, std::string &result) {
+    std::stringstream output;
+    std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(old_cout);
+    result = output.str();
+
+    std::chrono::duration<double> elapsed = end - start;
+    return static_cast<double>(benchmark.iterations) / elapsed.count();
+}
+
+} // end anonymous namespace
+
+
+int main() {
+    std::cout << std::left << std::setw(16) << "benchmark"
+              << std::right << std::setw(16) << "virtual M it/s"
+              << std::setw(16) << "switch M it/s"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (const dispatch_benchmark &benchmark: benchmarks) {
+        std::string program = benchmark.program;
+
+        paracl::ast tree_ast(paracl::tokenize(program));
+        paracl::ast switch_ast(paracl::tokenize(program));
+
+        std::string tree_result, switch_result;
+
+        double tree_speed = measure(benchmark, [&] { tree_ast.run(); }, tree_result);
+        double switch_speed = measure(benchmark, [&] {
+            paracl::switch_evaluator evaluator(switch_ast.get_context());
+            evaluator.run(switch_ast.get_scope());
+        }, switch_result);
+
+        if (tree_result != switch_result) {
+            std::cerr << benchmark.name << ": results differ\n";
+            return EXIT_FAILURE;
+        }
+
+        std::cout << std::left << std::setw(16) << benchmark.name << std::right << std::fixed
+                  << std::setprecision(2)
+                  << std::setw(16) << tree_speed / 1e6
+                  << std::setw(16) << switch_speed / 1e6
+                  << std::setw(9) << switch_speed / tree_speed << "x\n";
+    }
+}
@@ -0,0 +1,96 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+#include "paracl/text/file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace {
+
+template <typename action_type>
+double measure_seconds(action_type action) {
+    auto start = std::chrono::steady_clock::now();
+    action();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+} // end anonymous namespace
+
+
+// Program sums given number of values from its input, prompts go to /dev/null
+int main(int argc, const char *argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 5'000'000;
+
+    std::string program = "n = ?; sum = 0; while (n > 0) { sum += ?; n -= 1; } print(sum);";
+
+    std::string values = std::to_string(count) + "\n";
+    for (size_t i = 0; i < count; ++ i)
+        values += std::to_string(static_cast<int64_t>(i * 2654435761 % 1'000'000'007) - 500'000'000) + " ";
+
+    const char *path = "/tmp/paracl-bench-input";
+    std::FILE *file = std::fopen(path, "w");
+    if (!file || std::fwrite(values.data(), 1, values.size(), file) != values.size()) {
+        std::cerr << "can't write " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    std::fclose(file);
+
+    int null = open("/dev/null", O_WRONLY);
+    if (null < 0) {
+        std::cerr << "can't open /dev/null\n";
+        return EXIT_FAILURE;
+    }
+
+    paracl::output_sink &output = paracl::get_output();
+    output.write_to(null, { .on_newline = false, .before_input = false });
+
+    paracl::input_source &input = paracl::get_input();
+
+    // Like std::cin was, one number at a time from stream, with a prompt before each:
+    std::istringstream stream(values);
+    double stream_time = measure_seconds([&] {
+        paracl::ast ast(paracl::tokenize(program));
+        input.read_from(stream, true);
+        ast.run();
+    });
+
+    int fd = open(path, O_RDONLY);
+    double descriptor_time = measure_seconds([&] {
+        paracl::ast ast(paracl::tokenize(program));
+        input.read_from(fd);
+        ast.run();
+    });
+    close(fd);
+
+    double mapped_time = measure_seconds([&] {
+        paracl::ast ast(paracl::tokenize(program));
+        paracl::mapped_file mapped(path);
+        input.read_from(mapped.get_text());
+        ast.run();
+    });
+
+    input.read_from(std::cin, true);
+    output.write_to(std::cout);
+    close(null);
+    std::remove(path);
+
+    double numbers = static_cast<double>(count);
+    std::cout << std::fixed << std::setprecision(2)
+              << "stream:     " << numbers / stream_time / 1e6 << " M numbers/s\n"
+              << "descriptor: " << numbers / descriptor_time / 1e6 << " M numbers/s ("
+                                << stream_time / descriptor_time << "x)\n"
+              << "mapped:     " << numbers / mapped_time / 1e6 << " M numbers/s ("
+                                << stream_time / mapped_time << "x)\n";
+}
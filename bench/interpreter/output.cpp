@@ -0,0 +1,61 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/output.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace {
+
+template <typename action_type>
+double measure_seconds(action_type action) {
+    auto start = std::chrono::steady_clock::now();
+    action();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+} // end anonymous namespace
+
+
+// Program that prints given number of lines, written to /dev/null
+int main(int argc, const char *argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 2'000'000;
+
+    std::string program = "i = 0; while (i < " + std::to_string(lines) + ") { print(i * 7919); i += 1; }";
+    paracl::ast ast(paracl::tokenize(program));
+
+    int null = open("/dev/null", O_WRONLY);
+    if (null < 0) {
+        std::cerr << "can't open /dev/null\n";
+        return EXIT_FAILURE;
+    }
+
+    paracl::output_sink &output = paracl::get_output();
+
+    // Like std::endl did, every line is a write:
+    output.write_to(null, { .on_newline = true, .before_input = true });
+    double line_time = measure_seconds([&] { ast.run(); });
+
+    output.write_to(null, { .on_newline = false, .before_input = false });
+    double buffered_time = measure_seconds([&] {
+        ast.run();
+        output.flush();
+    });
+
+    output.write_to(std::cout);
+    close(null);
+
+    double count = static_cast<double>(lines);
+    std::cout << std::fixed << std::setprecision(2)
+              << "flushed every line: " << count / line_time / 1e6 << " M lines/s\n"
+              << "buffered:           " << count / buffered_time / 1e6 << " M lines/s ("
+              << line_time / buffered_time << "x)\n";
+}
@@ -0,0 +1,115 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/unrolling.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+namespace {
+
+// Tight counting loops, none of them has a closed form
+struct loop_benchmark {
+    const char *name;
+    int64_t iterations;
+    std::string program;
+};
+
+const loop_benchmark benchmarks[] = {
+    { "recurrence", 20'000'000, R"(
+        i = 0;
+        s = 0;
+        while (i < 20000000) {
+            s = s * 3 + i;
+            i += 1;
+        }
+        print(s);
+    )" },
+
+    { "variable bound", 20'000'000, R"(
+        n = 20000000;
+        i = 0;
+        s = 0;
+        while (i < n) {
+            s = s * 3 + i;
+            i += 1;
+        }
+        print(s);
+    )" },
+
+    { "branch in body", 10'000'000, R"(
+        i = 30000000;
+        s = 0;
+        while (i > 0) {
+            s = s + i / 7;
+            if (s > 1000000) {
+                s = s - 1000000;
+            }
+            i -= 3;
+        }
+        print(s);
+    )" },
+};
+
+// Runs program, returns iterations per second, its output is written to result
+template <typename run_type>
+double measure(const loop_benchmark &benchmark, run_type run, std::string &result) {
+    std::stringstream output;
+    std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(old_cout);
+    result = output.str();
+
+    std::chrono::duration<double> elapsed = end - start;
+    return static_cast<double>(benchmark.iterations) / elapsed.count();
+}
+
+double measure_engine(const loop_benchmark &benchmark, bool unroll, bool closures, std::string &result) {
+    std::string program = benchmark.program;
+
+    paracl::ast ast(paracl::tokenize(program));
+    if (unroll)
+        paracl::unroll_loops(ast);
+
+    if (!closures)
+        return measure(benchmark, [&] { ast.run(); }, result);
+
+    paracl::closure compiled = paracl::compile_scope(ast.get_scope(), ast.get_context());
+    return measure(benchmark, [&] { compiled(); }, result);
+}
+
+} // end anonymous namespace
+
+
+int main() {
+    std::cout << std::left << std::setw(16) << "loop" << std::setw(10) << "engine"
+              << std::right << std::setw(14) << "before, it/s" << std::setw(14) << "after, it/s"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (const loop_benchmark &benchmark: benchmarks) {
+        for (bool closures: { false, true }) {
+            std::string before_output, after_output;
+
+            double before = measure_engine(benchmark, false, closures, before_output);
+            double after  = measure_engine(benchmark, true,  closures, after_output);
+
+            if (before_output != after_output) {
+                std::cerr << benchmark.name << ": unrolled loop prints different result\n";
+                return 1;
+            }
+
+            std::cout << std::left << std::setw(16) << benchmark.name
+                      << std::setw(10) << (closures ? "closures" : "tree") << std::right
+                      << std::setw(14) << std::scientific << std::setprecision(3) << before
+                      << std::setw(14) << after
+                      << std::setw(9) << std::fixed << std::setprecision(2) << after / before << "x\n";
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/flat.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+// Straight line code, so that every node is evaluated exactly once per run.
+// Values stay small, each assignment takes a fraction of previous ones.
+std::string generate_program(size_t statements) {
+    std::string program;
+
+    for (size_t i = 0; i < statements; ++ i) {
+        std::string a = "a" + std::to_string(i % 97);
+        std::string b = "b" + std::to_string(i % 89);
+        std::string c = "c" + std::to_string(i % 83);
+
+        program += a + " = (" + b + " + " + c + " * 3) / 7 - (" + b + " < " + c + ") + " + std::to_string(i % 1000) + ";\n";
+    }
+
+    return program;
+}
+
+size_t count_nodes(const paracl::node &tree) {
+    using namespace paracl;
+
+    switch (tree.get_kind()) {
+    case node_kind::FUNCTION: {
+        size_t count = 1;
+        for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+            count += count_nodes(*arg);
+        return count;
+    }
+
+    case node_kind::NEGATE:
+        return 1 + count_nodes(static_cast<const negate_node&>(tree).get_child());
+
+    case node_kind::NUMBER:
+    case node_kind::ID:
+    case node_kind::SCAN:
+        return 1;
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return 1 + count_nodes(binary.get_left()) + count_nodes(binary.get_right());
+    }
+    }
+}
+
+template <typename action_type>
+double measure_seconds(action_type action) {
+    auto start = std::chrono::steady_clock::now();
+    action();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+} // end anonymous namespace
+
+
+// Program size is given in statements, each one is 15 nodes of pointer tree
+int main(int argc, const char *argv[]) {
+    size_t statements = argc > 1 ? std::stoul(argv[1]) : 67'000;
+    size_t runs = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    std::string program = generate_program(statements);
+    paracl::ast ast(paracl::tokenize(program));
+
+    size_t nodes = 0;
+    for (const auto &statement: ast.get_scope())
+        nodes += count_nodes(*statement);
+
+    paracl::flat_ast flat(ast.get_scope(), ast.get_context());
+
+    // Pointer tree takes everything it allocated from the arena:
+    double tree_bytes = static_cast<double>(ast.get_arena().get_allocated());
+    double flat_bytes = static_cast<double>(flat.get_byte_count());
+
+    double tree_time = measure_seconds([&] {
+        for (size_t i = 0; i < runs; ++ i)
+            ast.run();
+    });
+
+    double flat_time = measure_seconds([&] {
+        for (size_t i = 0; i < runs; ++ i)
+            flat.run(ast.get_context());
+    });
+
+    // Both count nodes of the program, flat tree doesn't need nodes for assigned variables
+    double evaluated = static_cast<double>(nodes * runs);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "nodes:             " << nodes << " (" << flat.get_node_count() << " flat)\n"
+              << "pointer tree:      " << tree_bytes / static_cast<double>(nodes) << " bytes/node, "
+                                       << evaluated / tree_time / 1e6 << " M nodes/s\n"
+              << "flat tree:         " << flat_bytes / static_cast<double>(nodes) << " bytes/node, "
+                                       << evaluated / flat_time / 1e6 << " M nodes/s\n";
+}
@@ -0,0 +1,92 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+
+
+namespace {
+
+// Generated program, like the ones other tools produce: lots of short
+// statements over a small set of variables, with ifs and loops in between
+std::string generate_program(size_t blocks) {
+    std::string program;
+
+    for (size_t i = 0; i < blocks; ++ i) {
+        std::string a = "a" + std::to_string(i % 97);
+        std::string b = "b" + std::to_string(i % 89);
+        std::string c = "c" + std::to_string(i % 83);
+
+        program += a + " = " + b + " * (" + c + " + " + std::to_string(i) + ") - " + b + " / 7;\n";
+        program += "if (" + a + " > " + c + ") {\n";
+        program += "    " + b + " += 1;\n";
+        program += "    print(" + a + " + -" + c + ");\n";
+        program += "}\n";
+        program += "while (" + c + " < 10) {\n";
+        program += "    " + c + " = " + c + " + 1;\n";
+        program += "}\n";
+    }
+
+    return program;
+}
+
+// Peak resident set size of the process, in MiB
+double get_peak_rss() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024;
+}
+
+// Resident set size of the process right now, in MiB
+double get_current_rss() {
+    std::ifstream statm("/proc/self/statm");
+
+    size_t size = 0, resident = 0;
+    statm >> size >> resident;
+
+    return static_cast<double>(resident * sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+}
+
+template <typename action_type>
+double measure_ms(action_type action) {
+    auto start = std::chrono::steady_clock::now();
+    action();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // end anonymous namespace
+
+
+// Peak memory can only grow, so every run measures a single program size,
+// given in blocks of 8 lines
+int main(int argc, const char *argv[]) {
+    size_t blocks = argc > 1 ? std::stoul(argv[1]) : 100'000;
+
+    std::string program = generate_program(blocks);
+    std::vector<paracl::token> tokens = paracl::tokenize(program);
+
+    // Tokens are kept alive, so the difference is what the tree itself takes:
+    double before_parse = get_current_rss();
+
+    std::optional<paracl::ast> ast;
+    double parse = measure_ms([&] { ast.emplace(tokens); });
+    double tree = get_current_rss() - before_parse;
+
+    double teardown = measure_ms([&] { ast.reset(); });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "program:        " << static_cast<double>(program.size()) / (1024 * 1024) << " MiB\n"
+              << "parse:          " << parse << " ms\n"
+              << "teardown:       " << teardown << " ms\n"
+              << "tree rss:       " << tree << " MiB\n"
+              << "peak rss:       " << get_peak_rss() << " MiB\n";
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+
+namespace paracl {
+
+// Monotonic allocator for trees: memory is bumped out of big blocks, freeing
+// it one piece at a time does nothing, and all blocks are freed at once with
+// the arena. Nodes and child lists are taken from the arena that is current
+// (see arena::scope), and from the heap when there is none, so code that
+// makes nodes doesn't have to know where they go.
+class arena {
+public:
+    arena() = default;
+
+    // Nodes point into blocks and current arena is kept by address, so it stays put
+    arena(const arena&) = delete;
+    arena &operator=(const arena&) = delete;
+
+    // Makes arena current while it lives, previous one is restored after
+    class scope {
+    public:
+        explicit scope(arena &current):
+            previous_(current_) {
+            current_ = &current;
+        }
+
+        scope(const scope&) = delete;
+        scope &operator=(const scope&) = delete;
+
+        ~scope() {
+            current_ = previous_;
+        }
+
+    private:
+        arena *previous_;
+    };
+
+    // Nodes hold nothing wider than pointers, so pieces aren't aligned any further
+    static constexpr size_t alignment = alignof(void*);
+
+    static arena *get_current() {
+        return current_;
+    }
+
+    // Every piece starts with a header that says where it came from, so it
+    // can be freed without knowing which arena, if any, it belongs to
+    void *allocate(size_t size) {
+        size_t total = sizeof(header) + align_up(size);
+        if (total > left_)
+            add_block(total);
+
+        header *piece = ::new (next_) header{ true };
+        next_ += total;
+        left_ -= total;
+
+        allocated_ += total;
+        return piece + 1;
+    }
+
+    static void *allocate_current(size_t size) {
+        if (current_)
+            return current_->allocate(size);
+
+        header *piece = ::new (::operator new(sizeof(header) + size)) header{ false };
+        return piece + 1;
+    }
+
+    static void deallocate(void *pointer) {
+        if (!pointer)
+            return;
+
+        header *piece = static_cast<header*>(pointer) - 1;
+        if (!piece->from_arena)
+            ::operator delete(piece);
+    }
+
+    // Bytes given out, including dead pieces and headers
+    size_t get_allocated() const {
+        return allocated_;
+    }
+
+    size_t get_block_count() const {
+        return blocks_.size();
+    }
+
+private:
+    struct alignas(alignment) header {
+        bool from_arena;
+    };
+
+    static constexpr size_t first_block_size = 64 * 1024;
+    static constexpr size_t max_block_size = 4 * 1024 * 1024;
+
+    static inline thread_local arena *current_ = nullptr;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte *next_ = nullptr;
+    size_t left_ = 0;
+
+    size_t next_block_size_ = first_block_size;
+    size_t allocated_ = 0;
+
+    static size_t align_up(size_t size) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // Blocks grow until they are big enough to make allocating them rare
+    void add_block(size_t at_least) {
+        size_t size = std::max(next_block_size_, at_least);
+        next_block_size_ = std::min(next_block_size_ * 2, max_block_size);
+
+        blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+        next_ = blocks_.back().get();
+        left_ = size;
+    }
+};
+
+// Standard allocator over the current arena, for containers inside of trees
+template <typename type>
+struct arena_allocator {
+    using value_type = type;
+
+    static_assert(alignof(type) <= arena::alignment, "arena can't align type");
+
+    arena_allocator() = default;
+
+    template <typename other_type>
+    arena_allocator(const arena_allocator<other_type>&) {}
+
+    type *allocate(size_t count) {
+        return static_cast<type*>(arena::allocate_current(count * sizeof(type)));
+    }
+
+    void deallocate(type *pointer, [[maybe_unused]] size_t count) {
+        arena::deallocate(pointer);
+    }
+
+    bool operator==(const arena_allocator&) const = default;
+};
+
+} // end namespace paracl
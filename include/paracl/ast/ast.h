@@ -1,6 +1,7 @@
 #pragma once
 
 #include "paracl/parser/parser.h"
+#include "paracl/ast/source.h"
 
 #include <memory>
 #include <unordered_map>
@@ -11,7 +12,9 @@ namespace paracl {
 class ast {
 public:
     ast(std::vector<token> tokens) {
-        parser ast_parser{tokens, context_};
+        arena::scope in_arena{arena_};
+
+        parser ast_parser{std::move(tokens), context_};
         scope_ = ast_parser.parse();
     }
 
@@ -30,6 +33,12 @@ public:
         ostr << ")";
     }
 
+    // Program as ParaCL code, see source.h
+    void dump_source(std::ostream &ostr = std::cout) const {
+        source_writer writer{ostr};
+        writer.write(scope_);
+    }
+
     void dump_gv(std::ostream &ostr = std::cout) const {
         graphviz graph{};
 
@@ -41,8 +50,31 @@ public:
         graph.print(ostr);
     }
 
+    const node_list &get_scope() const {
+        return scope_;
+    }
+
+    node_list &get_scope() {
+        return scope_;
+    }
+
+    const context &get_context() const {
+        return context_;
+    }
+
+    context &get_context() {
+        return context_;
+    }
+
+    // Make it current to put new nodes next to the parsed ones, see arena.h
+    arena &get_arena() {
+        return arena_;
+    }
+
 private:
-    std::vector<std::unique_ptr<node>> scope_{};
+    // Nodes are destroyed before the memory they are in:
+    arena arena_{};
+    node_list scope_{};
     context context_{};
 };
 
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "paracl/ast/fused_nodes.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+namespace paracl {
+
+// Number of iterations of `while (i cmp bound) { i += step; }`, or nothing
+// if loop doesn't stop before i overflows. Comparison has i on the left.
+inline std::optional<uint64_t> get_trip_count(node_kind comparison, int64_t start,
+                                              int64_t bound, int64_t step) {
+    using wide = __int128;
+
+    wide count = 0;
+    switch (comparison) {
+    case node_kind::LESS:
+        if (start >= bound)
+            return 0;
+        if (step <= 0)
+            return std::nullopt;
+
+        count = (wide{bound} - start + step - 1) / step;
+        break;
+
+    case node_kind::LESS_OR_EQUAL:
+        if (start > bound)
+            return 0;
+        if (step <= 0)
+            return std::nullopt;
+
+        count = (wide{bound} - start) / step + 1;
+        break;
+
+    case node_kind::BIGGER:
+        if (start <= bound)
+            return 0;
+        if (step >= 0)
+            return std::nullopt;
+
+        count = (wide{start} - bound - step - 1) / -wide{step};
+        break;
+
+    case node_kind::BIGGER_OR_EQUAL:
+        if (start < bound)
+            return 0;
+        if (step >= 0)
+            return std::nullopt;
+
+        count = (wide{start} - bound) / -wide{step} + 1;
+        break;
+
+    default:
+        return std::nullopt;
+    }
+
+    wide end = start + count * step;
+    if (end < std::numeric_limits<int64_t>::min() || end > std::numeric_limits<int64_t>::max())
+        return std::nullopt;
+
+    return static_cast<uint64_t>(count);
+}
+
+// Counting loop that only adds values, linear in its counter, to other variables:
+//
+//     while (i < n) {
+//         s += i * 2 + 1;
+//         i += 1;
+//     }
+//
+// Sums are computed with closed formulas in the same wrapping arithmetic loop would
+// use, so variables end up with exactly the same values. If counter would overflow,
+// original loop is run instead.
+class closed_form_loop_node final: public fused_node {
+public:
+    struct accumulation {
+        size_t slot;
+        bool is_subtracted;
+
+        // Linear in counter, reads nothing else that loop writes
+        node *value;
+
+        // Whether it's done after counter's increment
+        bool is_after_step;
+    };
+
+    explicit closed_form_loop_node(std::unique_ptr<node> loop, size_t counter, int64_t step,
+                                   std::vector<accumulation> accumulations):
+        fused_node(std::move(loop), node_kind::CLOSED_FORM),
+        counter_(counter), step_(step), accumulations_(std::move(accumulations)) {
+        auto &condition = static_cast<binary_node&>(*static_cast<while_node&>(*original_).get_condition());
+
+        comparison_ = condition.get_kind();
+        bound_ = condition.get_right().get();
+    }
+
+    size_t get_counter() const {
+        return counter_;
+    }
+
+    int64_t get_step() const {
+        return step_;
+    }
+
+    const std::vector<accumulation> &get_accumulations() const {
+        return accumulations_;
+    }
+
+    int64_t execute(context &ctx) override {
+        return run(ctx);
+    }
+
+    closure compile(context &ctx) const override {
+        return [this, &ctx] { return run(ctx); };
+    }
+
+private:
+    size_t counter_;
+    int64_t step_;
+    std::vector<accumulation> accumulations_;
+
+    // Loop's condition is `counter comparison bound`
+    node_kind comparison_;
+    node *bound_;
+
+    // Value of counter-linear expression at the given counter value
+    int64_t evaluate(node &value, context &ctx, int64_t counter) const {
+        int64_t *variable = ctx.get_variable(counter_);
+        int64_t saved = *variable;
+
+        *variable = counter;
+        int64_t result = value.execute(ctx);
+
+        *variable = saved;
+        return result;
+    }
+
+    int64_t run(context &ctx) const {
+        int64_t start = *ctx.get_variable(counter_);
+        int64_t bound = bound_->execute(ctx);
+
+        std::optional<uint64_t> count = get_trip_count(comparison_, start, bound, step_);
+        if (!count)
+            return original_->execute(ctx);
+
+        if (*count == 0)
+            return 1;
+
+        uint64_t n = *count;
+        uint64_t step = static_cast<uint64_t>(step_);
+
+        // n * (n - 1) / 2, divided before multiplying, so it doesn't lose the top bit
+        uint64_t triangle = n % 2 == 0 ? n / 2 * (n - 1) : (n - 1) / 2 * n;
+
+        for (const accumulation &added: accumulations_) {
+            uint64_t at_zero = static_cast<uint64_t>(evaluate(*added.value, ctx, 0));
+            uint64_t slope   = static_cast<uint64_t>(evaluate(*added.value, ctx, 1)) - at_zero;
+
+            uint64_t first = static_cast<uint64_t>(start) + (added.is_after_step ? step : 0);
+
+            // Sum of (at_zero + slope * (first + step * j)) for j in [0, n)
+            uint64_t counters = n * first + step * triangle;
+            uint64_t sum = n * at_zero + slope * counters;
+
+            int64_t *accumulator = ctx.get_variable(added.slot);
+            uint64_t value = static_cast<uint64_t>(*accumulator);
+            *accumulator = static_cast<int64_t>(added.is_subtracted ? value - sum : value + sum);
+        }
+
+        *ctx.get_variable(counter_) = static_cast<int64_t>(static_cast<uint64_t>(start) + n * step);
+        return 1;
+    }
+};
+
+} // end namespace paracl
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "paracl/ast/context.h"
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace paracl {
+
+// Node compiled into a directly callable function. Variables are resolved into
+// pointers to context's values when closure is built, instead of every time
+// they are read.
+//
+// Pointers stay valid only while no variables are added to the context.
+using closure = std::function<int64_t()>;
+
+// Leaves are captured by closures of their parents directly, so
+// reading a constant or a variable doesn't need a call at all:
+struct closure_operand {
+    enum operand_kind {
+        CONSTANT,
+        VARIABLE,
+        COMPUTED,
+    };
+
+    operand_kind kind;
+
+    int64_t constant = 0;
+    int64_t *variable = nullptr;
+    closure computed = {};
+};
+
+struct checked_divides {
+    int64_t operator()(int64_t lhs, int64_t rhs) const {
+        if (rhs == 0)
+            throw std::runtime_error("divide by zero");
+
+        return lhs / rhs;
+    }
+};
+
+// Plain assignment, value of the variable is just replaced
+struct assigns {
+    int64_t operator()([[maybe_unused]] int64_t lhs, int64_t rhs) const {
+        return rhs;
+    }
+};
+
+// Calls action with a callable that produces operand's value, specialized on operand's kind
+template <typename action_type>
+closure with_operand(closure_operand operand, action_type action) {
+    switch (operand.kind) {
+    case closure_operand::CONSTANT:
+        return action([value = operand.constant] { return value; });
+
+    case closure_operand::VARIABLE:
+        return action([variable = operand.variable] { return *variable; });
+
+    case closure_operand::COMPUTED:
+        break;
+    }
+
+    return action([computed = std::move(operand.computed)] { return computed(); });
+}
+
+template <typename op>
+closure make_binary_closure(closure_operand left, closure_operand right) {
+    return with_operand(std::move(left), [&](auto lhs) {
+        return with_operand(std::move(right), [&](auto rhs) -> closure {
+            return [lhs, rhs] {
+                int64_t left_value = lhs();
+                return static_cast<int64_t>(op{}(left_value, rhs()));
+            };
+        });
+    });
+}
+
+template <typename op>
+closure make_unary_closure(closure_operand operand) {
+    return with_operand(std::move(operand), [](auto value) -> closure {
+        return [value] {
+            return static_cast<int64_t>(op{}(value()));
+        };
+    });
+}
+
+// Compound assignment, operation takes current value of the variable and assigned value
+template <typename op>
+closure make_assign_closure(int64_t *target, closure_operand right) {
+    return with_operand(std::move(right), [target](auto rhs) -> closure {
+        return [target, rhs] {
+            int64_t value = rhs();
+            *target = op{}(*target, value);
+            return int64_t{1};
+        };
+    });
+}
+
+template <typename scope_type>
+closure compile_scope(const scope_type &scope, context &ctx) {
+    std::vector<closure> statements;
+    for (const auto &statement: scope)
+        statements.push_back(statement->compile(ctx));
+
+    return [statements = std::move(statements)] {
+        for (const auto &statement: statements)
+            statement();
+
+        return int64_t{1};
+    };
+}
+
+} // end namespace paracl
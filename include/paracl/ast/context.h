@@ -1,33 +1,159 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 
 namespace paracl {
 
+// Variables are resolved to dense slots when program is parsed, so at runtime
+// context is just a flat array of values. Names are kept only for diagnostics.
+//
+// Name is visible in the scope it's created in and in scopes nested into it,
+// so variables of sibling blocks are different even if they have same names.
+// After parsing only names of the outermost scope are left visible.
 class context {
 public:
-    void create_variable(const std::string &name) {
-        variables_[name] = 0;
+    size_t create_variable(const std::string &name) {
+        auto [it, inserted] = slots_.try_emplace(name, variables_.size());
+        if (inserted) {
+            variables_.push_back(0);
+            names_.push_back({name});
+        }
+
+        return it->second;
+    }
+
+    void enter_scope() {
+        scopes_.push_back(variables_.size());
+    }
+
+    // Names created in the scope are hidden, their slots stay
+    void leave_scope() {
+        for (size_t slot = scopes_.back(); slot < variables_.size(); ++ slot) {
+            auto it = slots_.find(names_[slot].front());
+            if (it != slots_.end() && it->second == slot)
+                slots_.erase(it);
+        }
+
+        scopes_.pop_back();
+    }
+
+    bool check_var_existing(const std::string &name) const {
+        return slots_.find(name) != slots_.end();
+    }
+
+    std::optional<size_t> find_variable(const std::string &name) const {
+        auto it = slots_.find(name);
+        if (it == slots_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    int64_t *get_variable(size_t slot) {
+        return &variables_[slot];
+    }
+
+    // Name of the first variable in the slot
+    const std::string &get_name(size_t slot) const {
+        return names_[slot].front();
+    }
+
+    // Whether the slot is used by a variable with this name, see share
+    bool has_name(size_t slot, const std::string &name) const {
+        return std::find(names_[slot].begin(), names_[slot].end(), name) != names_[slot].end();
     }
 
-    bool check_var_existing(std::string &name) {
-        if (variables_.find(name) != variables_.end()) {
-            return true;
+    size_t get_variable_count() const {
+        return variables_.size();
+    }
+
+    int64_t *get_variables() {
+        return variables_.data();
+    }
+
+    // Drops variables that aren't used, the rest keep their order but move to
+    // lower slots. Returns new slot for every old one that is still used.
+    std::vector<size_t> compact(const std::vector<bool> &used) {
+        std::vector<size_t> remap(variables_.size());
+        size_t kept = 0;
+
+        for (size_t slot = 0; slot < variables_.size(); ++ slot) {
+            if (!used[slot])
+                continue;
+
+            if (kept != slot) {
+                variables_[kept] = variables_[slot];
+                names_[kept] = std::move(names_[slot]);
+            }
+
+            remap[slot] = kept ++;
         }
-        return false;
+
+        variables_.resize(kept);
+        names_.resize(kept);
+
+        move_visible([&](size_t slot) -> std::optional<size_t> {
+            if (!used[slot])
+                return std::nullopt;
+            return remap[slot];
+        });
+        return remap;
     }
 
-    int64_t *get_variable(std::string &name) {
-        if (variables_.find(name) == variables_.end()) {
-            //обработка
+    // Moves every variable to the given slot, variables whose lifetimes don't
+    // overlap may get the same one. It's done before the program runs, so values
+    // are the initial ones and the first variable's value is kept. Variables
+    // without a new slot are dropped.
+    void share(const std::vector<std::optional<size_t>> &storage, size_t count) {
+        std::vector<int64_t> variables(count, 0);
+        std::vector<std::vector<std::string>> names(count);
+
+        for (size_t slot = 0; slot < variables_.size(); ++ slot) {
+            if (!storage[slot])
+                continue;
+
+            auto &shared = names[*storage[slot]];
+            if (shared.empty())
+                variables[*storage[slot]] = variables_[slot];
+
+            for (auto &name: names_[slot])
+                shared.push_back(std::move(name));
         }
-        return &(variables_[name]);
+
+        variables_ = std::move(variables);
+        names_ = std::move(names);
+
+        move_visible([&](size_t slot) {
+            return storage[slot];
+        });
     }
 
 private:
-    std::unordered_map<std::string, int64_t> variables_{};
+    std::vector<int64_t> variables_{};
+
+    std::vector<std::vector<std::string>> names_{};
+    std::unordered_map<std::string, size_t> slots_{};
+
+    // Number of variables when each of the open scopes was entered
+    std::vector<size_t> scopes_{};
+
+    template <typename remap_type>
+    void move_visible(remap_type remap) {
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            if (std::optional<size_t> slot = remap(it->second)) {
+                it->second = *slot;
+                ++ it;
+            } else {
+                it = slots_.erase(it);
+            }
+        }
+    }
 };
 
-} // end namespace paracl
\ No newline at end of file
+} // end namespace paracl
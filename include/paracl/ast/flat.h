@@ -0,0 +1,138 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ast/context.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace paracl {
+
+// Same tree as nodes.h, but stored as a struct of arrays: node is just an
+// index, its kind and two operands live in contiguous arrays, children are
+// 32-bit indices instead of pointers. Operands of every kind:
+//
+//   NUMBER              first, second  low and high halves of the value
+//   ID                  first          slot of the variable
+//   FUNCTION            first, second  name in functions, list of arguments
+//   NEGATE              first          child
+//   binary operations   first, second  left and right children
+//   assignments         first, second  slot of the variable and right child
+//   IF, WHILE           first, second  condition and list of statements
+//
+// Lists are stored in one shared array as a length followed by node indices.
+// Divisions that are proven not to be zero, see optimizer/ranges.h, have kinds
+// of their own, so evaluator doesn't need to look anywhere but kinds.
+class flat_ast {
+public:
+    using index = uint32_t;
+
+    enum class kind: uint8_t {
+        NUMBER,
+        ID,
+        FUNCTION,
+
+        ASSIGN,
+        PLUS_ASSIGN,
+        MINUS_ASSIGN,
+        MULTIPLY_ASSIGN,
+        DIVIDE_ASSIGN,
+        DIVIDE_ASSIGN_UNCHECKED,
+
+        NEGATE,
+
+        PLUS,
+        MINUS,
+        MULTIPLY,
+        DIVIDE,
+        DIVIDE_UNCHECKED,
+        EQUAL,
+        LESS,
+        BIGGER,
+        LESS_OR_EQUAL,
+        BIGGER_OR_EQUAL,
+
+        IF,
+        WHILE,
+
+        SCAN
+    };
+
+    // Fused and closed form nodes are flattened as their originals
+    flat_ast(const node_list &scope, const context &ctx);
+
+    void run(context &ctx) const;
+
+    // Same output as ast::dump and ast::dump_gv for the tree it was made from
+    void dump(std::ostream &ostr = std::cout) const;
+    void dump_gv(std::ostream &ostr = std::cout) const;
+
+    size_t get_node_count() const {
+        return kinds_.size();
+    }
+
+    // Bytes that arrays of the tree take, not counting names
+    size_t get_byte_count() const {
+        return kinds_.capacity() * sizeof(kind) + first_.capacity() * sizeof(index) +
+               second_.capacity() * sizeof(index) + lists_.capacity() * sizeof(index);
+    }
+
+    kind get_kind(index node) const {
+        return kinds_[node];
+    }
+
+    index get_first(index node) const {
+        return first_[node];
+    }
+
+    index get_second(index node) const {
+        return second_[node];
+    }
+
+    int64_t get_number(index node) const {
+        return static_cast<int64_t>(static_cast<uint64_t>(second_[node]) << 32 | first_[node]);
+    }
+
+    // Length of list and its elements, list is given by its offset:
+    index get_list_size(index list) const {
+        return lists_[list];
+    }
+
+    const index *get_list(index list) const {
+        return lists_.data() + list + 1;
+    }
+
+    index get_program() const {
+        return program_;
+    }
+
+private:
+    std::vector<kind> kinds_;
+    std::vector<index> first_;
+    std::vector<index> second_;
+
+    std::vector<index> lists_;
+
+    // Top level statements, it's a list too
+    index program_ = 0;
+
+    // Names of variables by slots and names of called functions, only for dumps
+    std::vector<std::string> variables_;
+    std::vector<std::string> functions_;
+
+    index add_node(kind node_kind, index first = 0, index second = 0);
+
+    index flatten(const node &tree);
+    index flatten_list(const node_list &list);
+
+    int64_t evaluate(index node, int64_t *variables) const;
+    void execute_list(index list, int64_t *variables) const;
+
+    void dump(index node, std::ostream &ostr) const;
+    void dump_gv(index node, graphviz &graph, node_proxy &parent) const;
+};
+
+} // end namespace paracl
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+
+#include <memory>
+#include <vector>
+
+
+namespace paracl {
+
+// Common idiom replaced by a node that runs it in a single call. Original
+// subtree is kept: it's what gets dumped, and engines that compile the tree
+// on their own look through fused nodes with get_unfused.
+//
+// Fused node caches parts of the original, so original must not be changed.
+class fused_node: public node {
+public:
+    explicit fused_node(std::unique_ptr<node> original, node_kind kind = node_kind::FUSED):
+        node(kind), original_(std::move(original)) {}
+
+    const node &get_original() const {
+        return *original_;
+    }
+
+    node &get_original() {
+        return *original_;
+    }
+
+    closure compile(context &ctx) const override {
+        return original_->compile(ctx);
+    }
+
+    void dump(std::ostream &ostr) const override {
+        original_->dump(ostr);
+    }
+
+    void dump_gv(graphviz &graph, node_proxy& parent) const override {
+        original_->dump_gv(graph, parent);
+    }
+
+protected:
+    std::unique_ptr<node> original_;
+};
+
+inline const node &get_unfused(const node &tree) {
+    if (!is_replacement(tree.get_kind()))
+        return tree;
+
+    return static_cast<const fused_node&>(tree).get_original();
+}
+
+inline node &get_unfused(node &tree) {
+    if (!is_replacement(tree.get_kind()))
+        return tree;
+
+    return static_cast<fused_node&>(tree).get_original();
+}
+
+
+// Right operands of fused nodes, left operand is always a variable:
+
+struct constant_operand {
+    explicit constant_operand(const node &leaf):
+        value(static_cast<const number_node&>(leaf).get_number()) {}
+
+    int64_t load([[maybe_unused]] context &ctx) const {
+        return value;
+    }
+
+    int64_t value;
+};
+
+struct variable_operand {
+    explicit variable_operand(const node &leaf):
+        slot(static_cast<const id_node&>(leaf).get_slot()) {}
+
+    int64_t load(context &ctx) const {
+        return *ctx.get_variable(slot);
+    }
+
+    size_t slot;
+};
+
+inline size_t get_variable_slot(const node &operation) {
+    const auto &binary = static_cast<const binary_node&>(operation);
+    return static_cast<const id_node&>(binary.get_left()).get_slot();
+}
+
+inline const node &get_right_operand(const node &operation) {
+    return static_cast<const binary_node&>(operation).get_right();
+}
+
+
+// x op= y, x op= 42
+template <typename operation, typename right_type>
+class fused_assign_node final: public fused_node {
+public:
+    explicit fused_assign_node(std::unique_ptr<node> assignment):
+        fused_node(std::move(assignment)),
+        slot_(get_variable_slot(*original_)), right_(get_right_operand(*original_)) {}
+
+    int64_t execute(context &ctx) override {
+        int64_t *variable = ctx.get_variable(slot_);
+        *variable = operation{}(*variable, right_.load(ctx));
+        return 1;
+    }
+
+private:
+    size_t slot_;
+    right_type right_;
+};
+
+// x + y, x * 42
+template <typename operation, typename right_type>
+class fused_operator_node final: public fused_node {
+public:
+    explicit fused_operator_node(std::unique_ptr<node> operator_node):
+        fused_node(std::move(operator_node)),
+        slot_(get_variable_slot(*original_)), right_(get_right_operand(*original_)) {}
+
+    int64_t execute(context &ctx) override {
+        return operation{}(*ctx.get_variable(slot_), right_.load(ctx));
+    }
+
+private:
+    size_t slot_;
+    right_type right_;
+};
+
+// while (a <= b) { ... }, if (x == 42) { ... }
+template <bool is_loop, typename operation, typename right_type>
+class fused_conditional_node final: public fused_node {
+public:
+    explicit fused_conditional_node(std::unique_ptr<node> conditional):
+        fused_node(std::move(conditional)),
+        slot_(get_variable_slot(get_condition())), right_(get_right_operand(get_condition())),
+        scope_(static_cast<const conditional_operation_node<is_loop>&>(*original_).get_scope()) {}
+
+    int64_t execute(context &ctx) override {
+        const int64_t *variable = ctx.get_variable(slot_);
+
+        while (operation{}(*variable, right_.load(ctx)) != 0) {
+            for (const auto& i: scope_) {
+                i->execute(ctx);
+            }
+            if constexpr (!is_loop) {
+                break;
+            }
+        }
+        return 1;
+    }
+
+private:
+    size_t slot_;
+    right_type right_;
+    const node_list &scope_;
+
+    const node &get_condition() const {
+        return static_cast<const conditional_operation_node<is_loop>&>(*original_).get_condition();
+    }
+};
+
+template <typename operation, typename right_type>
+using fused_if_node = fused_conditional_node<false, operation, right_type>;
+
+template <typename operation, typename right_type>
+using fused_while_node = fused_conditional_node<true, operation, right_type>;
+
+} // end namespace paracl
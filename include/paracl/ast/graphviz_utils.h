@@ -31,6 +31,10 @@ static inline graphviz_formatting scan                       = {graphviz_color::
                                                                 graphviz_style::FILLED,
                                                                 graphviz_shape::RECORD};
 
+static inline graphviz_formatting basic_block                = {graphviz_color::ANI_PALE_SAND,
+                                                                graphviz_style::FILLED,
+                                                                graphviz_shape::RECORD};
+
 static inline graphviz_formatting default_edge = {};
 
 }  // end namespace graphviz_formatter
@@ -0,0 +1,332 @@
+#pragma once
+
+#include "paracl/ast/output.h"
+
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+namespace paracl {
+
+// Where scan reads from. Numbers are whitespace separated decimals with an
+// optional sign, anything else is reported with its offset from the start of
+// the input. Input from a descriptor is read in large blocks, input that is
+// already in memory, like a mapped file, is parsed in place. Eight digits at
+// a time are checked and converted with plain 64-bit arithmetic.
+class input_source {
+public:
+    static constexpr size_t buffer_size = 64 * 1024;
+
+    // Reads std::cin one number at a time, prompting before each of them
+    input_source() = default;
+
+    input_source(const input_source &other) = delete;
+    input_source &operator=(const input_source &other) = delete;
+
+    // Nothing past the number is taken from the stream, so it can be shared
+    void read_from(std::istream &stream, bool prompt) {
+        reset(target_kind::STREAM);
+        stream_ = &stream;
+        prompt_ = prompt;
+    }
+
+    // Prompts are shown only if it's a terminal
+    void read_from(int fd) {
+        reset(target_kind::DESCRIPTOR);
+        fd_ = fd;
+#ifdef _WIN32
+        prompt_ = _isatty(fd) != 0;
+#else
+        prompt_ = isatty(fd) != 0;
+#endif
+
+        if (!storage_)
+            storage_ = std::make_unique<char[]>(buffer_size);
+
+        begin_ = position_ = end_ = storage_.get();
+    }
+
+    // Whole input, it has to outlive reading
+    void read_from(std::string_view text) {
+        reset(target_kind::MEMORY);
+        begin_ = position_ = text.data();
+        end_ = text.data() + text.size();
+        is_finished_ = true;
+    }
+
+    // Numbers that are read before the target, without prompts. They are
+    // dropped when the target is changed, so it has to be set first.
+    void read_first(std::span<const int64_t> numbers) {
+        first_.assign(numbers.begin(), numbers.end());
+        next_first_ = 0;
+    }
+
+    int64_t read_number() {
+        if (next_first_ != first_.size())
+            return first_[next_first_ ++];
+
+        if (prompt_)
+            get_output().prompt("Input: ");
+
+        if (target_ == target_kind::STREAM)
+            return read_from_stream();
+
+        return read_from_buffer();
+    }
+
+    // Number of bytes consumed so far
+    size_t get_offset() const {
+        if (target_ == target_kind::STREAM)
+            return offset_;
+
+        return offset_ + static_cast<size_t>(position_ - begin_);
+    }
+
+private:
+    enum class target_kind {
+        STREAM,
+        DESCRIPTOR,
+        MEMORY,
+    };
+
+    target_kind target_ = target_kind::STREAM;
+    bool prompt_ = true;
+
+    std::istream *stream_ = &std::cin;
+    int fd_ = 0;
+
+    // Bytes in [position_, end_) are read, but not consumed yet. Offset is the
+    // offset of begin_ for buffers and of the next byte for streams.
+    std::unique_ptr<char[]> storage_;
+    const char *begin_ = nullptr;
+    const char *position_ = nullptr;
+    const char *end_ = nullptr;
+    size_t offset_ = 0;
+
+    bool is_finished_ = false;
+
+    std::vector<int64_t> first_;
+    size_t next_first_ = 0;
+
+    void reset(target_kind target) {
+        target_ = target;
+        prompt_ = false;
+        offset_ = 0;
+        is_finished_ = false;
+        first_.clear();
+        next_first_ = 0;
+    }
+
+    static bool is_space(int symbol) {
+        return symbol == ' ' || symbol == '\n' || symbol == '\t' ||
+               symbol == '\r' || symbol == '\v' || symbol == '\f';
+    }
+
+    static bool is_digit(char symbol) {
+        return symbol >= '0' && symbol <= '9';
+    }
+
+    static uint64_t load_eight(const char *bytes) {
+        uint64_t chunk;
+        std::memcpy(&chunk, bytes, sizeof(chunk));
+        return chunk;
+    }
+
+    // Each byte is 0x30..0x39, so its high half is 3 and adding 6 doesn't carry into it
+    static bool are_eight_digits(const char *bytes) {
+        uint64_t chunk = load_eight(bytes);
+        return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+                (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+    }
+
+    // First digit is in the lowest byte, pairs, quads and then the halves are combined
+    static uint64_t parse_eight_digits(const char *bytes) {
+        uint64_t chunk = load_eight(bytes) - 0x3030303030303030;
+
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+                 (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+        return chunk;
+    }
+
+    static constexpr bool has_wide_digits = std::endian::native == std::endian::little;
+
+    [[noreturn]] static void fail(const char *problem, size_t offset) {
+        throw std::runtime_error(std::string(problem) + " at byte " + std::to_string(offset));
+    }
+
+    // Number in the token, which is offset bytes into the input
+    static int64_t parse_number(const char *begin, const char *end, size_t offset) {
+        const char *current = begin;
+
+        bool is_negative = false;
+        if (current != end && (*current == '-' || *current == '+')) {
+            is_negative = *current == '-';
+            ++ current;
+        }
+
+        const char *digits = current;
+        if constexpr (has_wide_digits) {
+            while (end - current >= 8 && are_eight_digits(current))
+                current += 8;
+        }
+
+        while (current != end && is_digit(*current))
+            ++ current;
+
+        if (current == digits || current != end)
+            fail("malformed number", offset + static_cast<size_t>(current - begin));
+
+        while (end - digits > 1 && *digits == '0')
+            ++ digits;
+
+        // Any 19 digits fit, and 20 are already more than the biggest number
+        if (end - digits > 19)
+            fail("number out of range", offset);
+
+        uint64_t value = 0;
+        if constexpr (has_wide_digits) {
+            for (; end - digits >= 8; digits += 8)
+                value = value * 100'000'000 + parse_eight_digits(digits);
+        }
+
+        for (; digits != end; ++ digits)
+            value = value * 10 + static_cast<uint64_t>(*digits - '0');
+
+        constexpr uint64_t biggest = std::numeric_limits<int64_t>::max();
+        if (value > biggest + (is_negative ? 1 : 0))
+            fail("number out of range", offset);
+
+        return is_negative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+    }
+
+    int64_t read_from_stream() {
+        std::streambuf *buffer = stream_->rdbuf();
+
+        int symbol = buffer->sgetc();
+        for (; symbol != std::char_traits<char>::eof() && is_space(symbol); symbol = buffer->snextc())
+            ++ offset_;
+
+        if (symbol == std::char_traits<char>::eof())
+            fail("unexpected end of input", offset_);
+
+        char token[32];
+        size_t length = 0;
+        size_t start = offset_;
+
+        for (; symbol != std::char_traits<char>::eof() && !is_space(symbol); symbol = buffer->snextc()) {
+            if (length == sizeof(token))
+                fail("number out of range", start);
+
+            token[length ++] = static_cast<char>(symbol);
+            ++ offset_;
+        }
+
+        return parse_number(token, token + length, start);
+    }
+
+    int64_t read_from_buffer() {
+        while (position_ != end_ || refill()) {
+            if (!is_space(*position_))
+                break;
+
+            ++ position_;
+        }
+
+        if (position_ == end_)
+            fail("unexpected end of input", get_offset());
+
+        // Token has to be read whole, unless it doesn't fit into the buffer
+        const char *token_end = position_;
+        for (;;) {
+            if constexpr (has_wide_digits) {
+                while (end_ - token_end >= 8 && are_eight_digits(token_end))
+                    token_end += 8;
+            }
+
+            while (token_end != end_ && !is_space(*token_end))
+                ++ token_end;
+
+            if (token_end != end_)
+                break;
+
+            // Refill moves the token even if there is nothing more to read
+            size_t scanned = static_cast<size_t>(token_end - position_);
+            bool is_refilled = refill();
+
+            token_end = position_ + scanned;
+            if (!is_refilled)
+                break;
+        }
+
+        size_t start = get_offset();
+        int64_t value = parse_number(position_, token_end, start);
+
+        position_ = token_end;
+        return value;
+    }
+
+    // Unconsumed bytes are moved to the start of storage and more are read after
+    // them. Returns false if nothing more can be read.
+    bool refill() {
+        if (is_finished_)
+            return false;
+
+        char *storage = storage_.get();
+        size_t kept = static_cast<size_t>(end_ - position_);
+
+        offset_ += static_cast<size_t>(position_ - begin_);
+        std::memmove(storage, position_, kept);
+        begin_ = position_ = storage;
+        end_ = storage + kept;
+
+        if (kept == buffer_size)
+            return false;
+
+        for (;;) {
+#ifdef _WIN32
+            auto count = _read(fd_, storage + kept, static_cast<unsigned>(buffer_size - kept));
+#else
+            auto count = ::read(fd_, storage + kept, buffer_size - kept);
+#endif
+            if (count < 0 && errno == EINTR)
+                continue;
+
+            if (count < 0)
+                throw std::runtime_error("can't read input");
+
+            if (count == 0) {
+                is_finished_ = true;
+                return false;
+            }
+
+            end_ += count;
+            return true;
+        }
+    }
+};
+
+// Source that programs scan from
+inline input_source &get_input() {
+    static input_source input;
+    return input;
+}
+
+} // end namespace paracl
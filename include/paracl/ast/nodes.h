@@ -1,8 +1,12 @@
 #pragma once
 
+#include "paracl/ast/arena.h"
 #include "paracl/ast/context.h"
-#include "paracl/ast/marked_pointers.h"
 #include "paracl/ast/graphviz_utils.h"
+#include "paracl/ast/closures.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+#include "paracl/text/display.h"
 
 #include <iostream>
 #include <memory>
@@ -10,25 +14,130 @@
 #include <string>
 #include <functional>
 #include <iomanip>
+#include <cassert>
+#include <optional>
+#include <type_traits>
 
 
 namespace paracl {
 
+enum class node_kind {
+    NUMBER,
+    ID,
+    FUNCTION,
+
+    ASSIGN,
+    PLUS_ASSIGN,
+    MINUS_ASSIGN,
+    MULTIPLY_ASSIGN,
+    DIVIDE_ASSIGN,
+
+    NEGATE,
+
+    PLUS,
+    MINUS,
+    MULTIPLY,
+    DIVIDE,
+    EQUAL,
+    LESS,
+    BIGGER,
+    LESS_OR_EQUAL,
+    BIGGER_OR_EQUAL,
+
+    IF,
+    WHILE,
+
+    SCAN,
+
+    // Nodes that replace a subtree and keep it as the original, see fused_nodes.h
+    FUSED,
+    CLOSED_FORM
+};
+
+inline bool is_assignment(node_kind kind) {
+    return kind >= node_kind::ASSIGN && kind <= node_kind::DIVIDE_ASSIGN;
+}
+
+inline bool is_arithmetic_or_comparison(node_kind kind) {
+    return kind >= node_kind::PLUS && kind <= node_kind::BIGGER_OR_EQUAL;
+}
+
+inline bool is_replacement(node_kind kind) {
+    return kind == node_kind::FUSED || kind == node_kind::CLOSED_FORM;
+}
+
 class node {
 public:
+    explicit node(node_kind kind):
+        kind_(kind) {}
+
+    // Value of the node, statements return 1 when done
     virtual int64_t execute(context &ctx) = 0;
+
+    // Variable the node refers to, only variables have one, so only they can be assigned
+    virtual int64_t *execute_lvalue([[maybe_unused]] context &ctx) {
+        assert(false && "node is not an lvalue");
+        return nullptr;
+    }
+
     virtual void dump_gv(graphviz &graph, node_proxy& parent) const = 0;
     virtual void dump(std::ostream &ostr) const = 0;
     virtual ~node() = default;
+
+    // Lowers node once into a closure that does the same as execute, but
+    // returns plain values and reads variables through resolved pointers
+    virtual closure compile(context &ctx) const = 0;
+
+    // Kind is stored in the node itself, so that engines walking the tree
+    // can switch over it without paying for a virtual call:
+    node_kind get_kind() const {
+        return kind_;
+    }
+
+    // Part of the source node was parsed from, nodes made up by passes have none.
+    // Statements span up to their last token, if and while span their header.
+    const std::optional<text_range> &get_range() const {
+        return range_;
+    }
+
+    void set_range(std::optional<text_range> range) {
+        range_ = range;
+    }
+
+    // Nodes are taken from the current arena, so whole tree is freed with it
+    static void *operator new(size_t size) {
+        return arena::allocate_current(size);
+    }
+
+    static void operator delete(void *pointer) {
+        arena::deallocate(pointer);
+    }
+
+private:
+    node_kind kind_;
+    std::optional<text_range> range_;
 };
 
+// Statements of a scope or arguments of a call, they live in the arena too
+using node_list = std::vector<std::unique_ptr<node>, arena_allocator<std::unique_ptr<node>>>;
+
+closure_operand compile_operand(const node &operand, context &ctx);
+
 class number_node final: public node {
 public:
     explicit number_node(int64_t value):
-        value_(value) {}
+        node(node_kind::NUMBER), value_(value) {}
+
+    int64_t get_number() const {
+        return value_;
+    }
 
     int64_t execute([[maybe_unused]] context &ctx) override {
-        return create_value(value_);
+        return value_;
+    }
+
+    closure compile([[maybe_unused]] context &ctx) const override {
+        return [value = value_] { return value; };
     }
 
     void dump(std::ostream &ostr) const override {
@@ -47,11 +156,31 @@ private:
 
 class id_node final: public node {
 public:
-    explicit id_node(std::string name):
-        name_(std::move(name)) {}
+    explicit id_node(std::string name, size_t slot):
+        node(node_kind::ID), name_(std::move(name)), slot_(slot) {}
+
+    const std::string &get_name() const {
+        return name_;
+    }
+
+    size_t get_slot() const {
+        return slot_;
+    }
+
+    void set_slot(size_t slot) {
+        slot_ = slot;
+    }
 
     int64_t execute(context &ctx) override {
-        return create_pointer(ctx.get_variable(name_));
+        return *ctx.get_variable(slot_);
+    }
+
+    int64_t *execute_lvalue(context &ctx) override {
+        return ctx.get_variable(slot_);
+    }
+
+    closure compile(context &ctx) const override {
+        return [variable = ctx.get_variable(slot_)] { return *variable; };
     }
 
     void dump(std::ostream &ostr) const override {
@@ -65,29 +194,68 @@ public:
 
 private:
     std::string name_;
+    size_t slot_;
 };
 
 class function_node final: public node {
 public:
-    explicit function_node(std::string name, std::vector<std::unique_ptr<node>> args):
-        name_(std::move(name)), args_(std::move(args)) {}
+    explicit function_node(std::string name, node_list args):
+        node(node_kind::FUNCTION), name_(std::move(name)), args_(std::move(args)) {}
+
+    const std::string &get_name() const {
+        return name_;
+    }
+
+    const node_list &get_args() const {
+        return args_;
+    }
+
+    node_list &get_args() {
+        return args_;
+    }
 
     int64_t execute(context &ctx) override {
         if (name_ == "print") {
+            output_sink &output = get_output();
+
             bool first = true;
             for (const auto& arg : args_) {
                 if (!first) {
-                    std::cout << " ";
+                    output.put(' ');
                 }
-                std::cout << get_value(arg->execute(ctx));
+                output.write_number(arg->execute(ctx));
                 first = false;
             }
-            std::cout << std::endl;
+            output.end_line();
             return 1;
         }        
         return 0; //остальные функции пока не реализованы
     }
 
+    closure compile(context &ctx) const override {
+        if (name_ != "print")
+            return [] { return int64_t{0}; };
+
+        std::vector<closure> args;
+        for (const auto& arg: args_)
+            args.push_back(arg->compile(ctx));
+
+        return [args = std::move(args)] {
+            output_sink &output = get_output();
+
+            bool first = true;
+            for (const auto& arg: args) {
+                if (!first)
+                    output.put(' ');
+
+                output.write_number(arg());
+                first = false;
+            }
+            output.end_line();
+            return int64_t{1};
+        };
+    }
+
     void dump(std::ostream &ostr) const override {
         ostr << name_ << "( ";
         for (const auto& i: args_) {
@@ -108,14 +276,57 @@ public:
 
 private:
     std::string name_;
-    std::vector<std::unique_ptr<node>> args_;
+    node_list args_;
+};
+
+inline closure_operand compile_operand(const node &operand, context &ctx) {
+    switch (operand.get_kind()) {
+    case node_kind::NUMBER:
+        return { .kind = closure_operand::CONSTANT,
+                 .constant = static_cast<const number_node&>(operand).get_number() };
+
+    case node_kind::ID:
+        return { .kind = closure_operand::VARIABLE,
+                 .variable = ctx.get_variable(static_cast<const id_node&>(operand).get_slot()) };
+
+    default:
+        return { .kind = closure_operand::COMPUTED, .computed = operand.compile(ctx) };
+    }
+}
+
+// Common part of assignments and arithmetic/comparative operators, lets
+// code that walks the tree reach operands without knowing the exact operation:
+class binary_node: public node {
+public:
+    explicit binary_node(node_kind kind, std::unique_ptr<node> left, std::unique_ptr<node> right):
+        node(kind), left_(std::move(left)), right_(std::move(right)) {}
+
+    const node &get_left() const {
+        return *left_;
+    }
+
+    const node &get_right() const {
+        return *right_;
+    }
+
+    std::unique_ptr<node> &get_left() {
+        return left_;
+    }
+
+    std::unique_ptr<node> &get_right() {
+        return right_;
+    }
+
+protected:
+    std::unique_ptr<node> left_;
+    std::unique_ptr<node> right_;
 };
 
 template<typename impl_type>
-class assign_operation: public node {
+class assign_operation: public binary_node {
 public:
     explicit assign_operation(std::unique_ptr<node> left, std::unique_ptr<node> right):
-        left_(std::move(left)), right_(std::move(right)) {}
+        binary_node(impl_type::kind, std::move(left), std::move(right)) {}
     virtual ~assign_operation() = default;
 
     const char* get_name() const {
@@ -127,10 +338,15 @@ public:
     }
 
     int64_t execute(context &ctx) override {
-        *get_pointer(left_->execute(ctx)) = assigned_value(ctx);
+        *left_->execute_lvalue(ctx) = assigned_value(ctx);
         return 1;
     }
 
+    closure compile(context &ctx) const override {
+        int64_t *target = ctx.get_variable(static_cast<const id_node&>(*left_).get_slot());
+        return make_assign_closure<typename impl_type::operation>(target, compile_operand(*right_, ctx));
+    }
+
     void dump(std::ostream &ostr) const override {
         ostr << get_name() << " (";
         left_->dump(ostr);
@@ -146,22 +362,21 @@ public:
         left_->dump_gv(graph, node);
         right_->dump_gv(graph, node);
     }
-
-protected:
-    std::unique_ptr<node> left_;
-    std::unique_ptr<node> right_;
 };
 
 class assign_node final: public assign_operation<assign_node> {
 public:
     using assign_operation::assign_operation;
+
+    static constexpr node_kind kind = node_kind::ASSIGN;
+    using operation = assigns;
     
     const char* get_name() const {
         return "=";
     }
     
     int64_t assigned_value(context &ctx) const {
-        return get_value(right_->execute(ctx));
+        return right_->execute(ctx);
     }
 };
 
@@ -169,51 +384,92 @@ class plus_assign_node final: public assign_operation<plus_assign_node> {
 public:
     using assign_operation::assign_operation;
 
+    static constexpr node_kind kind = node_kind::PLUS_ASSIGN;
+    using operation = std::plus<int64_t>;
+
     const char* get_name() const {
         return "+=";
     }
 
     int64_t assigned_value(context &ctx) const {
-        return std::plus<int64_t>()(get_value(left_->execute(ctx)), get_value(right_->execute(ctx)));
+        return std::plus<int64_t>()(left_->execute(ctx), right_->execute(ctx));
     }
 };
 
 class minus_assign_node final: public assign_operation<minus_assign_node> {
 public:
     using assign_operation::assign_operation;
+
+    static constexpr node_kind kind = node_kind::MINUS_ASSIGN;
+    using operation = std::minus<int64_t>;
     
     const char* get_name() const {
         return "-=";
     }
     
     int64_t assigned_value(context &ctx) const {
-        return std::minus<int64_t>()(get_value(left_->execute(ctx)), get_value(right_->execute(ctx)));
+        return std::minus<int64_t>()(left_->execute(ctx), right_->execute(ctx));
     }
 };
 
 class multiply_assign_node final: public assign_operation<multiply_assign_node> {
 public:
     using assign_operation::assign_operation;
+
+    static constexpr node_kind kind = node_kind::MULTIPLY_ASSIGN;
+    using operation = std::multiplies<int64_t>;
         
     const char* get_name() const {
         return "*=";
     }
         
     int64_t assigned_value(context &ctx) const {
-        return std::multiplies<int64_t>()(get_value(left_->execute(ctx)), get_value(right_->execute(ctx)));
+        return std::multiplies<int64_t>()(left_->execute(ctx), right_->execute(ctx));
     }
 };
 
-class divide_assign_node final: public assign_operation<divide_assign_node> {
+// Division checks its divisor for zero, unless it's proven not to be zero, see optimizer/ranges.h
+class divisor_check {
+public:
+    bool is_divisor_checked() const {
+        return is_divisor_checked_;
+    }
+
+    void set_divisor_checked(bool is_checked) {
+        is_divisor_checked_ = is_checked;
+    }
+
+private:
+    bool is_divisor_checked_ = true;
+};
+
+class divide_assign_node final: public assign_operation<divide_assign_node>, public divisor_check {
 public:
     using assign_operation::assign_operation;
+
+    static constexpr node_kind kind = node_kind::DIVIDE_ASSIGN;
+    using operation = checked_divides;
             
     const char* get_name() const {
         return "/=";
     }
             
     int64_t assigned_value(context &ctx) const {
-        return std::divides<int64_t>()(get_value(left_->execute(ctx)), get_value(right_->execute(ctx)));
+        int64_t lhs = left_->execute(ctx);
+        int64_t rhs = right_->execute(ctx);
+
+        if (is_divisor_checked())
+            return checked_divides()(lhs, rhs);
+
+        return std::divides<int64_t>()(lhs, rhs);
+    }
+
+    closure compile(context &ctx) const override {
+        if (is_divisor_checked())
+            return assign_operation::compile(ctx);
+
+        int64_t *target = ctx.get_variable(static_cast<const id_node&>(*left_).get_slot());
+        return make_assign_closure<std::divides<int64_t>>(target, compile_operand(*right_, ctx));
     }
 };
 
@@ -221,10 +477,22 @@ public:
 class negate_node final: public node {
 public:
     explicit negate_node(std::unique_ptr<node> left):
-        child_(std::move(left)) {}
+        node(node_kind::NEGATE), child_(std::move(left)) {}
+
+    const node &get_child() const {
+        return *child_;
+    }
+
+    std::unique_ptr<node> &get_child() {
+        return child_;
+    }
 
     int64_t execute(context &ctx) override {
-        return create_value(std::negate<int64_t>{}(get_value(child_->execute(ctx))));
+        return std::negate<int64_t>{}(child_->execute(ctx));
+    }
+
+    closure compile(context &ctx) const override {
+        return make_unary_closure<std::negate<int64_t>>(compile_operand(*child_, ctx));
     }
 
     std::string get_name() const {
@@ -252,24 +520,39 @@ private:
 class divide_node;
 
 template <typename impl_type, typename op>
-class arithmetic_and_comparative_operator: public node {
+class arithmetic_and_comparative_operator: public binary_node {
 public:
     explicit arithmetic_and_comparative_operator(std::unique_ptr<node> left, 
                                                  std::unique_ptr<node> right):
-        left_(std::move(left)), right_(std::move(right)) {}
+        binary_node(impl_type::kind, std::move(left), std::move(right)) {}
     virtual ~arithmetic_and_comparative_operator() = default;
 
+    // Operation as it's done on plain values, division checks for zero:
+    using operation = std::conditional_t<std::is_same_v<impl_type, divide_node>, checked_divides, op>;
+
     const char* get_name() const {
         return static_cast<const impl_type*>(this)->get_name();
     }
 
     int64_t execute(context &ctx) override {
+        int64_t lhs = left_->execute(ctx);
+        int64_t rhs = right_->execute(ctx);
+
+        if constexpr (std::is_same_v<impl_type, divide_node>) {
+            if (static_cast<const impl_type*>(this)->is_divisor_checked())
+                return operation{}(lhs, rhs);
+        }
+
+        return op{}(lhs, rhs);
+    }
+
+    closure compile(context &ctx) const override {
         if constexpr (std::is_same_v<impl_type, divide_node>) {
-            if (get_value(right_->execute(ctx)) == 0)
-                throw std::runtime_error("divide by zero");
+            if (!static_cast<const impl_type*>(this)->is_divisor_checked())
+                return make_binary_closure<op>(compile_operand(*left_, ctx), compile_operand(*right_, ctx));
         }
-        return create_value(op{}(get_value(left_->execute(ctx)),
-                                 get_value(right_->execute(ctx))));
+
+        return make_binary_closure<operation>(compile_operand(*left_, ctx), compile_operand(*right_, ctx));
     }
 
     void dump(std::ostream &ostr) const override {
@@ -287,16 +570,14 @@ public:
         left_->dump_gv(graph, node);
         right_->dump_gv(graph, node);
     }
-
-protected:
-    std::unique_ptr<node> left_;
-    std::unique_ptr<node> right_;
 };
 
 class plus_node final: public arithmetic_and_comparative_operator<plus_node, std::plus<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
 
+    static constexpr node_kind kind = node_kind::PLUS;
+
     const char* get_name() const {
         return "+";
     }
@@ -305,6 +586,8 @@ public:
 class minus_node final: public arithmetic_and_comparative_operator<minus_node, std::minus<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::MINUS;
         
     const char* get_name() const {
         return "-";
@@ -315,23 +598,38 @@ class multiply_node final: public arithmetic_and_comparative_operator<multiply_n
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
 
+    static constexpr node_kind kind = node_kind::MULTIPLY;
+
     const char* get_name() const {
         return "*";
     }
 };
 
-class divide_node final: public arithmetic_and_comparative_operator<divide_node, std::divides<int64_t>> {
+class divide_node final: public arithmetic_and_comparative_operator<divide_node, std::divides<int64_t>>,
+                         public divisor_check {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::DIVIDE;
         
     const char* get_name() const {
         return "/";
     }
 };
 
+// Whether division, either an operator or a compound assignment, checks its divisor
+inline bool is_divisor_checked(const node &division) {
+    if (division.get_kind() == node_kind::DIVIDE)
+        return static_cast<const divide_node&>(division).is_divisor_checked();
+
+    return static_cast<const divide_assign_node&>(division).is_divisor_checked();
+}
+
 class equal_node final: public arithmetic_and_comparative_operator<equal_node, std::equal_to<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::EQUAL;
             
     const char* get_name() const {
         return "==";
@@ -341,6 +639,8 @@ public:
 class less_node final: public arithmetic_and_comparative_operator<less_node, std::less<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::LESS;
                 
     const char* get_name() const {
         return "&lt;";
@@ -351,6 +651,8 @@ class bigger_node final: public arithmetic_and_comparative_operator<bigger_node,
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
 
+    static constexpr node_kind kind = node_kind::BIGGER;
+
     const char* get_name() const {
         return "&gt;";
     }
@@ -360,6 +662,8 @@ class less_or_equal_node final: public arithmetic_and_comparative_operator<less_
                                                                            std::less_equal<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::LESS_OR_EQUAL;
     
     const char* get_name() const {
         return "&le;";
@@ -370,6 +674,8 @@ class bigger_or_equal_node final: public arithmetic_and_comparative_operator<big
                                                                              std::greater_equal<int64_t>> {
 public:
     using arithmetic_and_comparative_operator::arithmetic_and_comparative_operator;
+
+    static constexpr node_kind kind = node_kind::BIGGER_OR_EQUAL;
         
     const char* get_name() const {
         return "&ge;";
@@ -381,11 +687,28 @@ template<bool is_loop>
 class conditional_operation_node final: public node {
 public:
     explicit conditional_operation_node(std::unique_ptr<node> condition,
-                                        std::vector<std::unique_ptr<node>> scope):
+                                        node_list scope):
+        node(is_loop ? node_kind::WHILE : node_kind::IF),
         condition_(std::move(condition)), scope_(std::move(scope)) {}
 
+    const node &get_condition() const {
+        return *condition_;
+    }
+
+    std::unique_ptr<node> &get_condition() {
+        return condition_;
+    }
+
+    const node_list &get_scope() const {
+        return scope_;
+    }
+
+    node_list &get_scope() {
+        return scope_;
+    }
+
     int64_t execute(context &ctx) override {
-        while (get_value(condition_->execute(ctx)) != 0) {
+        while (condition_->execute(ctx) != 0) {
             for (const auto& i: scope_) {
                 i->execute(ctx);
             }
@@ -396,6 +719,21 @@ public:
         return 1;
     }
 
+    closure compile(context &ctx) const override {
+        return with_operand(compile_operand(*condition_, ctx), [&](auto condition) -> closure {
+            return [condition, body = compile_scope(scope_, ctx)] {
+                if constexpr (is_loop) {
+                    while (condition() != 0)
+                        body();
+                } else if (condition() != 0) {
+                    body();
+                }
+
+                return int64_t{1};
+            };
+        });
+    }
+
     std::string get_name() const {
         return is_loop ? "while" : "if";
     }
@@ -425,7 +763,7 @@ public:
 
 private:
     std::unique_ptr<node> condition_;
-    std::vector<std::unique_ptr<node>> scope_;
+    node_list scope_;
 };
 
 using if_node    = conditional_operation_node<false>;
@@ -434,11 +772,17 @@ using while_node = conditional_operation_node<true>;
 
 class scan_node final: public node {
 public:
+    scan_node():
+        node(node_kind::SCAN) {}
+
     int64_t execute([[maybe_unused]] context &ctx) override {
-        int64_t value;
-        std::cout << "Input: ";
-        std::cin >> value;
-        return create_value(value);
+        return get_input().read_number();
+    }
+
+    closure compile([[maybe_unused]] context &ctx) const override {
+        return [] {
+            return get_input().read_number();
+        };
     }
 
     void dump(std::ostream &ostr) const override {
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+namespace paracl {
+
+// Where print writes. Output is collected in a fixed buffer, numbers are
+// formatted right into it, so printing neither allocates nor calls into the
+// system. Buffer is written to the target when it fills up, when the sink is
+// destroyed at exit, and at points the flush policy asks for.
+class output_sink {
+public:
+    struct flush_policy {
+        // After every printed line, so that output is seen as it goes
+        bool on_newline = true;
+
+        // Before every prompt for input, so that prompt is seen before input is read
+        bool before_input = true;
+
+        // Lines are flushed if output goes to a terminal, prompts if input comes from one
+        static flush_policy detect(int output_fd) {
+#ifdef _WIN32
+            return { _isatty(output_fd) != 0, _isatty(0) != 0 };
+#else
+            return { isatty(output_fd) != 0, isatty(0) != 0 };
+#endif
+        }
+    };
+
+    static constexpr size_t buffer_size = 64 * 1024;
+
+    // Writes to std::cout, flushing like std::endl does on every line
+    output_sink() = default;
+
+    output_sink(const output_sink &other) = delete;
+    output_sink &operator=(const output_sink &other) = delete;
+
+    ~output_sink() {
+        flush();
+    }
+
+    // Everything written before goes to the previous target
+    void write_to(int fd, flush_policy policy) {
+        flush();
+        target_ = target_kind::DESCRIPTOR;
+        fd_ = fd;
+        policy_ = policy;
+    }
+
+    void write_to(std::ostream &stream, flush_policy policy) {
+        flush();
+        target_ = target_kind::STREAM;
+        stream_ = &stream;
+        policy_ = policy;
+    }
+
+    void write_to(std::ostream &stream) {
+        write_to(stream, flush_policy{});
+    }
+
+    // Output is appended to the string, it's only flushed when asked to
+    void write_to(std::string &buffer) {
+        flush();
+        target_ = target_kind::STRING;
+        string_ = &buffer;
+        policy_ = { false, false };
+    }
+
+    void write_number(int64_t value) {
+        // Longest one is -9223372036854775808
+        constexpr size_t max_length = 20;
+        if (buffer_size - size_ < max_length)
+            flush();
+
+        char *end = std::to_chars(buffer_.data() + size_, buffer_.data() + buffer_size, value).ptr;
+        size_ = static_cast<size_t>(end - buffer_.data());
+    }
+
+    void put(char symbol) {
+        if (size_ == buffer_size)
+            flush();
+
+        buffer_[size_ ++] = symbol;
+    }
+
+    void write(std::string_view text) {
+        for (char symbol: text)
+            put(symbol);
+    }
+
+    void end_line() {
+        put('\n');
+        if (policy_.on_newline)
+            flush();
+    }
+
+    // Text that asks for input, it's flushed if policy says so
+    void prompt(std::string_view text) {
+        write(text);
+        if (policy_.before_input)
+            flush();
+    }
+
+    void flush() {
+        if (size_ == 0)
+            return;
+
+        switch (target_) {
+        case target_kind::STREAM:
+            stream_->write(buffer_.data(), static_cast<std::streamsize>(size_));
+            stream_->flush();
+            break;
+
+        case target_kind::DESCRIPTOR:
+            write_all(buffer_.data(), size_);
+            break;
+
+        case target_kind::STRING:
+            string_->append(buffer_.data(), size_);
+            break;
+        }
+
+        size_ = 0;
+    }
+
+private:
+    enum class target_kind {
+        STREAM,
+        DESCRIPTOR,
+        STRING,
+    };
+
+    std::array<char, buffer_size> buffer_;
+    size_t size_ = 0;
+
+    target_kind target_ = target_kind::STREAM;
+    std::ostream *stream_ = &std::cout;
+    std::string *string_ = nullptr;
+    int fd_ = 1;
+
+    flush_policy policy_{};
+
+    // Output that can't be written is dropped, like stdio does
+    void write_all(const char *data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            auto written = _write(fd_, data, static_cast<unsigned>(size));
+#else
+            auto written = ::write(fd_, data, size);
+#endif
+            if (written < 0 && errno == EINTR)
+                continue;
+
+            if (written <= 0)
+                return;
+
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+};
+
+// Sink that programs print to
+inline output_sink &get_output() {
+    static output_sink output;
+    return output;
+}
+
+} // end namespace paracl
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+namespace paracl {
+
+// Writes tree back as ParaCL code that parses into an equivalent tree, so
+// transformed programs can be saved and run again. Operands that are operations
+// themselves are parenthesized, and temporaries that optimizations create, whose names
+// can't be written in code, get names that don't clash with other variables. Only calls
+// can be statements in code, so other expressions that are evaluated for their side
+// effects, like `?;` left from dead stores, are assigned to an unused variable.
+// Variables of different blocks can have the same name but different slots, when
+// their blocks are inlined they would become one variable, so all of them but the
+// first one get names of their own too. Variable that is first mentioned in a block
+// would belong to that block when parsed, so if passes removed its mentions before
+// the block and it's still used outside of it, it's declared at the top of the program.
+class source_writer {
+public:
+    explicit source_writer(std::ostream &ostr):
+        ostr_(ostr) {}
+
+    void write(const node_list &scope) {
+        for (const auto &statement: scope)
+            collect_names(*statement);
+
+        for (const auto &[name, slot]: undeclared_)
+            ostr_ << get_name(name, slot) << " = 0;\n";
+
+        write_scope(scope, 0);
+    }
+
+private:
+    std::ostream &ostr_;
+
+    std::unordered_set<std::string> names_;
+
+    // Slot that keeps the name, it's the first one the name is seen with
+    std::unordered_map<std::string, size_t> first_slots_;
+
+    std::map<std::pair<std::string, size_t>, std::string> renamed_;
+    std::string unused_;
+
+    // Blocks that enclose the node being collected, and blocks of first mentions
+    // of variables, which are the blocks variables would belong to
+    std::vector<size_t> blocks_;
+    size_t block_count_ = 0;
+    std::map<std::pair<std::string, size_t>, std::vector<size_t>> first_blocks_;
+
+    // Variables that are used outside of their blocks, in order of first mention
+    std::vector<std::pair<std::string, size_t>> undeclared_;
+
+    void collect_names(const node &tree) {
+        const node &current = get_unfused(tree);
+
+        switch (current.get_kind()) {
+        case node_kind::ID: {
+            const auto &id = static_cast<const id_node&>(current);
+
+            names_.insert(id.get_name());
+            first_slots_.try_emplace(id.get_name(), id.get_slot());
+
+            std::pair variable(id.get_name(), id.get_slot());
+            auto [it, inserted] = first_blocks_.try_emplace(variable, blocks_);
+            if (inserted)
+                return;
+
+            // Block it would belong to doesn't enclose this mention:
+            const std::vector<size_t> &block = it->second;
+            if (block.size() > blocks_.size() || !std::equal(block.begin(), block.end(), blocks_.begin())) {
+                undeclared_.push_back(variable);
+                it->second.clear();
+            }
+            return;
+        }
+
+        case node_kind::FUNCTION:
+            for (const auto &arg: static_cast<const function_node&>(current).get_args())
+                collect_names(*arg);
+            return;
+
+        case node_kind::NEGATE:
+            collect_names(static_cast<const negate_node&>(current).get_child());
+            return;
+
+        case node_kind::IF:
+        case node_kind::WHILE: {
+            const auto &conditional = static_cast<const while_node&>(current);
+
+            collect_names(conditional.get_condition());
+
+            blocks_.push_back(block_count_ ++);
+            for (const auto &statement: conditional.get_scope())
+                collect_names(*statement);
+
+            blocks_.pop_back();
+            return;
+        }
+
+        case node_kind::NUMBER:
+        case node_kind::SCAN:
+            return;
+
+        default: {
+            const auto &binary = static_cast<const binary_node&>(current);
+            collect_names(binary.get_left());
+            collect_names(binary.get_right());
+            return;
+        }
+        }
+    }
+
+    const std::string &get_name(const id_node &id) {
+        return get_name(id.get_name(), id.get_slot());
+    }
+
+    const std::string &get_name(const std::string &name, size_t slot) {
+        if (!name.starts_with("$") && first_slots_.at(name) == slot)
+            return name;
+
+        auto [it, inserted] = renamed_.try_emplace(std::pair(name, slot));
+        if (inserted) {
+            std::string renamed = name.starts_with("$") ? name.substr(1) : name;
+            while (names_.contains(renamed))
+                renamed += "_";
+
+            names_.insert(renamed);
+            it->second = std::move(renamed);
+        }
+
+        return it->second;
+    }
+
+    // Name that no variable has, for values that are never read
+    const std::string &get_unused_name() {
+        if (unused_.empty()) {
+            unused_ = "unused";
+            while (names_.contains(unused_))
+                unused_ += "_";
+
+            names_.insert(unused_);
+        }
+
+        return unused_;
+    }
+
+    void write_indent(size_t depth) {
+        ostr_ << std::string(depth * 4, ' ');
+    }
+
+    void write_scope(const node_list &scope, size_t depth) {
+        for (const auto &statement: scope)
+            write_statement(get_unfused(*statement), depth);
+    }
+
+    void write_statement(const node &statement, size_t depth) {
+        write_indent(depth);
+
+        if (statement.get_kind() == node_kind::IF || statement.get_kind() == node_kind::WHILE) {
+            const auto &conditional = static_cast<const while_node&>(statement);
+
+            ostr_ << (statement.get_kind() == node_kind::IF ? "if" : "while") << " (";
+            write_expression(conditional.get_condition(), false);
+            ostr_ << ") {\n";
+
+            write_scope(conditional.get_scope(), depth + 1);
+
+            write_indent(depth);
+            ostr_ << "}\n";
+            return;
+        }
+
+        if (is_assignment(statement.get_kind())) {
+            const auto &assignment = static_cast<const binary_node&>(statement);
+
+            write_expression(assignment.get_left());
+            ostr_ << " " << get_operator(statement.get_kind()) << " ";
+            write_expression(assignment.get_right(), false);
+        } else {
+            if (statement.get_kind() != node_kind::FUNCTION)
+                ostr_ << get_unused_name() << " = ";
+
+            write_expression(statement, false);
+        }
+
+        ostr_ << ";\n";
+    }
+
+    // Operations are parenthesized when they are operands of other operations
+    void write_expression(const node &expression, bool is_operand = true) {
+        const node &current = get_unfused(expression);
+
+        switch (current.get_kind()) {
+        case node_kind::NUMBER: {
+            int64_t value = static_cast<const number_node&>(current).get_number();
+
+            // Literals are never negative, smallest value has no positive counterpart:
+            if (value == std::numeric_limits<int64_t>::min())
+                ostr_ << "(-" << std::numeric_limits<int64_t>::max() << " - 1)";
+            else
+                ostr_ << value;
+            return;
+        }
+
+        case node_kind::ID:
+            ostr_ << get_name(static_cast<const id_node&>(current));
+            return;
+
+        case node_kind::SCAN:
+            ostr_ << "?";
+            return;
+
+        case node_kind::FUNCTION: {
+            const auto &function = static_cast<const function_node&>(current);
+
+            ostr_ << function.get_name() << "(";
+            for (size_t i = 0; i < function.get_args().size(); ++ i) {
+                if (i != 0)
+                    ostr_ << " ";
+                write_expression(*function.get_args()[i], false);
+            }
+            ostr_ << ")";
+            return;
+        }
+
+        case node_kind::NEGATE: {
+            const node &child = static_cast<const negate_node&>(current).get_child();
+
+            // Only leaves can be negated in code, anything else is subtracted from zero:
+            if (child.get_kind() == node_kind::ID || child.get_kind() == node_kind::SCAN ||
+                (child.get_kind() == node_kind::NUMBER &&
+                 static_cast<const number_node&>(child).get_number() >= 0)) {
+                ostr_ << "-";
+                write_expression(child);
+            } else {
+                ostr_ << "(0 - ";
+                write_expression(child);
+                ostr_ << ")";
+            }
+            return;
+        }
+
+        default: {
+            const auto &binary = static_cast<const binary_node&>(current);
+
+            if (is_operand)
+                ostr_ << "(";
+
+            write_expression(binary.get_left());
+            ostr_ << " " << get_operator(current.get_kind()) << " ";
+            write_expression(binary.get_right());
+
+            if (is_operand)
+                ostr_ << ")";
+            return;
+        }
+        }
+    }
+
+    static const char *get_operator(node_kind kind) {
+        switch (kind) {
+        case node_kind::ASSIGN:          return "=";
+        case node_kind::PLUS_ASSIGN:     return "+=";
+        case node_kind::MINUS_ASSIGN:    return "-=";
+        case node_kind::MULTIPLY_ASSIGN: return "*=";
+        case node_kind::DIVIDE_ASSIGN:   return "/=";
+        case node_kind::PLUS:            return "+";
+        case node_kind::MINUS:           return "-";
+        case node_kind::MULTIPLY:        return "*";
+        case node_kind::DIVIDE:          return "/";
+        case node_kind::EQUAL:           return "==";
+        case node_kind::LESS:            return "<";
+        case node_kind::BIGGER:          return ">";
+        case node_kind::LESS_OR_EQUAL:   return "<=";
+        case node_kind::BIGGER_OR_EQUAL: return ">=";
+        default:                         return "?";
+        }
+    }
+};
+
+} // end namespace paracl
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ast/context.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+
+
+namespace paracl {
+
+// Tree-walker that dispatches on node_kind with a dense switch instead of
+// calling node::execute. Kinds are a closed set and node classes are final, so
+// every child is evaluated with a direct call to the same function, which the
+// compiler can inline into itself and keep values of a whole expression in
+// registers. Variables are read through a pointer to context's values taken
+// once, so they stay valid only while no variables are added to the context.
+//
+// Fused and closed form nodes are already specialized, they run their execute.
+class switch_evaluator {
+public:
+    explicit switch_evaluator(context &ctx):
+        context_(ctx), variables_(ctx.get_variables()) {}
+
+    void run(const node_list &scope) {
+        execute_scope(scope);
+    }
+
+    int64_t evaluate(node &tree) {
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+            return static_cast<const number_node&>(tree).get_number();
+
+        case node_kind::ID:
+            return variables_[static_cast<const id_node&>(tree).get_slot()];
+
+        case node_kind::FUNCTION:
+            return execute_function(static_cast<function_node&>(tree));
+
+        case node_kind::ASSIGN:          return execute_assign<assign_node>(tree);
+        case node_kind::PLUS_ASSIGN:     return execute_assign<plus_assign_node>(tree);
+        case node_kind::MINUS_ASSIGN:    return execute_assign<minus_assign_node>(tree);
+        case node_kind::MULTIPLY_ASSIGN: return execute_assign<multiply_assign_node>(tree);
+
+        case node_kind::DIVIDE_ASSIGN:
+            if (is_divisor_checked(tree))
+                return execute_assign<divide_assign_node>(tree);
+
+            return execute_assign<divide_assign_node, std::divides<int64_t>>(tree);
+
+        case node_kind::NEGATE:
+            return std::negate<int64_t>{}(evaluate(*static_cast<negate_node&>(tree).get_child()));
+
+        case node_kind::PLUS:            return evaluate_binary<plus_node>(tree);
+        case node_kind::MINUS:           return evaluate_binary<minus_node>(tree);
+        case node_kind::MULTIPLY:        return evaluate_binary<multiply_node>(tree);
+
+        case node_kind::DIVIDE:
+            if (is_divisor_checked(tree))
+                return evaluate_binary<divide_node>(tree);
+
+            return evaluate_binary<divide_node, std::divides<int64_t>>(tree);
+
+        case node_kind::EQUAL:           return evaluate_binary<equal_node>(tree);
+        case node_kind::LESS:            return evaluate_binary<less_node>(tree);
+        case node_kind::BIGGER:          return evaluate_binary<bigger_node>(tree);
+        case node_kind::LESS_OR_EQUAL:   return evaluate_binary<less_or_equal_node>(tree);
+        case node_kind::BIGGER_OR_EQUAL: return evaluate_binary<bigger_or_equal_node>(tree);
+
+        case node_kind::IF:
+            return execute_conditional(static_cast<if_node&>(tree));
+
+        case node_kind::WHILE:
+            return execute_conditional(static_cast<while_node&>(tree));
+
+        case node_kind::SCAN:
+            return execute_scan();
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            break;
+        }
+
+        return tree.execute(context_);
+    }
+
+private:
+    context &context_;
+    int64_t *variables_;
+
+    // Most operands are leaves, they are read in place without going through the switch:
+    int64_t evaluate_operand(node &operand) {
+        switch (operand.get_kind()) {
+        case node_kind::NUMBER:
+            return static_cast<const number_node&>(operand).get_number();
+
+        case node_kind::ID:
+            return variables_[static_cast<const id_node&>(operand).get_slot()];
+
+        default:
+            return evaluate(operand);
+        }
+    }
+
+    void execute_scope(const node_list &scope) {
+        for (const auto &statement: scope)
+            evaluate(*statement);
+    }
+
+    template <typename node_type, typename op = typename node_type::operation>
+    int64_t evaluate_binary(node &tree) {
+        auto &binary = static_cast<node_type&>(tree);
+
+        int64_t lhs = evaluate_operand(*binary.get_left());
+        int64_t rhs = evaluate_operand(*binary.get_right());
+        return static_cast<int64_t>(op{}(lhs, rhs));
+    }
+
+    // Left operand is always a variable, it's read before the right one, like execute does
+    template <typename node_type, typename op = typename node_type::operation>
+    int64_t execute_assign(node &tree) {
+        auto &assignment = static_cast<node_type&>(tree);
+
+        int64_t &variable = variables_[static_cast<const id_node&>(*assignment.get_left()).get_slot()];
+        int64_t lhs = variable;
+        int64_t rhs = evaluate_operand(*assignment.get_right());
+
+        variable = op{}(lhs, rhs);
+        return 1;
+    }
+
+    // Statements and input are kept out of line, so that evaluation
+    // of expressions doesn't have to save registers that only they need:
+    template <bool is_loop>
+    [[gnu::noinline]] int64_t execute_conditional(conditional_operation_node<is_loop> &conditional) {
+        while (evaluate(*conditional.get_condition()) != 0) {
+            execute_scope(conditional.get_scope());
+            if constexpr (!is_loop)
+                break;
+        }
+
+        return 1;
+    }
+
+    [[gnu::noinline]] int64_t execute_scan() {
+        return get_input().read_number();
+    }
+
+    [[gnu::noinline]] int64_t execute_function(function_node &function) {
+        if (function.get_name() != "print")
+            return 0;
+
+        output_sink &output = get_output();
+
+        bool first = true;
+        for (const auto &arg: function.get_args()) {
+            if (!first)
+                output.put(' ');
+
+            output.write_number(evaluate(*arg));
+            first = false;
+        }
+        output.end_line();
+        return 1;
+    }
+};
+
+} // end namespace paracl
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ir/ir.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace paracl {
+
+// Every instruction addresses registers of a single flat frame. Frame is laid out as:
+//
+//   [ variables | constants | temporaries ]
+//
+// Constants are loaded into their registers once, before the program starts,
+// so all operands are plain register indices and there is no separate immediate form.
+
+#define PARACL_BYTECODE_OPCODES(X)                                                           \
+    X(MOVE)                        /* a = b                                               */ \
+    X(NEGATE)                      /* a = -b                                              */ \
+                                                                                             \
+    X(ADD)                         /* a = b + c                                           */ \
+    X(SUBTRACT)                    /* a = b - c                                           */ \
+    X(MULTIPLY)                    /* a = b * c                                           */ \
+    X(DIVIDE)                      /* a = b / c, throws if c is zero                      */ \
+    X(DIVIDE_UNCHECKED)            /* a = b / c, c is proven not to be zero               */ \
+                                                                                             \
+    X(EQUAL)                       /* a = b == c                                          */ \
+    X(LESS)                        /* a = b <  c                                          */ \
+    X(BIGGER)                      /* a = b >  c                                          */ \
+    X(LESS_OR_EQUAL)               /* a = b <= c                                          */ \
+    X(BIGGER_OR_EQUAL)             /* a = b >= c                                          */ \
+                                                                                             \
+    X(JUMP)                        /* goto a                                              */ \
+    X(JUMP_IF_ZERO)                /* if (b == 0) goto a                                  */ \
+    X(JUMP_UNLESS_EQUAL)           /* if (!(b == c)) goto a                               */ \
+    X(JUMP_UNLESS_LESS)            /* if (!(b <  c)) goto a                               */ \
+    X(JUMP_UNLESS_BIGGER)          /* if (!(b >  c)) goto a                               */ \
+    X(JUMP_UNLESS_LESS_OR_EQUAL)   /* if (!(b <= c)) goto a                               */ \
+    X(JUMP_UNLESS_BIGGER_OR_EQUAL) /* if (!(b >= c)) goto a                               */ \
+                                                                                             \
+    X(SCAN)                        /* a = value read from input                           */ \
+    X(PRINT)                       /* print a                                             */ \
+    X(PRINT_SPACE)                 /* print separator between values of a single print    */ \
+    X(PRINT_NEWLINE)               /* finish print                                        */ \
+                                                                                             \
+    X(HALT)
+
+enum class opcode: uint8_t {
+#define PARACL_OPCODE_ENUM(name) name,
+    PARACL_BYTECODE_OPCODES(PARACL_OPCODE_ENUM)
+#undef PARACL_OPCODE_ENUM
+};
+
+inline constexpr size_t OPCODE_COUNT = static_cast<size_t>(opcode::HALT) + 1;
+
+const char *get_opcode_name(opcode op);
+
+
+struct instruction {
+    opcode op;
+    uint32_t a, b, c;
+};
+
+struct bytecode {
+    std::vector<instruction> code;
+
+    // Values are stored in registers that directly follow variables
+    std::vector<int64_t> constants;
+
+    struct variable {
+        size_t slot;
+        std::string name;
+    };
+
+    // Variables used by the program in order of their registers, first registers in the frame.
+    // Their values are copied from context slots before the run and back after it.
+    std::vector<variable> variables;
+
+    uint32_t register_count = 0;
+
+    uint32_t get_constants_begin() const {
+        return static_cast<uint32_t>(variables.size());
+    }
+
+    void dump(std::ostream &ostr = std::cout) const;
+};
+
+bytecode compile_bytecode(const node_list &scope, const context &ctx);
+
+// Compiles just one statement, lets a running loop continue in bytecode
+bytecode compile_bytecode(const node &statement, const context &ctx);
+
+// Lowers SSA form, every value gets a register of its own and phis become copies on edges
+bytecode compile_bytecode(const ir::function &function, const context &ctx);
+
+} // end namespace paracl
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ast/context.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace paracl {
+
+// Machine code of a single compiled loop nest, owns its executable memory
+class native_loop;
+
+// Walks program like tree-walker does, but every while loop that only
+// uses arithmetic, comparisons, assignments and nested if/while is compiled
+// into x86-64 machine code the first time it's reached. Loops with anything
+// else (like print or scan) are executed by the tree-walker, loops nested in
+// them are still compiled.
+class jit {
+public:
+    explicit jit(context &ctx);
+    ~jit();
+
+    // False when built for a platform jit can't generate code for,
+    // in that case everything falls back to the tree-walker.
+    static bool is_available();
+
+    void run(const node_list &scope);
+
+    size_t get_compiled_loop_count() const;
+
+private:
+    context &context_;
+
+    // Null when loop can't be compiled, so it's not attempted again:
+    std::unordered_map<const node*, std::unique_ptr<native_loop>> loops_;
+
+    void execute_scope(const node_list &scope);
+    void execute_loop(while_node &loop);
+};
+
+} // end namespace paracl
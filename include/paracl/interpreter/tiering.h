@@ -0,0 +1,54 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ast/context.h"
+#include "paracl/interpreter/bytecode.h"
+#include "paracl/interpreter/vm.h"
+
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace paracl {
+
+struct tiering_options {
+    // Number of iterations after which loop is moved to bytecode
+    size_t hotness_threshold = 1000;
+
+    // Tier transitions are reported here, if it's set
+    std::ostream *trace = nullptr;
+};
+
+// Starts executing everything in the tree-walker, which costs nothing to set up.
+// Every while loop counts its iterations, once loop gets hot it's compiled to
+// bytecode and continues from its next iteration in the vm, all its later runs
+// go straight to bytecode.
+class tiered_engine {
+public:
+    explicit tiered_engine(context &ctx, tiering_options options = {});
+
+    void run(const node_list &scope);
+
+    size_t get_promoted_loop_count() const;
+
+private:
+    struct loop_profile {
+        size_t iterations = 0;
+        std::unique_ptr<bytecode> compiled;
+    };
+
+    context &context_;
+    tiering_options options_;
+
+    std::unordered_map<const node*, loop_profile> loops_;
+    vm vm_;
+
+    void execute_scope(const node_list &scope);
+    void execute_loop(while_node &loop);
+
+    void promote(while_node &loop, loop_profile &profile);
+};
+
+} // end namespace paracl
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "paracl/interpreter/bytecode.h"
+#include "paracl/ast/context.h"
+
+#include <vector>
+
+
+namespace paracl {
+
+class vm {
+public:
+    // Variables are loaded from the context before the run
+    // and stored back into it when program halts:
+    void run(const bytecode &program, context &ctx);
+
+private:
+    std::vector<int64_t> frame_;
+
+    void execute(const bytecode &program);
+};
+
+} // end namespace paracl
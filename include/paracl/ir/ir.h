@@ -0,0 +1,263 @@
+#pragma once
+
+#include "paracl/ast/nodes.h"
+#include "paracl/ast/context.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// SSA form of a program: function made of basic blocks, every value is
+// defined exactly once by an instruction and knows all of its users.
+namespace paracl::ir {
+
+#define PARACL_IR_OPCODES(OPCODE)                                               \
+    OPCODE(CONSTANT,        "constant"       ) /* value known in advance     */ \
+    OPCODE(INITIAL,         "initial"        ) /* variable before program    */ \
+    OPCODE(PHI,             "phi"            ) /* one operand per predecessor*/ \
+    OPCODE(NEGATE,          "negate"         )                                  \
+    OPCODE(ADD,             "add"            )                                  \
+    OPCODE(SUBTRACT,        "subtract"       )                                  \
+    OPCODE(MULTIPLY,        "multiply"       )                                  \
+    OPCODE(DIVIDE,          "divide"         ) /* fails on zero divisor      */ \
+    OPCODE(EQUAL,           "equal"          )                                  \
+    OPCODE(LESS,            "less"           )                                  \
+    OPCODE(BIGGER,          "bigger"         )                                  \
+    OPCODE(LESS_OR_EQUAL,   "less_or_equal"  )                                  \
+    OPCODE(BIGGER_OR_EQUAL, "bigger_or_equal")                                  \
+    OPCODE(SCAN,            "scan"           )                                  \
+    OPCODE(PRINT,           "print"          )                                  \
+    OPCODE(STORE,           "store"          ) /* variable after program     */ \
+    OPCODE(JUMP,            "jump"           )                                  \
+    OPCODE(BRANCH,          "branch"         ) /* to first target if nonzero */ \
+    OPCODE(RETURN,          "return"         )
+
+enum class opcode {
+#define PARACL_IR_OPCODE_ENUM(name, text) name,
+    PARACL_IR_OPCODES(PARACL_IR_OPCODE_ENUM)
+#undef PARACL_IR_OPCODE_ENUM
+};
+
+const char *get_opcode_name(opcode op);
+
+inline bool is_terminator(opcode op) {
+    return op == opcode::JUMP || op == opcode::BRANCH || op == opcode::RETURN;
+}
+
+inline bool is_binary(opcode op) {
+    return op >= opcode::ADD && op <= opcode::BIGGER_OR_EQUAL;
+}
+
+inline bool is_comparison(opcode op) {
+    return op >= opcode::EQUAL && op <= opcode::BIGGER_OR_EQUAL;
+}
+
+inline bool has_value(opcode op) {
+    return op != opcode::PRINT && op != opcode::STORE && !is_terminator(op);
+}
+
+// Instructions that can't be removed even if their value isn't used
+inline bool has_side_effects(opcode op) {
+    return !has_value(op) || op == opcode::SCAN || op == opcode::DIVIDE;
+}
+
+class block;
+
+class instruction {
+public:
+    explicit instruction(opcode op, block *parent):
+        op_(op), parent_(parent) {}
+
+    instruction(const instruction&) = delete;
+    instruction &operator=(const instruction&) = delete;
+
+    ~instruction() {
+        drop_operands();
+    }
+
+    opcode get_opcode() const {
+        return op_;
+    }
+
+    block *get_parent() const {
+        return parent_;
+    }
+
+    // Number used in dumps, assigned by function::renumber
+    size_t get_id() const {
+        return id_;
+    }
+
+    void set_id(size_t id) {
+        id_ = id;
+    }
+
+    // Value of CONSTANT
+    int64_t get_constant() const {
+        return constant_;
+    }
+
+    void set_constant(int64_t constant) {
+        constant_ = constant;
+    }
+
+    // Variable of INITIAL and STORE
+    size_t get_slot() const {
+        return slot_;
+    }
+
+    void set_slot(size_t slot) {
+        slot_ = slot;
+    }
+
+    const std::vector<instruction*> &get_operands() const {
+        return operands_;
+    }
+
+    instruction *get_operand(size_t index) const {
+        return operands_[index];
+    }
+
+    void add_operand(instruction *value);
+    void set_operand(size_t index, instruction *value);
+    void drop_operands();
+
+    // Every use is listed separately, so instruction that uses value twice is here twice
+    const std::vector<instruction*> &get_users() const {
+        return users_;
+    }
+
+    void replace_all_uses_with(instruction *value);
+
+    // Successors of JUMP and BRANCH
+    const std::vector<block*> &get_targets() const {
+        return targets_;
+    }
+
+    void dump(std::ostream &ostr) const;
+
+private:
+    opcode op_;
+    block *parent_;
+
+    size_t id_ = 0;
+    int64_t constant_ = 0;
+    size_t slot_ = 0;
+
+    std::vector<instruction*> operands_;
+    std::vector<instruction*> users_;
+
+    std::vector<block*> targets_;
+
+    friend class block;
+
+    void remove_user(instruction *user);
+};
+
+class block {
+public:
+    explicit block(size_t id):
+        id_(id) {}
+
+    size_t get_id() const {
+        return id_;
+    }
+
+    void set_id(size_t id) {
+        id_ = id;
+    }
+
+    const std::vector<std::unique_ptr<instruction>> &get_instructions() const {
+        return instructions_;
+    }
+
+    // Phi nodes go first, then everything else in order of execution, terminator is last
+    instruction *append(opcode op, std::vector<instruction*> operands = {});
+    instruction *insert_phi();
+
+    // Instruction must have no users left
+    void erase(instruction *removed);
+
+    // Inserts instruction at the given position, which shouldn't be before phi nodes
+    instruction *insert(size_t position, opcode op, std::vector<instruction*> operands = {});
+
+    void jump(block *target);
+    void branch(instruction *condition, block *if_true, block *if_false);
+    void ret();
+
+    instruction *get_terminator() const;
+
+    const std::vector<block*> &get_predecessors() const {
+        return predecessors_;
+    }
+
+    std::vector<block*> get_successors() const;
+
+    // Index of the phi operand that comes from predecessor
+    size_t get_predecessor_index(const block *predecessor) const;
+
+    void dump(std::ostream &ostr, const std::vector<std::string> &names) const;
+
+private:
+    size_t id_;
+
+    std::vector<std::unique_ptr<instruction>> instructions_;
+    std::vector<block*> predecessors_;
+
+    friend class function;
+};
+
+class function {
+public:
+    // Names of variables by their slots, used only in dumps
+    explicit function(std::vector<std::string> names);
+
+    function(function&&) = default;
+    function &operator=(function&&) = delete;
+
+    // Instructions refer to each other across blocks, so uses are dropped before anything is freed
+    ~function();
+
+    block *create_block();
+
+    block *get_entry() const {
+        return blocks_.front().get();
+    }
+
+    const std::vector<std::unique_ptr<block>> &get_blocks() const {
+        return blocks_;
+    }
+
+    const std::vector<std::string> &get_names() const {
+        return names_;
+    }
+
+    // Constants and initial values of variables are created once, in the entry block
+    instruction *get_constant(int64_t value);
+    instruction *get_initial(size_t slot);
+
+    // Puts blocks in reverse postorder, so every block comes after its dominators
+    // and loop bodies right after their headers, then numbers blocks and values
+    // in that order. Unreachable blocks, if there are any, go last.
+    void renumber();
+
+    void dump(std::ostream &ostr = std::cout);
+    void dump_gv(std::ostream &ostr = std::cout);
+
+private:
+    std::vector<std::string> names_;
+    std::vector<std::unique_ptr<block>> blocks_;
+
+    std::unordered_map<int64_t, instruction*> constants_;
+    std::unordered_map<size_t, instruction*> initials_;
+};
+
+// Builds SSA form of the program, with every variable in context
+// stored back at the end, if program changes it
+function build_ir(const paracl::node_list &scope, const context &ctx);
+
+} // end namespace paracl::ir
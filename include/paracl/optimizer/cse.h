@@ -0,0 +1,20 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+
+namespace paracl {
+
+// Finds repeated pure expressions by structural hashing: every subtree gets
+// a number from a hash-consing table, keyed by its operation and numbers of
+// its children, with variables keyed by their slot and by how many times they
+// were written before, so reads with no writes in between are equal. Expression
+// that is computed more than once is assigned to a temporary right before its
+// first use, and every copy of it becomes a read of that temporary, so it's
+// both computed and kept in memory once.
+//
+// Input and division that can fail are never moved. Returns number of
+// removed repeated computations.
+size_t eliminate_common_subexpressions(ast &tree);
+
+} // end namespace paracl
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+
+namespace paracl {
+
+// Removes assignments to variables that are never read afterwards. If the
+// assigned value reads input or can fail, only the assigned expression
+// is kept, and division assignment that can fail is kept whole. Variables
+// that are no longer referenced are removed from the context. Returns number
+// of assignments removed along with their values.
+//
+// Fused nodes cache slots of their variables, so it must run before fusion.
+size_t eliminate_dead_stores(ast &tree);
+
+} // end namespace paracl
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+#include <cstdint>
+#include <optional>
+
+
+namespace paracl {
+
+// Replaces subtrees built only from numbers with their value, removes
+// if and while statements with constantly false conditions and inlines
+// bodies of ifs with constantly true ones. Division by constant zero
+// is kept, so it still fails when it's run. Returns number of changes.
+size_t fold_constants(ast &tree);
+
+// Value of arithmetic or comparison on two numbers, or nothing if it would fail when run
+std::optional<int64_t> evaluate_operation(node_kind kind, int64_t lhs, int64_t rhs);
+
+} // end namespace paracl
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+
+namespace paracl {
+
+// Replaces idioms like `x += 1`, `x * y` or `while (a <= b)` with fused
+// nodes, that run them in one call. Returns number of nodes it fused.
+//
+// Fused nodes hide their subtrees, so it should run after other passes.
+size_t fuse_superinstructions(ast &tree);
+
+} // end namespace paracl
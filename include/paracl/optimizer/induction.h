@@ -0,0 +1,22 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/remarks.h"
+
+
+namespace paracl {
+
+// Finds while loops that only step a counter by a constant and add values
+// linear in that counter to other variables, and replaces them with nodes
+// that compute the result with closed formulas, see closed_form_nodes.h.
+// Returns number of replaced loops.
+//
+// Replaced loops hide their bodies, so it should run after other passes.
+// Loops that are kept are reported with what in them has no closed form.
+size_t replace_induction_loops(ast &tree, optimization_remarks *remarks);
+
+inline size_t replace_induction_loops(ast &tree) {
+    return replace_induction_loops(tree, nullptr);
+}
+
+} // end namespace paracl
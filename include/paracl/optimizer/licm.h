@@ -0,0 +1,22 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/remarks.h"
+
+
+namespace paracl {
+
+// Moves subexpressions of while loops that read only variables the loop never
+// writes into temporaries, assigned right before the loop. Input is never
+// hoisted, and neither is division that can fail, unless it's in the condition,
+// which is evaluated first anyway. Returns number of hoisted expressions.
+//
+// Hoisted expressions are reported as remarks, and so are invariant ones
+// that are kept in the loop because of input or division.
+size_t hoist_loop_invariants(ast &tree, optimization_remarks *remarks);
+
+inline size_t hoist_loop_invariants(ast &tree) {
+    return hoist_loop_invariants(tree, nullptr);
+}
+
+} // end namespace paracl
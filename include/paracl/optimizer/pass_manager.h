@@ -0,0 +1,103 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/remarks.h"
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace paracl {
+
+// Optimization over the whole tree, returns number of changes it made.
+// Passes that don't report remarks ignore them.
+struct optimization_pass {
+    const char *name;
+
+    // Shorter name it can also be requested by, if any
+    const char *alias;
+
+    size_t (*run)(ast &tree, optimization_remarks *remarks);
+};
+
+// Every pass in order they run with -O1, passes that hide subtrees go last
+std::span<const optimization_pass> get_default_passes();
+
+// Pass with the given name or alias
+const optimization_pass *find_pass(std::string_view name);
+
+// Number of nodes in the tree, replacement nodes are counted by their originals
+size_t count_nodes(const ast &tree);
+
+// Checks invariants that every pass relies on: all nodes are present, assignments
+// write to variables, and variables refer to existing slots with their own names.
+// Returns description of the first broken one.
+std::optional<std::string> verify_tree(const ast &tree);
+
+struct pass_statistics {
+    const char *name;
+    size_t changes;
+
+    size_t nodes_before;
+    size_t nodes_after;
+
+    std::chrono::duration<double> time;
+};
+
+// Runs passes in order, measuring each of them. Tree is verified after every
+// pass in debug builds, and pass that breaks it is reported with an exception.
+class pass_manager {
+public:
+    pass_manager() = default;
+
+    explicit pass_manager(std::span<const optimization_pass> passes):
+        passes_(passes.begin(), passes.end()) {}
+
+    // Pipeline from comma separated pass names, like "fold,dce,licm", or nothing
+    // if some of them don't exist, follow fusion, or can't follow induction
+    static std::optional<pass_manager> parse(std::string_view pipeline);
+
+    void add_pass(optimization_pass pass) {
+        passes_.push_back(pass);
+    }
+
+    const std::vector<optimization_pass> &get_passes() const {
+        return passes_;
+    }
+
+    void set_verification(bool is_enabled) {
+        verify_ = is_enabled;
+    }
+
+    // Where passes report their remarks, nowhere if null
+    void set_remarks(optimization_remarks *remarks) {
+        remarks_ = remarks;
+    }
+
+    void run(ast &tree);
+
+    const std::vector<pass_statistics> &get_statistics() const {
+        return statistics_;
+    }
+
+    void dump_statistics(std::ostream &ostr = std::cerr) const;
+
+private:
+    std::vector<optimization_pass> passes_;
+    std::vector<pass_statistics> statistics_;
+
+    optimization_remarks *remarks_ = nullptr;
+
+#ifdef NDEBUG
+    bool verify_ = false;
+#else
+    bool verify_ = true;
+#endif
+};
+
+} // end namespace paracl
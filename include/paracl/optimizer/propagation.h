@@ -0,0 +1,19 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+
+namespace paracl {
+
+// Sparse conditional constant propagation over the structured program: values
+// of variables are followed through assignments, ifs and loops (to a fixed point),
+// reads of variables with a known value become numbers, and if and while
+// statements whose conditions are known are removed or inlined, so their bodies
+// aren't even considered when they can't run. Reads of a variable that is a copy
+// of another one (after `a = b`, until either changes) read the original instead.
+//
+// Leaves folding of the resulting expressions to fold_constants. Returns number
+// of folded uses: reads replaced with a number or with the original of a copy.
+size_t propagate_constants(ast &tree);
+
+} // end namespace paracl
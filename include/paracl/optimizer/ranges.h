@@ -0,0 +1,23 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/remarks.h"
+
+
+namespace paracl {
+
+// Interval analysis over the structured program: every variable gets a range
+// of values it can have at each point, narrowed by conditions of ifs and loops
+// on their paths, with loops widened to a fixed point. Divisions whose divisor
+// can't be zero, like a constant or a counter that starts at 1 and grows, don't
+// check it at run time anymore, the rest of them are left checked.
+//
+// Returns number of removed checks, every division it looks at is reported
+// with a remark, kept checks with the range of their divisor.
+size_t remove_divisor_checks(ast &tree, optimization_remarks *remarks);
+
+inline size_t remove_divisor_checks(ast &tree) {
+    return remove_divisor_checks(tree, nullptr);
+}
+
+} // end namespace paracl
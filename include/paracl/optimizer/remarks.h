@@ -0,0 +1,59 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/text/display.h"
+
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace paracl {
+
+enum class remark_kind {
+    // Pass changed the program here
+    PASSED,
+
+    // Pass looked at this part, but couldn't change it, remark says why
+    MISSED
+};
+
+struct remark {
+    remark_kind kind;
+    const char *pass;
+    std::string message;
+
+    // Source of the node remark is about, if it came from source
+    std::optional<text_range> range;
+};
+
+// Remarks collected from passes, so that authors of programs can see what got
+// optimized and what stopped the rest. Passes that report them take a pointer
+// to it, that is null when nobody listens.
+class optimization_remarks {
+public:
+    void passed(const char *pass, const node &where, std::string message) {
+        remarks_.push_back({ remark_kind::PASSED, pass, std::move(message), where.get_range() });
+    }
+
+    void missed(const char *pass, const node &where, std::string message) {
+        remarks_.push_back({ remark_kind::MISSED, pass, std::move(message), where.get_range() });
+    }
+
+    const std::vector<remark> &get_remarks() const {
+        return remarks_;
+    }
+
+    // Every remark as a message with annotated source, in order they were made
+    void print(file &source, std::FILE *stream = stderr) const;
+
+    // Array of remarks as JSON objects, with 1-based lines and columns
+    void dump_json(std::ostream &ostr = std::cerr) const;
+
+private:
+    std::vector<remark> remarks_;
+};
+
+} // end namespace paracl
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+
+namespace paracl {
+
+// Gives variables whose lifetimes don't overlap the same slot, so frames of
+// programs with many short-lived variables stay small. Lifetimes come from
+// liveness analysis, variables interfere if one is written while the other
+// is live. Variables that are read before they are written hold their
+// initial values, they never share slots with each other. Variables that
+// are no longer referenced are removed from the context. Returns number
+// of slots it saved.
+//
+// Replacement nodes cache slots of their variables, trees that already have
+// them are left as they are.
+size_t share_variable_slots(ast &tree);
+
+} // end namespace paracl
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+
+#include <cstdint>
+#include <span>
+
+
+namespace paracl {
+
+// Partial evaluation against a known prefix of input: reads that are certain
+// to consume one of the given values, because every read before them is also
+// known, become that value. Constants are then propagated and folded, which
+// can decide conditions and make more reads certain, until no more reads can
+// be replaced.
+//
+// Returns number of replaced reads, which can be less than the number of
+// given values. Resulting program reads the rest of them first, before the
+// input that follows the prefix, so they have to be fed to it again.
+size_t specialize_input(ast &tree, std::span<const int64_t> inputs);
+
+} // end namespace paracl
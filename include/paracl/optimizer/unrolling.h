@@ -0,0 +1,40 @@
+#pragma once
+
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/remarks.h"
+
+
+namespace paracl {
+
+// Unrolls innermost while loops whose condition compares a counter, stepped
+// once per iteration by a constant, with a bound the loop doesn't change:
+//
+//     while (i < n) { body; i += 1; }
+//
+// becomes a loop that checks its condition once per factor iterations, with
+// the rest of them left to the original loop, which acts as a peeled epilogue:
+//
+//     while (i < n - 3) { body; i += 1; body; i += 1; body; i += 1; body; i += 1; }
+//     while (i < n) { body; i += 1; }
+//
+// Factor is picked by body size, so that unrolled body stays small, and is at
+// most max_factor. If moving the bound could overflow, unrolled loop is only
+// entered when it doesn't. Returns number of unrolled loops.
+//
+// Every loop it looks at is reported with a remark, either with the factor
+// it's unrolled by, or with why it isn't unrolled.
+size_t unroll_loops(ast &tree, size_t max_factor, optimization_remarks *remarks);
+
+inline size_t unroll_loops(ast &tree, size_t max_factor) {
+    return unroll_loops(tree, max_factor, nullptr);
+}
+
+inline size_t unroll_loops(ast &tree, optimization_remarks *remarks) {
+    return unroll_loops(tree, 4, remarks);
+}
+
+inline size_t unroll_loops(ast &tree) {
+    return unroll_loops(tree, 4, nullptr);
+}
+
+} // end namespace paracl
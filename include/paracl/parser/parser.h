@@ -15,7 +15,7 @@ public:
     explicit parser(std::vector<token> tokens, context &ctx):
         tokens_(std::move(tokens)), context_(ctx) {}
 
-    std::vector<std::unique_ptr<node>> parse() {
+    node_list parse() {
         return parse_scope();
     }
 
@@ -26,20 +26,28 @@ private:
 
     int get_operator_precedence(token_type type) const;
 
+    // Range from begin to the end of the last eaten token
+    text_range get_range_from(text_position begin) const;
+
     std::unique_ptr<node> parse_id_or_num(bool create_variable = false);
     std::unique_ptr<node> parse_expression(int min_precedence);
     std::unique_ptr<node> parse_function();
     std::unique_ptr<node> parse_comparison_operation();
     std::unique_ptr<node> parse_assing_operation();
     std::unique_ptr<node> parse_condition();
-    std::vector<std::unique_ptr<node>> parse_scope();
+    node_list parse_scope();
 
     template <typename node_type>
     std::unique_ptr<node> parse_binary_operation(bool create_var = false) {
+        text_position begin = current_token().range.begin;
+
         std::unique_ptr<node> left = parse_id_or_num(create_var);
         eat_token();
         std::unique_ptr<node> right = parse_expression(0);
-        return std::make_unique<node_type>(std::move(left), std::move(right));
+
+        std::unique_ptr<node> operation = std::make_unique<node_type>(std::move(left), std::move(right));
+        operation->set_range(get_range_from(begin));
+        return operation;
     }
 
 private:
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
 #include <variant>
 #include <string>
 #include <format>
@@ -200,7 +201,7 @@ public:
     void set_background(color background);
     void set_attribute(attribute attribute);
 
-    void print() const;
+    void print(std::FILE *stream = stdout) const;
 
 
 private:
@@ -7,6 +7,7 @@
 #include <vector>
 #include <span>
 #include <cassert>
+#include <cstdio>
 
 
 namespace paracl {
@@ -96,6 +97,11 @@ struct annotated_range {
 template <typename type>
 struct rngable {};
 
+template <>
+struct rngable<text_range> {
+    static text_range to_range(const text_range &range) { return range; }
+};
+
 struct rng {
     rng() = default;
 
@@ -137,7 +143,9 @@ struct file {
     std::string filename;
     std::string text;
 
-    void message(const std::string &message, std::vector<rng> rngs);
+    // Prints "filename:line:column: message" with both line and column counted from 1,
+    // as compilers do, followed by the text annotated with ranges
+    void message(const std::string &message, std::vector<rng> rngs, std::FILE *stream = stdout);
 };
 
 
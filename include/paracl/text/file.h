@@ -1,11 +1,42 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 
 namespace paracl {
 
 std::string read_file(const std::string &filename);
 
-} // end namespace paracl
+// File mapped into memory read-only, or read into it where mapping isn't supported.
+// Files that aren't regular, like pipes, are only opened.
+class mapped_file {
+public:
+    // Throws std::runtime_error if file can't be opened
+    explicit mapped_file(const std::string &filename);
+
+    mapped_file(const mapped_file &other) = delete;
+    mapped_file &operator=(const mapped_file &other) = delete;
+
+    ~mapped_file();
+
+    std::string_view get_text() const {
+        return { data_, size_ };
+    }
 
+    // Descriptor to read from if the file isn't regular, -1 otherwise
+    int get_descriptor() const {
+        return fd_;
+    }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    int fd_ = -1;
+
+    // Contents, if file isn't mapped
+    std::string text_;
+};
+
+} // end namespace paracl
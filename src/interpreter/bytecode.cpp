@@ -0,0 +1,378 @@
+#include "paracl/interpreter/bytecode.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <cassert>
+#include <optional>
+#include <unordered_map>
+
+
+namespace paracl {
+
+const char *get_opcode_name(opcode op) {
+    switch (op) {
+#define PARACL_OPCODE_NAME(name) case opcode::name: return #name;
+    PARACL_BYTECODE_OPCODES(PARACL_OPCODE_NAME)
+#undef PARACL_OPCODE_NAME
+    }
+
+    return "UNKNOWN";
+}
+
+void bytecode::dump(std::ostream &ostr) const {
+    for (size_t i = 0; i < variables.size(); ++ i)
+        ostr << "r" << i << " = " << variables[i].name << "\n";
+
+    for (size_t i = 0; i < constants.size(); ++ i)
+        ostr << "r" << get_constants_begin() + i << " = $" << constants[i] << "\n";
+
+    for (size_t i = 0; i < code.size(); ++ i) {
+        const instruction &ins = code[i];
+        ostr << i << ": " << get_opcode_name(ins.op)
+             << " " << ins.a << " " << ins.b << " " << ins.c << "\n";
+    }
+}
+
+
+namespace {
+
+class bytecode_compiler {
+public:
+    explicit bytecode_compiler(const context &ctx):
+        context_(ctx) {}
+
+    bytecode compile(const node_list &scope) {
+        compile_scope(scope);
+        return finish();
+    }
+
+    bytecode compile(const node &statement) {
+        compile_statement(statement);
+        return finish();
+    }
+
+private:
+    const context &context_;
+    bytecode program_;
+
+    std::unordered_map<size_t, uint32_t> variables_;
+    std::unordered_map<int64_t, uint32_t> constants_;
+
+    uint32_t temporaries_ = 0;
+    uint32_t max_temporaries_ = 0;
+
+    bytecode finish() {
+        emit(opcode::HALT);
+
+        // Variables and constants are only known after the whole program is
+        // compiled, so temporaries are allocated from zero and relocated now:
+        uint32_t temporaries_begin =
+            static_cast<uint32_t>(program_.variables.size() + program_.constants.size());
+
+        for (instruction &ins: program_.code)
+            relocate(ins, temporaries_begin);
+
+        program_.register_count = temporaries_begin + max_temporaries_;
+        return std::move(program_);
+    }
+
+    // Until relocation registers are tagged with their segment in the top bits:
+    static constexpr uint32_t SEGMENT_SHIFT = 30;
+    static constexpr uint32_t VARIABLE  = 0u << SEGMENT_SHIFT;
+    static constexpr uint32_t CONSTANT  = 1u << SEGMENT_SHIFT;
+    static constexpr uint32_t TEMPORARY = 2u << SEGMENT_SHIFT;
+    static constexpr uint32_t INDEX_MASK = (1u << SEGMENT_SHIFT) - 1;
+
+    uint32_t relocate_register(uint32_t reg, uint32_t temporaries_begin) const {
+        uint32_t index = reg & INDEX_MASK;
+        switch (reg & ~INDEX_MASK) {
+        case VARIABLE:  return index;
+        case CONSTANT:  return index + program_.get_constants_begin();
+        case TEMPORARY: return index + temporaries_begin;
+        }
+
+        assert(false && "unknown register segment");
+        return index;
+    }
+
+    void relocate(instruction &ins, uint32_t temporaries_begin) const {
+        switch (ins.op) {
+        case opcode::JUMP:
+        case opcode::HALT:
+        case opcode::PRINT_SPACE:
+        case opcode::PRINT_NEWLINE:
+            return;
+
+        case opcode::JUMP_IF_ZERO:
+            ins.b = relocate_register(ins.b, temporaries_begin);
+            return;
+
+        case opcode::JUMP_UNLESS_EQUAL:
+        case opcode::JUMP_UNLESS_LESS:
+        case opcode::JUMP_UNLESS_BIGGER:
+        case opcode::JUMP_UNLESS_LESS_OR_EQUAL:
+        case opcode::JUMP_UNLESS_BIGGER_OR_EQUAL:
+            ins.b = relocate_register(ins.b, temporaries_begin);
+            ins.c = relocate_register(ins.c, temporaries_begin);
+            return;
+
+        case opcode::SCAN:
+        case opcode::PRINT:
+            ins.a = relocate_register(ins.a, temporaries_begin);
+            return;
+
+        case opcode::MOVE:
+        case opcode::NEGATE:
+            ins.a = relocate_register(ins.a, temporaries_begin);
+            ins.b = relocate_register(ins.b, temporaries_begin);
+            return;
+
+        default:
+            ins.a = relocate_register(ins.a, temporaries_begin);
+            ins.b = relocate_register(ins.b, temporaries_begin);
+            ins.c = relocate_register(ins.c, temporaries_begin);
+            return;
+        }
+    }
+
+    size_t emit(opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+        program_.code.push_back({op, a, b, c});
+        return program_.code.size() - 1;
+    }
+
+    uint32_t current_address() const {
+        return static_cast<uint32_t>(program_.code.size());
+    }
+
+    // Only variables that compiled code uses get registers, so
+    // that frame stays small even when context is huge:
+    uint32_t get_variable(const id_node &variable) {
+        size_t slot = variable.get_slot();
+        assert(slot < context_.get_variable_count() && "variable wasn't created in context");
+
+        auto [it, inserted] = variables_.try_emplace(slot, program_.variables.size());
+        if (inserted)
+            program_.variables.push_back({slot, context_.get_name(slot)});
+
+        return VARIABLE | it->second;
+    }
+
+    uint32_t get_constant(int64_t value) {
+        auto [it, inserted] = constants_.try_emplace(value, program_.constants.size());
+        if (inserted)
+            program_.constants.push_back(value);
+
+        return CONSTANT | it->second;
+    }
+
+    uint32_t allocate_temporary() {
+        uint32_t reg = TEMPORARY | temporaries_ ++;
+        max_temporaries_ = std::max(max_temporaries_, temporaries_);
+        return reg;
+    }
+
+    static opcode get_operation(const node &operation) {
+        switch (operation.get_kind()) {
+        case node_kind::PLUS_ASSIGN:
+        case node_kind::PLUS:            return opcode::ADD;
+        case node_kind::MINUS_ASSIGN:
+        case node_kind::MINUS:           return opcode::SUBTRACT;
+        case node_kind::MULTIPLY_ASSIGN:
+        case node_kind::MULTIPLY:        return opcode::MULTIPLY;
+        case node_kind::DIVIDE_ASSIGN:
+        case node_kind::DIVIDE:
+            return is_divisor_checked(operation) ? opcode::DIVIDE : opcode::DIVIDE_UNCHECKED;
+        case node_kind::EQUAL:           return opcode::EQUAL;
+        case node_kind::LESS:            return opcode::LESS;
+        case node_kind::BIGGER:          return opcode::BIGGER;
+        case node_kind::LESS_OR_EQUAL:   return opcode::LESS_OR_EQUAL;
+        case node_kind::BIGGER_OR_EQUAL: return opcode::BIGGER_OR_EQUAL;
+        default:
+            assert(false && "node is not a binary operation");
+            return opcode::HALT;
+        }
+    }
+
+    static std::optional<opcode> get_inverted_branch(node_kind kind) {
+        switch (kind) {
+        case node_kind::EQUAL:           return opcode::JUMP_UNLESS_EQUAL;
+        case node_kind::LESS:            return opcode::JUMP_UNLESS_LESS;
+        case node_kind::BIGGER:          return opcode::JUMP_UNLESS_BIGGER;
+        case node_kind::LESS_OR_EQUAL:   return opcode::JUMP_UNLESS_LESS_OR_EQUAL;
+        case node_kind::BIGGER_OR_EQUAL: return opcode::JUMP_UNLESS_BIGGER_OR_EQUAL;
+        default:                         return std::nullopt;
+        }
+    }
+
+    // Returns register holding value of the expression. If target is given,
+    // result is guaranteed to end up there, otherwise it can be any register,
+    // including registers of variables and constants (which must not be written).
+    uint32_t compile_expression(const node &expression, std::optional<uint32_t> target = std::nullopt) {
+        if (is_replacement(expression.get_kind()))
+            return compile_expression(get_unfused(expression), target);
+
+        uint32_t result = 0;
+
+        switch (expression.get_kind()) {
+        case node_kind::NUMBER:
+            result = get_constant(static_cast<const number_node&>(expression).get_number());
+            break;
+
+        case node_kind::ID:
+            result = get_variable(static_cast<const id_node&>(expression));
+            break;
+
+        case node_kind::SCAN:
+            result = target ? *target : allocate_temporary();
+            emit(opcode::SCAN, result);
+            return result;
+
+        case node_kind::NEGATE: {
+            uint32_t mark = temporaries_;
+            uint32_t child = compile_expression(static_cast<const negate_node&>(expression).get_child());
+
+            // Operands are read before result is written, so their temporaries can be reused:
+            temporaries_ = mark;
+            result = target ? *target : allocate_temporary();
+            emit(opcode::NEGATE, result, child);
+            return result;
+        }
+
+        default: {
+            assert(is_arithmetic_or_comparison(expression.get_kind()));
+            const auto &binary = static_cast<const binary_node&>(expression);
+
+            uint32_t mark = temporaries_;
+            uint32_t left  = compile_expression(binary.get_left());
+            uint32_t right = compile_expression(binary.get_right());
+
+            temporaries_ = mark;
+            result = target ? *target : allocate_temporary();
+            emit(get_operation(expression), result, left, right);
+            return result;
+        }
+        }
+
+        if (target && *target != result)
+            emit(opcode::MOVE, *target, result);
+
+        return target ? *target : result;
+    }
+
+    // Emits jump to a yet unknown address, that is taken when condition
+    // is false, returns index of the jump so it can be patched later:
+    size_t compile_branch_unless(const node &condition) {
+        if (is_replacement(condition.get_kind()))
+            return compile_branch_unless(get_unfused(condition));
+
+        if (std::optional<opcode> branch = get_inverted_branch(condition.get_kind())) {
+            const auto &comparison = static_cast<const binary_node&>(condition);
+
+            uint32_t left  = compile_expression(comparison.get_left());
+            uint32_t right = compile_expression(comparison.get_right());
+            return emit(*branch, 0, left, right);
+        }
+
+        uint32_t value = compile_expression(condition);
+        return emit(opcode::JUMP_IF_ZERO, 0, value);
+    }
+
+    void compile_assignment(const binary_node &assignment) {
+        assert(assignment.get_left().get_kind() == node_kind::ID && "can only assign to variables");
+        uint32_t variable = get_variable(static_cast<const id_node&>(assignment.get_left()));
+
+        if (assignment.get_kind() == node_kind::ASSIGN) {
+            compile_expression(assignment.get_right(), variable);
+            return;
+        }
+
+        uint32_t right = compile_expression(assignment.get_right());
+        emit(get_operation(assignment), variable, variable, right);
+    }
+
+    void compile_function(const function_node &function) {
+        if (function.get_name() != "print")
+            return; // other functions aren't implemented yet
+
+        bool first = true;
+        for (const auto &arg: function.get_args()) {
+            if (!first)
+                emit(opcode::PRINT_SPACE);
+
+            emit(opcode::PRINT, compile_expression(*arg));
+            temporaries_ = 0;
+
+            first = false;
+        }
+
+        emit(opcode::PRINT_NEWLINE);
+    }
+
+    void compile_statement(const node &statement) {
+        if (is_replacement(statement.get_kind())) {
+            compile_statement(get_unfused(statement));
+            return;
+        }
+
+        switch (statement.get_kind()) {
+        case node_kind::FUNCTION:
+            compile_function(static_cast<const function_node&>(statement));
+            break;
+
+        case node_kind::IF: {
+            const auto &if_statement = static_cast<const if_node&>(statement);
+
+            size_t skip = compile_branch_unless(if_statement.get_condition());
+            temporaries_ = 0;
+
+            compile_scope(if_statement.get_scope());
+            program_.code[skip].a = current_address();
+            break;
+        }
+
+        case node_kind::WHILE: {
+            const auto &while_statement = static_cast<const while_node&>(statement);
+
+            uint32_t loop_begin = current_address();
+            size_t exit = compile_branch_unless(while_statement.get_condition());
+            temporaries_ = 0;
+
+            compile_scope(while_statement.get_scope());
+            emit(opcode::JUMP, loop_begin);
+
+            program_.code[exit].a = current_address();
+            break;
+        }
+
+        default:
+            if (is_assignment(statement.get_kind())) {
+                compile_assignment(static_cast<const binary_node&>(statement));
+                break;
+            }
+
+            // Expression statement, only its side effects matter:
+            compile_expression(statement);
+            break;
+        }
+
+        temporaries_ = 0;
+    }
+
+    void compile_scope(const node_list &scope) {
+        for (const auto &statement: scope)
+            compile_statement(*statement);
+    }
+};
+
+} // end anonymous namespace
+
+bytecode compile_bytecode(const node_list &scope, const context &ctx) {
+    bytecode_compiler compiler{ctx};
+    return compiler.compile(scope);
+}
+
+bytecode compile_bytecode(const node &statement, const context &ctx) {
+    bytecode_compiler compiler{ctx};
+    return compiler.compile(statement);
+}
+
+} // end namespace paracl
@@ -1,21 +1,232 @@
 #include "paracl/lexer/lexer.h"
 #include "paracl/text/file.h"
 #include "paracl/ast/ast.h"
+#include "paracl/ast/closures.h"
+#include "paracl/ast/flat.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+#include "paracl/ast/switch_evaluator.h"
+#include "paracl/interpreter/bytecode.h"
+#include "paracl/interpreter/vm.h"
+#include "paracl/interpreter/jit.h"
+#include "paracl/interpreter/tiering.h"
+#include "paracl/ir/ir.h"
+#include "paracl/optimizer/pass_manager.h"
+#include "paracl/optimizer/specialization.h"
 
+#include <charconv>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+bool parse_number(std::string_view text, size_t &number) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+    return error == std::errc{} && end == text.data() + text.size();
+}
+
+// Comma separated list of numbers
+bool parse_numbers(std::string_view text, std::vector<int64_t> &numbers) {
+    while (!text.empty()) {
+        size_t comma = std::min(text.find(','), text.size());
+
+        int64_t number = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + comma, number);
+        if (error != std::errc{} || end != text.data() + comma)
+            return false;
+
+        numbers.push_back(number);
+        text.remove_prefix(std::min(comma + 1, text.size()));
+    }
+
+    return true;
+}
+
+} // end anonymous namespace
 
 
 int main(int argc, const char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " [FILE]\n";
+    std::string_view engine = "tiered";
+    bool dump_bytecode = false;
+    bool dump_ast = false;
+    bool dump_source = false;
+    bool stats = false;
+    bool verify_passes = false;
+
+    // Remarks of passes, as annotated source or as JSON
+    std::optional<std::string_view> remarks_format;
+
+    paracl::pass_manager pipeline(paracl::get_default_passes());
+
+    paracl::tiering_options tiering{};
+
+    // Known prefix of input, program is specialized for it
+    std::vector<int64_t> known_input;
+
+    // Input for scan, instead of stdin
+    const char *input_filename = nullptr;
+
+    const char *filename = nullptr;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; ++ i) {
+        std::string_view arg = argv[i];
+
+        if (arg.starts_with("--engine="))
+            engine = arg.substr(std::string_view("--engine=").size());
+        else if (arg == "-O0" || arg == "-O1")
+            pipeline = arg == "-O1" ? paracl::pass_manager(paracl::get_default_passes()) : paracl::pass_manager();
+        else if (arg.starts_with("--passes=")) {
+            std::optional<paracl::pass_manager> passes =
+                paracl::pass_manager::parse(arg.substr(std::string_view("--passes=").size()));
+
+            valid = passes.has_value();
+            if (passes)
+                pipeline = std::move(*passes);
+        }
+        else if (arg == "--verify-passes")
+            verify_passes = true;
+        else if (arg == "--remarks" || arg == "--remarks=json")
+            remarks_format = arg == "--remarks" ? "text" : "json";
+        else if (arg == "--dump-bytecode")
+            dump_bytecode = true;
+        else if (arg == "--dump-ast")
+            dump_ast = true;
+        else if (arg == "--dump-source")
+            dump_source = true;
+        else if (arg.starts_with("--specialize="))
+            valid = parse_numbers(arg.substr(std::string_view("--specialize=").size()), known_input);
+        else if (arg.starts_with("--input="))
+            input_filename = argv[i] + std::string_view("--input=").size();
+        else if (arg == "--stats")
+            stats = true;
+        else if (arg == "--trace-tiering")
+            tiering.trace = &std::cerr;
+        else if (arg.starts_with("--tier-threshold="))
+            valid = parse_number(arg.substr(std::string_view("--tier-threshold=").size()),
+                                 tiering.hotness_threshold);
+        else if (!filename && !arg.starts_with("-"))
+            filename = argv[i];
+        else
+            valid = false;
+    }
+
+    if (engine != "tiered" && engine != "tree" && engine != "bytecode" && engine != "jit" &&
+        engine != "closures" && engine != "flat" && engine != "switch" && engine != "ir")
+        valid = false;
+
+    if (!filename || !valid) {
+        std::cerr << "Usage: " << argv[0] << " [-O0|-O1|--passes=PASS,...] [--verify-passes] [--remarks[=json]] [--engine=tiered|tree|switch|flat|closures|bytecode|jit|ir]"
+                     " [--dump-bytecode|--dump-ast|--dump-source] [--specialize=N,...] [--input=FILE] [--stats]"
+                     " [--trace-tiering] [--tier-threshold=N] [FILE]\n";
         return EXIT_FAILURE;
     }
 
-    std::string filename = argv[1];
-    std::string text = paracl::read_file(filename);
+    paracl::file source{filename, paracl::read_file(filename)};
 
-    std::vector<paracl::token> tokens = paracl::tokenize(text);
+    std::vector<paracl::token> tokens = paracl::tokenize(source.text);
 
     paracl::ast ast(tokens);
-    ast.run();
+
+    // Known values that no read was replaced with are still read by the program:
+    size_t replaced = 0;
+    if (!known_input.empty()) {
+        replaced = paracl::specialize_input(ast, known_input);
+        if (stats)
+            std::cerr << "specialization: " << replaced << "\n";
+    }
+
+    if (verify_passes)
+        pipeline.set_verification(true);
+
+    paracl::optimization_remarks remarks;
+    if (remarks_format)
+        pipeline.set_remarks(&remarks);
+
+    pipeline.run(ast);
+    if (stats)
+        pipeline.dump_statistics();
+
+    if (remarks_format == "text")
+        remarks.print(source);
+    else if (remarks_format == "json")
+        remarks.dump_json();
+
+    // Bytecode is either compiled from the tree or lowered from its SSA form:
+    auto compile = [&] {
+        if (engine != "ir")
+            return paracl::compile_bytecode(ast.get_scope(), ast.get_context());
+
+        paracl::ir::function function = paracl::ir::build_ir(ast.get_scope(), ast.get_context());
+        return paracl::compile_bytecode(function, ast.get_context());
+    };
+
+    if (dump_ast) {
+        ast.dump();
+        std::cout << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (dump_source) {
+        ast.dump_source();
+        return EXIT_SUCCESS;
+    }
+
+    if (dump_bytecode) {
+        compile().dump();
+        return EXIT_SUCCESS;
+    }
+
+    // Program's output bypasses std::cout, which already has everything printed before it:
+    std::cout.flush();
+
+    paracl::output_sink &output = paracl::get_output();
+    output.write_to(STDOUT_FILENO, paracl::output_sink::flush_policy::detect(STDOUT_FILENO));
+
+    // Regular input file is parsed in place, pipes and stdin are read in blocks:
+    std::optional<paracl::mapped_file> input_file;
+    if (input_filename) {
+        input_file.emplace(input_filename);
+        if (input_file->get_descriptor() >= 0)
+            paracl::get_input().read_from(input_file->get_descriptor());
+        else
+            paracl::get_input().read_from(input_file->get_text());
+    } else {
+        paracl::get_input().read_from(STDIN_FILENO);
+    }
+
+    paracl::get_input().read_first(std::span(known_input).subspan(replaced));
+
+    // Output is flushed at exit, but it doesn't happen if program fails:
+    try {
+        if (engine == "tree") {
+            ast.run();
+        } else if (engine == "switch") {
+            paracl::switch_evaluator evaluator(ast.get_context());
+            evaluator.run(ast.get_scope());
+        } else if (engine == "flat") {
+            paracl::flat_ast flat(ast.get_scope(), ast.get_context());
+            flat.run(ast.get_context());
+        } else if (engine == "closures") {
+            paracl::compile_scope(ast.get_scope(), ast.get_context())();
+        } else if (engine == "tiered") {
+            paracl::tiered_engine tiered(ast.get_context(), tiering);
+            tiered.run(ast.get_scope());
+        } else if (engine == "jit") {
+            paracl::jit native(ast.get_context());
+            native.run(ast.get_scope());
+        } else {
+            paracl::bytecode program = compile();
+
+            paracl::vm machine;
+            machine.run(program, ast.get_context());
+        }
+    } catch (...) {
+        output.flush();
+        throw;
+    }
 }
@@ -0,0 +1,671 @@
+#include "paracl/interpreter/jit.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define PARACL_JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+
+namespace paracl {
+
+#ifdef PARACL_JIT_SUPPORTED
+
+namespace {
+
+// Compiled loop is called as a function that takes pointer to context's
+// variables and returns status, it never calls anything itself:
+using native_function = int64_t (*)(int64_t *variables);
+
+enum status: int64_t {
+    OK = 0,
+    DIVIDE_BY_ZERO = 1,
+};
+
+
+enum reg: uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8,  R9,  R10, R11, R12, R13, R14, R15
+};
+
+// Callee-saved, so that prologue and epilogue are the only places to care about them:
+constexpr reg VARIABLE_REGISTERS[] = { RBX, R12, R13, R14, R15 };
+
+// Pointer to variables, passed as the first argument:
+constexpr reg VARIABLES = RDI;
+
+
+// Stencils below are precompiled instruction templates, code is generated by copying
+// them one after another and patching holes: register fields of REX and ModRM bytes,
+// displacements of variables, immediates and jump offsets.
+
+uint8_t rex_w(reg r, reg rm) {
+    return 0x48 | ((r >> 3) << 2) | (rm >> 3);
+}
+
+uint8_t modrm(uint8_t mod, uint8_t r, uint8_t rm) {
+    return static_cast<uint8_t>((mod << 6) | ((r & 7) << 3) | (rm & 7));
+}
+
+enum condition_code: uint8_t {
+    EQUAL_CC         = 0x4,
+    NOT_EQUAL_CC     = 0x5,
+    LESS_CC          = 0xC,
+    BIGGER_EQUAL_CC  = 0xD,
+    LESS_EQUAL_CC    = 0xE,
+    BIGGER_CC        = 0xF,
+};
+
+std::optional<condition_code> get_condition_code(node_kind kind) {
+    switch (kind) {
+    case node_kind::EQUAL:           return EQUAL_CC;
+    case node_kind::LESS:            return LESS_CC;
+    case node_kind::BIGGER:          return BIGGER_CC;
+    case node_kind::LESS_OR_EQUAL:   return LESS_EQUAL_CC;
+    case node_kind::BIGGER_OR_EQUAL: return BIGGER_EQUAL_CC;
+    default:                         return std::nullopt;
+    }
+}
+
+condition_code invert(condition_code code) {
+    // Condition codes come in pairs that differ only in the lowest bit
+    return static_cast<condition_code>(code ^ 1);
+}
+
+bool fits_in_int32(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+
+class code_buffer {
+public:
+    void emit(std::initializer_list<uint8_t> stencil) {
+        bytes_.insert(bytes_.end(), stencil.begin(), stencil.end());
+    }
+
+    void emit32(int32_t value) { emit_raw(&value, sizeof(value)); }
+    void emit64(int64_t value) { emit_raw(&value, sizeof(value)); }
+
+    void patch32(size_t offset, int32_t value) {
+        std::memcpy(bytes_.data() + offset, &value, sizeof(value));
+    }
+
+    size_t size() const {
+        return bytes_.size();
+    }
+
+    const std::vector<uint8_t> &get_bytes() const {
+        return bytes_;
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+
+    void emit_raw(const void *data, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), bytes, bytes + size);
+    }
+};
+
+
+class executable_memory {
+public:
+    explicit executable_memory(const std::vector<uint8_t> &code):
+        size_(code.size()) {
+
+        void *memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            throw std::runtime_error("can't allocate memory for jit");
+
+        std::memcpy(memory, code.data(), size_);
+
+        // Never writable and executable at the same time:
+        if (mprotect(memory, size_, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, size_);
+            throw std::runtime_error("can't make jit memory executable");
+        }
+
+        memory_ = memory;
+    }
+
+    executable_memory(const executable_memory&) = delete;
+    executable_memory &operator=(const executable_memory&) = delete;
+
+    ~executable_memory() {
+        munmap(memory_, size_);
+    }
+
+    native_function get_function() const {
+        return reinterpret_cast<native_function>(memory_);
+    }
+
+private:
+    void *memory_;
+    size_t size_;
+};
+
+
+class loop_compiler {
+public:
+    // Returns nothing if loop contains anything jit doesn't support
+    std::optional<code_buffer> compile(const while_node &loop) {
+        if (!is_supported(loop))
+            return std::nullopt;
+
+        allocate_registers();
+
+        emit_prologue();
+        compile_statement(loop);
+
+        emit_xor_eax();
+        size_t epilogue = code_.size();
+        emit_epilogue();
+
+        // Division by zero jumps here, it sets status and leaves through common epilogue,
+        // so variables held in registers are still written back. Operands that were
+        // pushed while evaluating the expression are dropped with the frame pointer:
+        size_t divide_by_zero = code_.size();
+        emit_move(RSP, RBP);
+        code_.emit({ 0xB8 }); code_.emit32(DIVIDE_BY_ZERO);     // mov eax, imm32
+        emit_jump_to(epilogue);
+
+        for (size_t site: divide_by_zero_jumps_)
+            patch_jump(site, divide_by_zero);
+
+        return std::move(code_);
+    }
+
+private:
+    code_buffer code_;
+
+    std::unordered_map<size_t, size_t> slot_uses_;
+    std::vector<std::pair<size_t, reg>> registers_;
+
+    std::vector<size_t> divide_by_zero_jumps_;
+
+
+    template <bool is_loop>
+    bool is_conditional_supported(const conditional_operation_node<is_loop> &conditional) {
+        if (!is_supported(conditional.get_condition()))
+            return false;
+
+        return std::ranges::all_of(conditional.get_scope(), [&](const auto &statement) {
+            return is_supported(*statement);
+        });
+    }
+
+    bool is_supported(const node &tree) {
+        if (is_replacement(tree.get_kind()))
+            return is_supported(get_unfused(tree));
+
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+            return true;
+
+        case node_kind::ID: {
+            size_t slot = static_cast<const id_node&>(tree).get_slot();
+            if (slot > INT32_MAX / sizeof(int64_t))
+                return false;
+
+            ++ slot_uses_[slot];
+            return true;
+        }
+
+        case node_kind::NEGATE:
+            return is_supported(static_cast<const negate_node&>(tree).get_child());
+
+        case node_kind::IF:
+            return is_conditional_supported(static_cast<const if_node&>(tree));
+
+        case node_kind::WHILE:
+            return is_conditional_supported(static_cast<const while_node&>(tree));
+
+        default:
+            if (!is_assignment(tree.get_kind()) && !is_arithmetic_or_comparison(tree.get_kind()))
+                return false;
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            if (is_assignment(tree.get_kind()) && binary.get_left().get_kind() != node_kind::ID)
+                return false;
+
+            return is_supported(binary.get_left()) && is_supported(binary.get_right());
+        }
+    }
+
+    void allocate_registers() {
+        std::vector<std::pair<size_t, size_t>> uses(slot_uses_.begin(), slot_uses_.end());
+        std::ranges::sort(uses, [](auto lhs, auto rhs) {
+            return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+        });
+
+        size_t count = std::min(uses.size(), std::size(VARIABLE_REGISTERS));
+        for (size_t i = 0; i < count; ++ i)
+            registers_.emplace_back(uses[i].first, VARIABLE_REGISTERS[i]);
+    }
+
+    std::optional<reg> get_register(size_t slot) const {
+        for (auto [allocated_slot, r]: registers_)
+            if (allocated_slot == slot)
+                return r;
+
+        return std::nullopt;
+    }
+
+    static int32_t get_displacement(size_t slot) {
+        return static_cast<int32_t>(slot * sizeof(int64_t));
+    }
+
+
+    // Stencils for moving values around:
+
+    void emit_move(reg dst, reg src) {
+        code_.emit({ rex_w(src, dst), 0x89, modrm(0b11, src, dst) });           // mov dst, src
+    }
+
+    void emit_load_memory(reg dst, size_t slot) {
+        code_.emit({ rex_w(dst, VARIABLES), 0x8B, modrm(0b10, dst, VARIABLES) }); // mov dst, [rdi + disp32]
+        code_.emit32(get_displacement(slot));
+    }
+
+    void emit_store_memory(size_t slot, reg src) {
+        code_.emit({ rex_w(src, VARIABLES), 0x89, modrm(0b10, src, VARIABLES) }); // mov [rdi + disp32], src
+        code_.emit32(get_displacement(slot));
+    }
+
+    void emit_load_immediate(reg dst, int64_t value) {
+        if (fits_in_int32(value)) {
+            code_.emit({ rex_w(RAX, dst), 0xC7, modrm(0b11, 0, dst) });         // mov dst, imm32
+            code_.emit32(static_cast<int32_t>(value));
+            return;
+        }
+
+        code_.emit({ rex_w(RAX, dst), static_cast<uint8_t>(0xB8 + (dst & 7)) }); // mov dst, imm64
+        code_.emit64(value);
+    }
+
+    void emit_load_variable(reg dst, size_t slot) {
+        if (std::optional<reg> allocated = get_register(slot))
+            emit_move(dst, *allocated);
+        else
+            emit_load_memory(dst, slot);
+    }
+
+    void emit_store_variable(size_t slot, reg src) {
+        if (std::optional<reg> allocated = get_register(slot))
+            emit_move(*allocated, src);
+        else
+            emit_store_memory(slot, src);
+    }
+
+    void emit_push(reg r) {
+        if (r >= R8) code_.emit({ 0x41 });
+        code_.emit({ static_cast<uint8_t>(0x50 + (r & 7)) });                    // push r
+    }
+
+    void emit_pop(reg r) {
+        if (r >= R8) code_.emit({ 0x41 });
+        code_.emit({ static_cast<uint8_t>(0x58 + (r & 7)) });                    // pop r
+    }
+
+    void emit_xor_eax() {
+        code_.emit({ 0x31, 0xC0 });                                              // xor eax, eax
+    }
+
+
+    // Stencils for control flow, return offset of rel32 to patch:
+
+    size_t emit_jump() {
+        code_.emit({ 0xE9 });                                                    // jmp rel32
+        code_.emit32(0);
+        return code_.size() - sizeof(int32_t);
+    }
+
+    size_t emit_jump_if(condition_code code) {
+        code_.emit({ 0x0F, static_cast<uint8_t>(0x80 | code) });                 // jcc rel32
+        code_.emit32(0);
+        return code_.size() - sizeof(int32_t);
+    }
+
+    void patch_jump(size_t site, size_t target) {
+        int64_t offset = static_cast<int64_t>(target) - static_cast<int64_t>(site + sizeof(int32_t));
+        code_.patch32(site, static_cast<int32_t>(offset));
+    }
+
+    void emit_jump_to(size_t target) {
+        patch_jump(emit_jump(), target);
+    }
+
+
+    // Frame pointer is where saved registers end, epilogue can be reached from the
+    // middle of an expression by restoring stack pointer from it
+    void emit_prologue() {
+        emit_push(RBP);
+        for (auto [slot, r]: registers_)
+            emit_push(r);
+
+        emit_move(RBP, RSP);
+
+        for (auto [slot, r]: registers_)
+            emit_load_memory(r, slot);
+    }
+
+    void emit_epilogue() {
+        for (auto [slot, r]: registers_)
+            emit_store_memory(slot, r);
+
+        for (auto it = registers_.rbegin(); it != registers_.rend(); ++ it)
+            emit_pop(it->second);
+
+        emit_pop(RBP);
+        code_.emit({ 0xC3 });                                                    // ret
+    }
+
+
+    // Stencils for operations, all of them compute rax = rax <op> rcx:
+
+    void emit_operation(const node &operation) {
+        switch (operation.get_kind()) {
+        case node_kind::PLUS_ASSIGN:
+        case node_kind::PLUS:
+            code_.emit({ 0x48, 0x01, 0xC8 });                                    // add rax, rcx
+            return;
+
+        case node_kind::MINUS_ASSIGN:
+        case node_kind::MINUS:
+            code_.emit({ 0x48, 0x29, 0xC8 });                                    // sub rax, rcx
+            return;
+
+        case node_kind::MULTIPLY_ASSIGN:
+        case node_kind::MULTIPLY:
+            code_.emit({ 0x48, 0x0F, 0xAF, 0xC1 });                              // imul rax, rcx
+            return;
+
+        case node_kind::DIVIDE_ASSIGN:
+        case node_kind::DIVIDE:
+            if (is_divisor_checked(operation)) {
+                code_.emit({ 0x48, 0x85, 0xC9 });                                // test rcx, rcx
+                divide_by_zero_jumps_.push_back(emit_jump_if(EQUAL_CC));         // jz divide_by_zero
+            }
+
+            code_.emit({ 0x48, 0x99 });                                          // cqo
+            code_.emit({ 0x48, 0xF7, 0xF9 });                                    // idiv rcx
+            return;
+
+        default: {
+            std::optional<condition_code> code = get_condition_code(operation.get_kind());
+            assert(code && "unknown operation");
+
+            code_.emit({ 0x48, 0x39, 0xC8 });                                    // cmp rax, rcx
+            code_.emit({ 0x0F, static_cast<uint8_t>(0x90 | *code), 0xC0 });      // setcc al
+            code_.emit({ 0x0F, 0xB6, 0xC0 });                                    // movzx eax, al
+            return;
+        }
+        }
+    }
+
+
+    static bool is_leaf(const node &expression) {
+        return expression.get_kind() == node_kind::ID || expression.get_kind() == node_kind::NUMBER;
+    }
+
+    void load_leaf(reg dst, const node &leaf) {
+        if (leaf.get_kind() == node_kind::NUMBER)
+            emit_load_immediate(dst, static_cast<const number_node&>(leaf).get_number());
+        else
+            emit_load_variable(dst, static_cast<const id_node&>(leaf).get_slot());
+    }
+
+    // Leaves left operand in rax and right in rcx. Compiled expressions have no side
+    // effects except for division by zero, so order of evaluation doesn't matter.
+    void compile_operands(const binary_node &binary) {
+        if (is_leaf(binary.get_right())) {
+            compile_expression(binary.get_left());
+            load_leaf(RCX, binary.get_right());
+            return;
+        }
+
+        compile_expression(binary.get_right());
+        emit_push(RAX);
+        compile_expression(binary.get_left());
+        emit_pop(RCX);
+    }
+
+    // Leaves result in rax
+    void compile_expression(const node &expression) {
+        if (is_replacement(expression.get_kind())) {
+            compile_expression(get_unfused(expression));
+            return;
+        }
+
+        switch (expression.get_kind()) {
+        case node_kind::NUMBER:
+        case node_kind::ID:
+            load_leaf(RAX, expression);
+            return;
+
+        case node_kind::NEGATE:
+            compile_expression(static_cast<const negate_node&>(expression).get_child());
+            code_.emit({ 0x48, 0xF7, 0xD8 });                                    // neg rax
+            return;
+
+        default: {
+            const auto &binary = static_cast<const binary_node&>(expression);
+            compile_operands(binary);
+            emit_operation(expression);
+            return;
+        }
+        }
+    }
+
+    // Returns jump taken when condition is false
+    size_t compile_branch_unless(const node &condition) {
+        if (is_replacement(condition.get_kind()))
+            return compile_branch_unless(get_unfused(condition));
+
+        if (std::optional<condition_code> code = get_condition_code(condition.get_kind())) {
+            compile_operands(static_cast<const binary_node&>(condition));
+            code_.emit({ 0x48, 0x39, 0xC8 });                                    // cmp rax, rcx
+            return emit_jump_if(invert(*code));
+        }
+
+        compile_expression(condition);
+        code_.emit({ 0x48, 0x85, 0xC0 });                                        // test rax, rax
+        return emit_jump_if(EQUAL_CC);
+    }
+
+    bool compile_increment(size_t slot, node_kind kind, const node &right) {
+        if (kind != node_kind::PLUS_ASSIGN && kind != node_kind::MINUS_ASSIGN)
+            return false;
+
+        if (right.get_kind() != node_kind::NUMBER)
+            return false;
+
+        int64_t value = static_cast<const number_node&>(right).get_number();
+        if (!fits_in_int32(value))
+            return false;
+
+        uint8_t extension = kind == node_kind::PLUS_ASSIGN ? 0 : 5;
+        if (std::optional<reg> allocated = get_register(slot)) {
+            code_.emit({ rex_w(RAX, *allocated), 0x81,
+                         modrm(0b11, extension, *allocated) });                  // add/sub r, imm32
+        } else {
+            code_.emit({ rex_w(RAX, VARIABLES), 0x81,
+                         modrm(0b10, extension, VARIABLES) });                   // add/sub [rdi + disp32], imm32
+            code_.emit32(get_displacement(slot));
+        }
+
+        code_.emit32(static_cast<int32_t>(value));
+        return true;
+    }
+
+    void compile_assignment(const binary_node &assignment) {
+        size_t slot = static_cast<const id_node&>(assignment.get_left()).get_slot();
+
+        if (assignment.get_kind() == node_kind::ASSIGN) {
+            compile_expression(assignment.get_right());
+            emit_store_variable(slot, RAX);
+            return;
+        }
+
+        if (compile_increment(slot, assignment.get_kind(), assignment.get_right()))
+            return;
+
+        if (is_leaf(assignment.get_right()))
+            load_leaf(RCX, assignment.get_right());
+        else {
+            compile_expression(assignment.get_right());
+            emit_move(RCX, RAX);
+        }
+
+        emit_load_variable(RAX, slot);
+        emit_operation(assignment);
+        emit_store_variable(slot, RAX);
+    }
+
+    void compile_statement(const node &statement) {
+        if (is_replacement(statement.get_kind())) {
+            compile_statement(get_unfused(statement));
+            return;
+        }
+
+        switch (statement.get_kind()) {
+        case node_kind::IF: {
+            const auto &if_statement = static_cast<const if_node&>(statement);
+
+            size_t skip = compile_branch_unless(if_statement.get_condition());
+            for (const auto &nested: if_statement.get_scope())
+                compile_statement(*nested);
+
+            patch_jump(skip, code_.size());
+            return;
+        }
+
+        case node_kind::WHILE: {
+            const auto &while_statement = static_cast<const while_node&>(statement);
+
+            size_t loop_begin = code_.size();
+            size_t exit = compile_branch_unless(while_statement.get_condition());
+            for (const auto &nested: while_statement.get_scope())
+                compile_statement(*nested);
+
+            emit_jump_to(loop_begin);
+            patch_jump(exit, code_.size());
+            return;
+        }
+
+        default:
+            // Values of dead stores are still computed, for division to fail on zero:
+            if (!is_assignment(statement.get_kind())) {
+                compile_expression(statement);
+                return;
+            }
+
+            compile_assignment(static_cast<const binary_node&>(statement));
+            return;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+class native_loop {
+public:
+    explicit native_loop(const code_buffer &code):
+        memory_(code.get_bytes()) {}
+
+    void run(context &ctx) const {
+        if (memory_.get_function()(ctx.get_variables()) == DIVIDE_BY_ZERO)
+            throw std::runtime_error("divide by zero");
+    }
+
+private:
+    executable_memory memory_;
+};
+
+bool jit::is_available() {
+    return true;
+}
+
+#else
+
+class native_loop {
+public:
+    void run(context&) const {}
+};
+
+bool jit::is_available() {
+    return false;
+}
+
+#endif
+
+
+jit::jit(context &ctx):
+    context_(ctx) {}
+
+jit::~jit() = default;
+
+void jit::run(const node_list &scope) {
+    execute_scope(scope);
+}
+
+size_t jit::get_compiled_loop_count() const {
+    return std::ranges::count_if(loops_, [](const auto &loop) {
+        return loop.second != nullptr;
+    });
+}
+
+void jit::execute_scope(const node_list &scope) {
+    for (const auto &statement: scope) {
+        // Fused loops are run through their original, which can be compiled,
+        // closed form loops are run as they are:
+        node &current = statement->get_kind() == node_kind::FUSED ? get_unfused(*statement) : *statement;
+
+        switch (current.get_kind()) {
+        case node_kind::WHILE:
+            execute_loop(static_cast<while_node&>(current));
+            break;
+
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(current);
+            if (if_statement.get_condition()->execute(context_) != 0)
+                execute_scope(if_statement.get_scope());
+            break;
+        }
+
+        default:
+            statement->execute(context_);
+            break;
+        }
+    }
+}
+
+void jit::execute_loop(while_node &loop) {
+    auto [it, inserted] = loops_.try_emplace(&loop);
+
+#ifdef PARACL_JIT_SUPPORTED
+    if (inserted) {
+        loop_compiler compiler;
+        if (std::optional<code_buffer> code = compiler.compile(loop))
+            it->second = std::make_unique<native_loop>(*code);
+    }
+#endif
+
+    if (it->second) {
+        it->second->run(context_);
+        return;
+    }
+
+    while (loop.get_condition()->execute(context_) != 0)
+        execute_scope(loop.get_scope());
+}
+
+} // end namespace paracl
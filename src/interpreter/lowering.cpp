@@ -0,0 +1,327 @@
+#include "paracl/interpreter/bytecode.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+
+namespace paracl {
+
+namespace {
+
+opcode get_operation(ir::opcode op) {
+    switch (op) {
+    case ir::opcode::NEGATE:          return opcode::NEGATE;
+    case ir::opcode::ADD:             return opcode::ADD;
+    case ir::opcode::SUBTRACT:        return opcode::SUBTRACT;
+    case ir::opcode::MULTIPLY:        return opcode::MULTIPLY;
+    case ir::opcode::DIVIDE:          return opcode::DIVIDE;
+    case ir::opcode::EQUAL:           return opcode::EQUAL;
+    case ir::opcode::LESS:            return opcode::LESS;
+    case ir::opcode::BIGGER:          return opcode::BIGGER;
+    case ir::opcode::LESS_OR_EQUAL:   return opcode::LESS_OR_EQUAL;
+    case ir::opcode::BIGGER_OR_EQUAL: return opcode::BIGGER_OR_EQUAL;
+    default:
+        assert(false && "instruction is not an operation");
+        return opcode::HALT;
+    }
+}
+
+opcode get_inverted_branch(ir::opcode op) {
+    switch (op) {
+    case ir::opcode::EQUAL:           return opcode::JUMP_UNLESS_EQUAL;
+    case ir::opcode::LESS:            return opcode::JUMP_UNLESS_LESS;
+    case ir::opcode::BIGGER:          return opcode::JUMP_UNLESS_BIGGER;
+    case ir::opcode::LESS_OR_EQUAL:   return opcode::JUMP_UNLESS_LESS_OR_EQUAL;
+    case ir::opcode::BIGGER_OR_EQUAL: return opcode::JUMP_UNLESS_BIGGER_OR_EQUAL;
+    default:
+        assert(false && "instruction is not a comparison");
+        return opcode::HALT;
+    }
+}
+
+bool is_dead(const ir::instruction &value) {
+    return value.get_users().empty() && !ir::has_side_effects(value.get_opcode());
+}
+
+// Every SSA value gets a register of its own, so nothing is ever overwritten
+// except phi registers, which are written on the edges that lead into their block.
+class ir_lowering {
+public:
+    ir_lowering(const ir::function &function, const context &ctx):
+        function_(function), context_(ctx) {}
+
+    bytecode lower() {
+        allocate_registers();
+
+        const auto &blocks = function_.get_blocks();
+        for (size_t i = 0; i < blocks.size(); ++ i) {
+            next_ = i + 1 < blocks.size() ? blocks[i + 1].get() : nullptr;
+            lower_block(*blocks[i]);
+        }
+
+        lower_pads();
+
+        for (auto [address, target]: fixups_)
+            program_.code[address].a = addresses_.at(target);
+
+        return std::move(program_);
+    }
+
+private:
+    const ir::function &function_;
+    const context &context_;
+    bytecode program_;
+
+    std::unordered_map<size_t, uint32_t> variables_;
+    std::unordered_map<const ir::instruction*, uint32_t> registers_;
+
+    // Breaks cycles in parallel copies into phis
+    uint32_t scratch_ = 0;
+
+    // Block that is laid out right after the current one, jumps to it fall through:
+    const ir::block *next_ = nullptr;
+
+    std::unordered_map<const ir::block*, uint32_t> addresses_;
+    std::vector<std::pair<size_t, const ir::block*>> fixups_;
+
+    // False edges of branches that need copies, emitted after all blocks
+    struct pad {
+        size_t jump;
+        const ir::block *from;
+        const ir::block *target;
+    };
+
+    std::vector<pad> pads_;
+
+    void allocate_registers() {
+        auto get_variable = [&](size_t slot) {
+            auto [it, inserted] = variables_.try_emplace(slot, program_.variables.size());
+            if (inserted)
+                program_.variables.push_back({slot, context_.get_name(slot)});
+
+            return it->second;
+        };
+
+        // Variables go first, so they are counted before anything else gets a register:
+        std::vector<const ir::instruction*> temporaries;
+        for (const auto &current: function_.get_blocks()) {
+            for (const auto &value: current->get_instructions()) {
+                switch (value->get_opcode()) {
+                case ir::opcode::INITIAL:
+                case ir::opcode::STORE:
+                    get_variable(value->get_slot());
+                    break;
+
+                default:
+                    break;
+                }
+
+                if (value->get_opcode() != ir::opcode::CONSTANT && ir::has_value(value->get_opcode()))
+                    temporaries.push_back(value.get());
+            }
+        }
+
+        for (const auto &value: function_.get_entry()->get_instructions()) {
+            if (value->get_opcode() == ir::opcode::CONSTANT) {
+                registers_[value.get()] = program_.get_constants_begin() + program_.constants.size();
+                program_.constants.push_back(value->get_constant());
+            }
+        }
+
+        uint32_t next = static_cast<uint32_t>(program_.variables.size() + program_.constants.size());
+        for (const ir::instruction *value: temporaries)
+            registers_[value] = next ++;
+
+        scratch_ = next;
+        program_.register_count = next + 1;
+    }
+
+    uint32_t get_register(const ir::instruction *value) const {
+        return registers_.at(value);
+    }
+
+    size_t emit(opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+        program_.code.push_back({op, a, b, c});
+        return program_.code.size() - 1;
+    }
+
+    void emit_jump(opcode op, const ir::block *target, uint32_t b = 0, uint32_t c = 0) {
+        fixups_.emplace_back(emit(op, 0, b, c), target);
+    }
+
+    // Comparison that only decides a branch right after it is folded into that branch
+    static bool is_fused_into_branch(const ir::instruction &value) {
+        if (!ir::is_comparison(value.get_opcode()) || value.get_users().size() != 1)
+            return false;
+
+        const ir::instruction *user = value.get_users().front();
+        return user->get_opcode() == ir::opcode::BRANCH && user->get_parent() == value.get_parent();
+    }
+
+    void lower_block(const ir::block &current) {
+        addresses_[&current] = static_cast<uint32_t>(program_.code.size());
+
+        for (const auto &value: current.get_instructions())
+            lower_instruction(*value);
+    }
+
+    void lower_instruction(const ir::instruction &value) {
+        if (ir::has_value(value.get_opcode()) && is_dead(value))
+            return;
+
+        const auto &operands = value.get_operands();
+        switch (value.get_opcode()) {
+        case ir::opcode::CONSTANT:
+        case ir::opcode::PHI:
+            return;
+
+        case ir::opcode::INITIAL:
+            // Variable's own register is overwritten by stores at the end, so its value is copied
+            emit(opcode::MOVE, get_register(&value), variables_.at(value.get_slot()));
+            return;
+
+        case ir::opcode::NEGATE:
+            emit(opcode::NEGATE, get_register(&value), get_register(operands[0]));
+            return;
+
+        case ir::opcode::SCAN:
+            emit(opcode::SCAN, get_register(&value));
+            return;
+
+        case ir::opcode::PRINT:
+            for (size_t i = 0; i < operands.size(); ++ i) {
+                if (i != 0)
+                    emit(opcode::PRINT_SPACE);
+
+                emit(opcode::PRINT, get_register(operands[i]));
+            }
+
+            emit(opcode::PRINT_NEWLINE);
+            return;
+
+        case ir::opcode::STORE:
+            emit(opcode::MOVE, variables_.at(value.get_slot()), get_register(operands[0]));
+            return;
+
+        case ir::opcode::JUMP:
+            lower_edge(*value.get_parent(), *value.get_targets()[0]);
+            return;
+
+        case ir::opcode::BRANCH:
+            lower_branch(value);
+            return;
+
+        case ir::opcode::RETURN:
+            emit(opcode::HALT);
+            return;
+
+        default:
+            if (is_fused_into_branch(value))
+                return;
+
+            emit(get_operation(value.get_opcode()), get_register(&value),
+                 get_register(operands[0]), get_register(operands[1]));
+            return;
+        }
+    }
+
+    bool has_phis(const ir::block &target) const {
+        const auto &instructions = target.get_instructions();
+        return !instructions.empty() && instructions.front()->get_opcode() == ir::opcode::PHI;
+    }
+
+    // Copies values into target's phis and goes there
+    void lower_edge(const ir::block &from, const ir::block &target) {
+        size_t index = target.get_predecessor_index(&from);
+
+        std::vector<std::pair<uint32_t, uint32_t>> copies;
+        for (const auto &phi: target.get_instructions()) {
+            if (phi->get_opcode() != ir::opcode::PHI)
+                break;
+
+            uint32_t destination = get_register(phi.get());
+            uint32_t source = get_register(phi->get_operand(index));
+            if (!is_dead(*phi) && destination != source)
+                copies.emplace_back(destination, source);
+        }
+
+        emit_parallel_copies(std::move(copies));
+
+        if (&target != next_)
+            emit_jump(opcode::JUMP, &target);
+    }
+
+    // Phis of a block are assigned all at once, and one can read another, so copy
+    // is only done once nothing else still needs the register it overwrites. When
+    // copies form a cycle, one of the overwritten values is saved to scratch first.
+    void emit_parallel_copies(std::vector<std::pair<uint32_t, uint32_t>> copies) {
+        while (!copies.empty()) {
+            auto is_read = [&](uint32_t destination) {
+                return std::any_of(copies.begin(), copies.end(), [&](const auto &copy) {
+                    return copy.second == destination;
+                });
+            };
+
+            auto ready = std::find_if(copies.begin(), copies.end(), [&](const auto &copy) {
+                return !is_read(copy.first);
+            });
+
+            if (ready != copies.end()) {
+                emit(opcode::MOVE, ready->first, ready->second);
+                copies.erase(ready);
+                continue;
+            }
+
+            uint32_t saved = copies.front().first;
+            emit(opcode::MOVE, scratch_, saved);
+
+            for (auto &copy: copies) {
+                if (copy.second == saved)
+                    copy.second = scratch_;
+            }
+        }
+    }
+
+    void lower_branch(const ir::instruction &branch) {
+        const ir::block &from = *branch.get_parent();
+        const ir::block &if_true = *branch.get_targets()[0];
+        const ir::block &if_false = *branch.get_targets()[1];
+
+        const ir::instruction &condition = *branch.get_operand(0);
+
+        size_t skip = 0;
+        if (is_fused_into_branch(condition)) {
+            skip = emit(get_inverted_branch(condition.get_opcode()), 0,
+                        get_register(condition.get_operand(0)), get_register(condition.get_operand(1)));
+        } else {
+            skip = emit(opcode::JUMP_IF_ZERO, 0, get_register(&condition));
+        }
+
+        // Copies on the false edge are moved out of line, so true edge can still fall through:
+        if (has_phis(if_false))
+            pads_.push_back({ skip, &from, &if_false });
+        else
+            fixups_.emplace_back(skip, &if_false);
+
+        lower_edge(from, if_true);
+    }
+
+    void lower_pads() {
+        next_ = nullptr;
+
+        for (const pad &edge: pads_) {
+            program_.code[edge.jump].a = static_cast<uint32_t>(program_.code.size());
+            lower_edge(*edge.from, *edge.target);
+        }
+    }
+};
+
+} // end anonymous namespace
+
+
+bytecode compile_bytecode(const ir::function &function, const context &ctx) {
+    return ir_lowering(function, ctx).lower();
+}
+
+} // end namespace paracl
@@ -0,0 +1,83 @@
+#include "paracl/interpreter/tiering.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+
+
+namespace paracl {
+
+tiered_engine::tiered_engine(context &ctx, tiering_options options):
+    context_(ctx), options_(options) {}
+
+void tiered_engine::run(const node_list &scope) {
+    execute_scope(scope);
+}
+
+size_t tiered_engine::get_promoted_loop_count() const {
+    return std::ranges::count_if(loops_, [](const auto &loop) {
+        return loop.second.compiled != nullptr;
+    });
+}
+
+void tiered_engine::execute_scope(const node_list &scope) {
+    for (const auto &statement: scope) {
+        // Fused loops are profiled through their original, which can be promoted,
+        // closed form loops are run as they are:
+        node &current = statement->get_kind() == node_kind::FUSED ? get_unfused(*statement) : *statement;
+
+        switch (current.get_kind()) {
+        case node_kind::WHILE:
+            execute_loop(static_cast<while_node&>(current));
+            break;
+
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(current);
+            if (if_statement.get_condition()->execute(context_) != 0)
+                execute_scope(if_statement.get_scope());
+            break;
+        }
+
+        default:
+            statement->execute(context_);
+            break;
+        }
+    }
+}
+
+void tiered_engine::execute_loop(while_node &loop) {
+    loop_profile &profile = loops_[&loop];
+
+    if (!profile.compiled) {
+        while (loop.get_condition()->execute(context_) != 0) {
+            execute_scope(loop.get_scope());
+
+            if (++ profile.iterations < options_.hotness_threshold)
+                continue;
+
+            // Iteration just finished, so the whole state of the loop is in context
+            // and bytecode can pick it up by starting from the loop condition:
+            promote(loop, profile);
+            break;
+        }
+
+        if (!profile.compiled)
+            return;
+    }
+
+    vm_.run(*profile.compiled, context_);
+}
+
+void tiered_engine::promote(while_node &loop, loop_profile &profile) {
+    profile.compiled = std::make_unique<bytecode>(compile_bytecode(loop, context_));
+
+    if (options_.trace) {
+        std::ostream &trace = *options_.trace;
+
+        trace << "tiering: while (";
+        loop.get_condition()->dump(trace);
+        trace << ") moved from tree-walker to bytecode after "
+              << profile.iterations << " iterations\n";
+    }
+}
+
+} // end namespace paracl
@@ -0,0 +1,145 @@
+#include "paracl/interpreter/vm.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+
+// Computed goto is a GNU extension, but both GCC and Clang support
+// it and it's noticeably faster than a switch in a dispatch loop:
+#if defined(__GNUC__)
+#define PARACL_THREADED_DISPATCH
+#endif
+
+
+namespace paracl {
+
+void vm::run(const bytecode &program, context &ctx) {
+    frame_.assign(program.register_count, 0);
+
+    int64_t *variables = ctx.get_variables();
+    for (size_t i = 0; i < program.variables.size(); ++ i)
+        frame_[i] = variables[program.variables[i].slot];
+
+    std::copy(program.constants.begin(), program.constants.end(),
+              frame_.begin() + program.get_constants_begin());
+
+    execute(program);
+
+    for (size_t i = 0; i < program.variables.size(); ++ i)
+        variables[program.variables[i].slot] = frame_[i];
+}
+
+void vm::execute(const bytecode &program) {
+    const instruction *code = program.code.data();
+    const instruction *ip = code;
+
+    int64_t *r = frame_.data();
+    output_sink &output = get_output();
+    input_source &input = get_input();
+
+#ifdef PARACL_THREADED_DISPATCH
+    static const void *const labels[] = {
+#define PARACL_OPCODE_LABEL(name) &&label_##name,
+        PARACL_BYTECODE_OPCODES(PARACL_OPCODE_LABEL)
+#undef PARACL_OPCODE_LABEL
+    };
+    static_assert(std::size(labels) == OPCODE_COUNT);
+
+#define CASE(name) label_##name:
+#define DISPATCH() goto *labels[static_cast<uint8_t>(ip->op)]
+#else
+#define CASE(name) case opcode::name:
+#define DISPATCH() continue
+#endif
+
+// Not wrapped in do-while, because continue must reach the dispatch loop:
+#define NEXT() { ++ ip; DISPATCH(); }
+#define JUMP_TO(address) { ip = code + (address); DISPATCH(); }
+
+#define BINARY(name, expression)                                   \
+    CASE(name) {                                                   \
+        int64_t lhs = r[ip->b], rhs = r[ip->c];                    \
+        r[ip->a] = (expression);                                   \
+        NEXT();                                                    \
+    }
+
+#define BRANCH_UNLESS(name, expression)                            \
+    CASE(name) {                                                   \
+        int64_t lhs = r[ip->b], rhs = r[ip->c];                    \
+        if (!(expression))                                         \
+            JUMP_TO(ip->a);                                        \
+        NEXT();                                                    \
+    }
+
+#ifdef PARACL_THREADED_DISPATCH
+    DISPATCH();
+#else
+    for (;;) switch (ip->op) {
+#endif
+
+    CASE(MOVE)   { r[ip->a] =  r[ip->b]; NEXT(); }
+    CASE(NEGATE) { r[ip->a] = -r[ip->b]; NEXT(); }
+
+    BINARY(ADD,      lhs + rhs)
+    BINARY(SUBTRACT, lhs - rhs)
+    BINARY(MULTIPLY, lhs * rhs)
+
+    CASE(DIVIDE) {
+        int64_t lhs = r[ip->b], rhs = r[ip->c];
+        if (rhs == 0)
+            throw std::runtime_error("divide by zero");
+
+        r[ip->a] = lhs / rhs;
+        NEXT();
+    }
+
+    BINARY(DIVIDE_UNCHECKED, lhs / rhs)
+
+    BINARY(EQUAL,           lhs == rhs)
+    BINARY(LESS,            lhs <  rhs)
+    BINARY(BIGGER,          lhs >  rhs)
+    BINARY(LESS_OR_EQUAL,   lhs <= rhs)
+    BINARY(BIGGER_OR_EQUAL, lhs >= rhs)
+
+    CASE(JUMP) { JUMP_TO(ip->a); }
+
+    CASE(JUMP_IF_ZERO) {
+        if (r[ip->b] == 0)
+            JUMP_TO(ip->a);
+        NEXT();
+    }
+
+    BRANCH_UNLESS(JUMP_UNLESS_EQUAL,           lhs == rhs)
+    BRANCH_UNLESS(JUMP_UNLESS_LESS,            lhs <  rhs)
+    BRANCH_UNLESS(JUMP_UNLESS_BIGGER,          lhs >  rhs)
+    BRANCH_UNLESS(JUMP_UNLESS_LESS_OR_EQUAL,   lhs <= rhs)
+    BRANCH_UNLESS(JUMP_UNLESS_BIGGER_OR_EQUAL, lhs >= rhs)
+
+    CASE(SCAN) {
+        r[ip->a] = input.read_number();
+        NEXT();
+    }
+
+    CASE(PRINT)         { output.write_number(r[ip->a]); NEXT(); }
+    CASE(PRINT_SPACE)   { output.put(' ');               NEXT(); }
+    CASE(PRINT_NEWLINE) { output.end_line();             NEXT(); }
+
+    CASE(HALT) { return; }
+
+#ifndef PARACL_THREADED_DISPATCH
+    }
+#endif
+
+#undef BRANCH_UNLESS
+#undef BINARY
+#undef JUMP_TO
+#undef NEXT
+#undef DISPATCH
+#undef CASE
+}
+
+} // end namespace paracl
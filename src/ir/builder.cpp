@@ -0,0 +1,315 @@
+#include "paracl/ir/ir.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace paracl::ir {
+
+namespace {
+
+opcode get_binary_opcode(node_kind kind) {
+    switch (kind) {
+    case node_kind::PLUS:            case node_kind::PLUS_ASSIGN:     return opcode::ADD;
+    case node_kind::MINUS:           case node_kind::MINUS_ASSIGN:    return opcode::SUBTRACT;
+    case node_kind::MULTIPLY:        case node_kind::MULTIPLY_ASSIGN: return opcode::MULTIPLY;
+    case node_kind::DIVIDE:          case node_kind::DIVIDE_ASSIGN:   return opcode::DIVIDE;
+    case node_kind::EQUAL:           return opcode::EQUAL;
+    case node_kind::LESS:            return opcode::LESS;
+    case node_kind::BIGGER:          return opcode::BIGGER;
+    case node_kind::LESS_OR_EQUAL:   return opcode::LESS_OR_EQUAL;
+    case node_kind::BIGGER_OR_EQUAL: return opcode::BIGGER_OR_EQUAL;
+
+    default:
+        assert(false && "not a binary operation");
+        return opcode::ADD;
+    }
+}
+
+// SSA construction straight from the tree (Braun et al., "Simple and Efficient
+// Construction of Static Single Assignment Form"): every block remembers the last
+// value of each variable, reads in blocks with many predecessors create phi nodes,
+// and phi nodes that turn out to merge a single value are removed right away.
+class ir_builder {
+public:
+    ir_builder(function &result, size_t variable_count):
+        function_(result), definitions_(variable_count), current_(result.get_entry()) {
+        sealed_.insert(current_);
+    }
+
+    void build_scope(const node_list &scope) {
+        for (const auto &statement: scope)
+            build_statement(get_unfused(*statement));
+    }
+
+    // Writes back every variable that program changed
+    void finish() {
+        std::vector<instruction*> stores;
+        for (size_t slot = 0; slot < definitions_.size(); ++ slot) {
+            instruction *store = current_->append(opcode::STORE, { read_variable(slot, current_) });
+            store->set_slot(slot);
+            stores.push_back(store);
+        }
+
+        current_->ret();
+        remove_trivial_phis();
+
+        for (instruction *store: stores) {
+            instruction *value = store->get_operand(0);
+            if (value->get_opcode() == opcode::INITIAL && value->get_slot() == store->get_slot())
+                current_->erase(store);
+        }
+    }
+
+private:
+    function &function_;
+
+    // Value of each variable at the end of each block, indexed by slot:
+    std::vector<std::unordered_map<block*, instruction*>> definitions_;
+
+    // Blocks that will get no more predecessors, and phis created in the others:
+    std::unordered_set<block*> sealed_;
+    std::unordered_map<block*, std::vector<std::pair<size_t, instruction*>>> incomplete_phis_;
+
+    block *current_;
+
+    void write_variable(size_t slot, block *where, instruction *value) {
+        definitions_[slot][where] = value;
+    }
+
+    instruction *read_variable(size_t slot, block *where) {
+        auto found = definitions_[slot].find(where);
+        if (found != definitions_[slot].end())
+            return found->second;
+
+        return read_variable_recursive(slot, where);
+    }
+
+    instruction *insert_phi(size_t slot, block *where) {
+        instruction *phi = where->insert_phi();
+        phi->set_slot(slot);
+        return phi;
+    }
+
+    instruction *read_variable_recursive(size_t slot, block *where) {
+        instruction *value = nullptr;
+
+        if (where == function_.get_entry()) {
+            value = function_.get_initial(slot);
+        } else if (!sealed_.contains(where)) {
+            value = insert_phi(slot, where);
+            incomplete_phis_[where].emplace_back(slot, value);
+        } else if (where->get_predecessors().size() == 1) {
+            value = read_variable(slot, where->get_predecessors().front());
+        } else {
+            // Phi is written first, so loops that reach it again find it and stop:
+            instruction *phi = insert_phi(slot, where);
+            write_variable(slot, where, phi);
+            value = add_phi_operands(slot, phi);
+        }
+
+        write_variable(slot, where, value);
+        return value;
+    }
+
+    instruction *add_phi_operands(size_t slot, instruction *phi) {
+        for (block *predecessor: phi->get_parent()->get_predecessors())
+            phi->add_operand(read_variable(slot, predecessor));
+
+        return try_remove_trivial_phi(phi);
+    }
+
+    // Phi that merges only one value (and maybe itself) is replaced by that value
+    instruction *try_remove_trivial_phi(instruction *phi) {
+        instruction *same = nullptr;
+        for (instruction *operand: phi->get_operands()) {
+            if (operand == same || operand == phi)
+                continue;
+
+            if (same)
+                return phi;
+
+            same = operand;
+        }
+
+        // Only reachable through itself, so it never gets any value but the initial one:
+        if (!same)
+            same = function_.get_initial(phi->get_slot());
+
+        phi->drop_operands();
+        phi->replace_all_uses_with(same);
+
+        // Copies like `a = b` make phi the value of other variables too:
+        for (auto &definitions: definitions_) {
+            for (auto &[where, value]: definitions) {
+                if (value == phi)
+                    value = same;
+            }
+        }
+
+        phi->get_parent()->erase(phi);
+        return same;
+    }
+
+    // Removing a phi can make phis that used it trivial, so it's repeated until nothing changes
+    void remove_trivial_phis() {
+        for (bool changed = true; changed; ) {
+            changed = false;
+
+            for (const auto &current: function_.get_blocks()) {
+                std::vector<instruction*> phis;
+                for (const auto &inside: current->get_instructions()) {
+                    if (inside->get_opcode() == opcode::PHI)
+                        phis.push_back(inside.get());
+                }
+
+                for (instruction *phi: phis)
+                    changed = try_remove_trivial_phi(phi) != phi || changed;
+            }
+        }
+    }
+
+    void seal(block *where) {
+        for (auto &[slot, phi]: incomplete_phis_[where])
+            add_phi_operands(slot, phi);
+
+        incomplete_phis_.erase(where);
+        sealed_.insert(where);
+    }
+
+    instruction *build_expression(const node &tree) {
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+            return function_.get_constant(static_cast<const number_node&>(tree).get_number());
+
+        case node_kind::ID:
+            return read_variable(static_cast<const id_node&>(tree).get_slot(), current_);
+
+        case node_kind::NEGATE: {
+            instruction *child = build_expression(static_cast<const negate_node&>(tree).get_child());
+            return current_->append(opcode::NEGATE, { child });
+        }
+
+        case node_kind::SCAN:
+            return current_->append(opcode::SCAN);
+
+        case node_kind::FUNCTION: {
+            const auto &function = static_cast<const function_node&>(tree);
+            if (function.get_name() != "print")
+                return function_.get_constant(0);
+
+            std::vector<instruction*> args;
+            for (const auto &arg: function.get_args())
+                args.push_back(build_expression(*arg));
+
+            current_->append(opcode::PRINT, std::move(args));
+            return function_.get_constant(1);
+        }
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            return build_expression(get_unfused(tree));
+
+        default: {
+            assert(is_arithmetic_or_comparison(tree.get_kind()) && "statement used as expression");
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            instruction *left = build_expression(binary.get_left());
+            instruction *right = build_expression(binary.get_right());
+
+            return current_->append(get_binary_opcode(tree.get_kind()), { left, right });
+        }
+        }
+    }
+
+    void build_statement(const node &tree) {
+        if (is_assignment(tree.get_kind())) {
+            const auto &assignment = static_cast<const binary_node&>(tree);
+            size_t slot = static_cast<const id_node&>(assignment.get_left()).get_slot();
+
+            instruction *value = build_expression(assignment.get_right());
+            if (tree.get_kind() != node_kind::ASSIGN) {
+                instruction *old = read_variable(slot, current_);
+                value = current_->append(get_binary_opcode(tree.get_kind()), { old, value });
+            }
+
+            write_variable(slot, current_, value);
+            return;
+        }
+
+        switch (tree.get_kind()) {
+        case node_kind::IF: {
+            const auto &if_statement = static_cast<const if_node&>(tree);
+
+            instruction *condition = build_expression(if_statement.get_condition());
+
+            block *body = function_.create_block();
+            block *merge = function_.create_block();
+            current_->branch(condition, body, merge);
+            seal(body);
+
+            current_ = body;
+            build_scope(if_statement.get_scope());
+
+            current_->jump(merge);
+            seal(merge);
+
+            current_ = merge;
+            return;
+        }
+
+        case node_kind::WHILE: {
+            const auto &while_statement = static_cast<const while_node&>(tree);
+
+            block *header = function_.create_block();
+            current_->jump(header);
+            current_ = header;
+
+            instruction *condition = build_expression(while_statement.get_condition());
+
+            block *body = function_.create_block();
+            block *exit = function_.create_block();
+            current_->branch(condition, body, exit);
+            seal(body);
+            seal(exit);
+
+            current_ = body;
+            build_scope(while_statement.get_scope());
+
+            // Now that the back edge is known, header has all of its predecessors:
+            current_->jump(header);
+            seal(header);
+
+            current_ = exit;
+            return;
+        }
+
+        default:
+            build_expression(tree);
+            return;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+
+function build_ir(const paracl::node_list &scope, const context &ctx) {
+    std::vector<std::string> names;
+    for (size_t slot = 0; slot < ctx.get_variable_count(); ++ slot)
+        names.push_back(ctx.get_name(slot));
+
+    function result(std::move(names));
+
+    ir_builder builder(result, ctx.get_variable_count());
+    builder.build_scope(scope);
+    builder.finish();
+
+    result.renumber();
+    return result;
+}
+
+} // end namespace paracl::ir
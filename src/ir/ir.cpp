@@ -0,0 +1,320 @@
+#include "paracl/ir/ir.h"
+#include "paracl/ast/graphviz_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+
+namespace paracl::ir {
+
+const char *get_opcode_name(opcode op) {
+    switch (op) {
+#define PARACL_IR_OPCODE_NAME(name, text) case opcode::name: return text;
+    PARACL_IR_OPCODES(PARACL_IR_OPCODE_NAME)
+#undef PARACL_IR_OPCODE_NAME
+    }
+
+    return "unknown";
+}
+
+
+void instruction::add_operand(instruction *value) {
+    operands_.push_back(value);
+    value->users_.push_back(this);
+}
+
+void instruction::set_operand(size_t index, instruction *value) {
+    operands_[index]->remove_user(this);
+
+    operands_[index] = value;
+    value->users_.push_back(this);
+}
+
+void instruction::drop_operands() {
+    for (instruction *operand: operands_)
+        operand->remove_user(this);
+
+    operands_.clear();
+}
+
+void instruction::remove_user(instruction *user) {
+    auto found = std::find(users_.begin(), users_.end(), user);
+    assert(found != users_.end() && "def-use chain is broken");
+
+    users_.erase(found);
+}
+
+void instruction::replace_all_uses_with(instruction *value) {
+    assert(value != this && "value can't replace itself");
+
+    for (instruction *user: users_) {
+        for (instruction *&operand: user->operands_) {
+            if (operand == this)
+                operand = value;
+        }
+    }
+
+    // Every use is listed once per operand, so they all move over:
+    value->users_.insert(value->users_.end(), users_.begin(), users_.end());
+    users_.clear();
+}
+
+void instruction::dump(std::ostream &ostr) const {
+    if (has_value(op_))
+        ostr << "%" << id_ << " = ";
+
+    ostr << get_opcode_name(op_);
+
+    switch (op_) {
+    case opcode::CONSTANT:
+        ostr << " " << constant_;
+        return;
+
+    case opcode::INITIAL:
+        ostr << " $" << slot_;
+        return;
+
+    case opcode::STORE:
+        ostr << " $" << slot_ << ", %" << operands_[0]->get_id();
+        return;
+
+    case opcode::PHI:
+        for (size_t i = 0; i < operands_.size(); ++ i) {
+            ostr << (i == 0 ? " " : ", ") << "[%" << operands_[i]->get_id()
+                 << ", block" << parent_->get_predecessors()[i]->get_id() << "]";
+        }
+        return;
+
+    default:
+        break;
+    }
+
+    for (size_t i = 0; i < operands_.size(); ++ i)
+        ostr << (i == 0 ? " %" : ", %") << operands_[i]->get_id();
+
+    for (size_t i = 0; i < targets_.size(); ++ i)
+        ostr << (i == 0 && operands_.empty() ? " block" : ", block") << targets_[i]->get_id();
+}
+
+
+instruction *block::append(opcode op, std::vector<instruction*> operands) {
+    assert((instructions_.empty() || !is_terminator(instructions_.back()->get_opcode())) &&
+           "block is already terminated");
+
+    return insert(instructions_.size(), op, std::move(operands));
+}
+
+instruction *block::insert_phi() {
+    auto first_non_phi = std::find_if(instructions_.begin(), instructions_.end(), [](const auto &current) {
+        return current->get_opcode() != opcode::PHI;
+    });
+
+    auto phi = std::make_unique<instruction>(opcode::PHI, this);
+    return instructions_.insert(first_non_phi, std::move(phi))->get();
+}
+
+instruction *block::insert(size_t position, opcode op, std::vector<instruction*> operands) {
+    auto inserted = std::make_unique<instruction>(op, this);
+    for (instruction *operand: operands)
+        inserted->add_operand(operand);
+
+    return instructions_.insert(instructions_.begin() + position, std::move(inserted))->get();
+}
+
+void block::erase(instruction *removed) {
+    assert(removed->get_users().empty() && "erased instruction is still used");
+
+    auto found = std::find_if(instructions_.begin(), instructions_.end(), [&](const auto &current) {
+        return current.get() == removed;
+    });
+
+    assert(found != instructions_.end() && "instruction is in other block");
+    instructions_.erase(found);
+}
+
+void block::jump(block *target) {
+    instruction *terminator = append(opcode::JUMP);
+
+    terminator->targets_.push_back(target);
+    target->predecessors_.push_back(this);
+}
+
+void block::branch(instruction *condition, block *if_true, block *if_false) {
+    instruction *terminator = append(opcode::BRANCH, { condition });
+
+    for (block *target: { if_true, if_false }) {
+        terminator->targets_.push_back(target);
+        target->predecessors_.push_back(this);
+    }
+}
+
+void block::ret() {
+    append(opcode::RETURN);
+}
+
+instruction *block::get_terminator() const {
+    if (instructions_.empty() || !is_terminator(instructions_.back()->get_opcode()))
+        return nullptr;
+
+    return instructions_.back().get();
+}
+
+std::vector<block*> block::get_successors() const {
+    instruction *terminator = get_terminator();
+    if (!terminator)
+        return {};
+
+    return terminator->get_targets();
+}
+
+size_t block::get_predecessor_index(const block *predecessor) const {
+    auto found = std::find(predecessors_.begin(), predecessors_.end(), predecessor);
+    assert(found != predecessors_.end() && "block is not a predecessor");
+
+    return found - predecessors_.begin();
+}
+
+void block::dump(std::ostream &ostr, const std::vector<std::string> &names) const {
+    ostr << "block" << id_ << ":";
+    for (size_t i = 0; i < predecessors_.size(); ++ i)
+        ostr << (i == 0 ? " ; preds = block" : ", block") << predecessors_[i]->get_id();
+
+    ostr << "\n";
+
+    for (const auto &current: instructions_) {
+        ostr << "    ";
+        current->dump(ostr);
+
+        opcode op = current->get_opcode();
+        if ((op == opcode::INITIAL || op == opcode::STORE) && current->get_slot() < names.size())
+            ostr << " ; " << names[current->get_slot()];
+
+        ostr << "\n";
+    }
+}
+
+
+function::function(std::vector<std::string> names):
+    names_(std::move(names)) {
+    create_block();
+}
+
+function::~function() {
+    for (const auto &current: blocks_) {
+        for (const auto &inside: current->instructions_)
+            inside->drop_operands();
+    }
+}
+
+block *function::create_block() {
+    blocks_.push_back(std::make_unique<block>(blocks_.size()));
+    return blocks_.back().get();
+}
+
+instruction *function::get_constant(int64_t value) {
+    auto [found, inserted] = constants_.try_emplace(value, nullptr);
+    if (inserted) {
+        found->second = get_entry()->insert(0, opcode::CONSTANT);
+        found->second->set_constant(value);
+    }
+
+    return found->second;
+}
+
+instruction *function::get_initial(size_t slot) {
+    auto [found, inserted] = initials_.try_emplace(slot, nullptr);
+    if (inserted) {
+        found->second = get_entry()->insert(0, opcode::INITIAL);
+        found->second->set_slot(slot);
+    }
+
+    return found->second;
+}
+
+void function::renumber() {
+    std::vector<block*> postorder;
+    std::unordered_map<block*, bool> visited;
+
+    // Depth first, false branch first, so that in reverse loop body follows its header:
+    std::vector<std::pair<block*, size_t>> stack = { { get_entry(), 0 } };
+    visited[get_entry()] = true;
+
+    while (!stack.empty()) {
+        auto &[current, visited_successors] = stack.back();
+
+        std::vector<block*> successors = current->get_successors();
+        if (visited_successors == successors.size()) {
+            postorder.push_back(current);
+            stack.pop_back();
+            continue;
+        }
+
+        block *next = successors[successors.size() - 1 - visited_successors ++];
+        if (!visited[next]) {
+            visited[next] = true;
+            stack.emplace_back(next, 0);
+        }
+    }
+
+    std::vector<std::unique_ptr<block>> ordered;
+    for (auto it = postorder.rbegin(); it != postorder.rend(); ++ it) {
+        auto found = std::find_if(blocks_.begin(), blocks_.end(), [&](const auto &current) {
+            return current.get() == *it;
+        });
+
+        ordered.push_back(std::move(*found));
+    }
+
+    for (auto &current: blocks_) {
+        if (current)
+            ordered.push_back(std::move(current));
+    }
+
+    blocks_ = std::move(ordered);
+
+    size_t value_id = 0;
+    for (size_t i = 0; i < blocks_.size(); ++ i) {
+        blocks_[i]->set_id(i);
+
+        for (const auto &current: blocks_[i]->get_instructions()) {
+            if (has_value(current->get_opcode()))
+                current->set_id(value_id ++);
+        }
+    }
+}
+
+void function::dump(std::ostream &ostr) {
+    renumber();
+
+    for (const auto &current: blocks_)
+        current->dump(ostr, names_);
+}
+
+void function::dump_gv(std::ostream &ostr) {
+    renumber();
+
+    graphviz graph{};
+
+    std::vector<node_proxy> nodes;
+    for (const auto &current: blocks_) {
+        std::stringstream label;
+        label << "block" << current->get_id() << "|";
+
+        for (const auto &inside: current->get_instructions()) {
+            inside->dump(label);
+            label << "\\l";
+        }
+
+        nodes.push_back(graph.insert_node(graphviz_formatter::basic_block, label.str()));
+    }
+
+    for (const auto &current: blocks_) {
+        for (block *successor: current->get_successors())
+            nodes[current->get_id()].connect(graphviz_formatter::default_edge, nodes[successor->get_id()]);
+    }
+
+    graph.print(ostr);
+}
+
+} // end namespace paracl::ir
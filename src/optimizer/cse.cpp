@@ -0,0 +1,359 @@
+#include "paracl/optimizer/cse.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+namespace paracl {
+
+namespace {
+
+// Operation with numbers of its operands, or a leaf: number with its value,
+// variable with its slot and version
+struct expression_key {
+    node_kind kind;
+    uint64_t first;
+    uint64_t second;
+
+    bool operator==(const expression_key&) const = default;
+};
+
+struct expression_key_hash {
+    size_t operator()(const expression_key &key) const {
+        size_t hash = std::hash<uint64_t>{}(key.first);
+        hash ^= std::hash<uint64_t>{}(key.second) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+        hash ^= static_cast<size_t>(key.kind) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
+bool is_leaf(const node &tree) {
+    return tree.get_kind() == node_kind::NUMBER || tree.get_kind() == node_kind::ID;
+}
+
+bool can_fault(const binary_node &divide) {
+    const node &divisor = divide.get_right();
+    if (divisor.get_kind() != node_kind::NUMBER)
+        return true;
+
+    int64_t value = static_cast<const number_node&>(divisor).get_number();
+    return value == 0 || value == -1;
+}
+
+class common_subexpression_eliminator {
+public:
+    explicit common_subexpression_eliminator(context &ctx):
+        context_(ctx) {}
+
+    size_t get_removed_count() const {
+        return removed_;
+    }
+
+    // First walk only counts how many times each expression is computed, second
+    // one replaces them. Both see variables written in the same order, so every
+    // expression gets the same number in both.
+    void run(node_list &scope) {
+        for (bool rewrite: { false, true }) {
+            rewrite_ = rewrite;
+            versions_.assign(context_.get_variable_count(), 0);
+
+            walk_scope(scope, {});
+        }
+    }
+
+private:
+    context &context_;
+
+    // Hash-consing table, equal subtrees get equal numbers:
+    std::unordered_map<expression_key, size_t, expression_key_hash> numbers_;
+
+    // How many times expression with the number is computed
+    std::vector<size_t> uses_;
+
+    // Numbers of subtrees of the statement that is being processed
+    std::unordered_map<const node*, size_t> numbered_;
+
+    // How many times each variable was written so far
+    std::vector<size_t> versions_;
+
+    bool rewrite_ = false;
+    size_t removed_ = 0;
+    size_t next_temporary_ = 0;
+
+    // Temporaries that already hold expressions with the number, visible in current scope
+    using temporaries = std::unordered_map<size_t, std::pair<std::string, size_t>>;
+
+    void walk_scope(node_list &scope, temporaries available) {
+        node_list rewritten;
+
+        for (auto &statement: scope) {
+            walk_statement(statement, available, rewritten);
+            if (rewrite_)
+                rewritten.push_back(std::move(statement));
+        }
+
+        if (rewrite_)
+            scope = std::move(rewritten);
+    }
+
+    // Temporaries that statement needs are assigned to preceding
+    void walk_statement(std::unique_ptr<node> &statement, temporaries &available,
+                        node_list &preceding) {
+        switch (statement->get_kind()) {
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(*statement);
+            walk_expression(if_statement.get_condition(), available, &preceding);
+            walk_scope(if_statement.get_scope(), available);
+
+            bump_writes(*statement);
+            return;
+        }
+
+        case node_kind::WHILE: {
+            auto &while_statement = static_cast<while_node&>(*statement);
+
+            // Whatever loop writes differs between iterations, and condition
+            // is computed every iteration, so it can only reuse temporaries:
+            bump_writes(*statement);
+            walk_expression(while_statement.get_condition(), available, nullptr);
+            walk_scope(while_statement.get_scope(), available);
+
+            bump_writes(*statement);
+            return;
+        }
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            bump_writes(get_unfused(*statement));
+            return;
+
+        default:
+            break;
+        }
+
+        if (!is_assignment(statement->get_kind())) {
+            walk_expression(statement, available, &preceding);
+            return;
+        }
+
+        auto &assignment = static_cast<binary_node&>(*statement);
+        walk_expression(assignment.get_right(), available, &preceding);
+
+        bump(static_cast<const id_node&>(*assignment.get_left()).get_slot());
+    }
+
+    void bump(size_t slot) {
+        if (slot >= versions_.size())
+            versions_.resize(slot + 1, 0);
+
+        ++ versions_[slot];
+    }
+
+    void bump_writes(const node &tree) {
+        switch (tree.get_kind()) {
+        case node_kind::IF:
+            for (const auto &statement: static_cast<const if_node&>(tree).get_scope())
+                bump_writes(*statement);
+            return;
+
+        case node_kind::WHILE:
+            for (const auto &statement: static_cast<const while_node&>(tree).get_scope())
+                bump_writes(*statement);
+            return;
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            bump_writes(get_unfused(tree));
+            return;
+
+        default:
+            if (is_assignment(tree.get_kind()))
+                bump(static_cast<const id_node&>(static_cast<const binary_node&>(tree).get_left()).get_slot());
+            return;
+        }
+    }
+
+    // If preceding is null, no new temporaries can be created
+    void walk_expression(std::unique_ptr<node> &expression, temporaries &available,
+                         node_list *preceding) {
+        numbered_.clear();
+        number(*expression);
+
+        if (rewrite_)
+            replace(expression, available, preceding);
+    }
+
+    size_t intern(expression_key key) {
+        auto [it, inserted] = numbers_.try_emplace(key, numbers_.size());
+        if (inserted)
+            uses_.push_back(0);
+
+        return it->second;
+    }
+
+    // Numbers every subtree that has no input or failing division in it
+    std::optional<size_t> number(const node &tree) {
+        std::optional<expression_key> key;
+
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+            key = { node_kind::NUMBER, std::bit_cast<uint64_t>(static_cast<const number_node&>(tree).get_number()), 0 };
+            break;
+
+        case node_kind::ID: {
+            size_t slot = static_cast<const id_node&>(tree).get_slot();
+            key = { node_kind::ID, slot, slot < versions_.size() ? versions_[slot] : 0 };
+            break;
+        }
+
+        case node_kind::NEGATE: {
+            std::optional<size_t> child = number(static_cast<const negate_node&>(tree).get_child());
+            if (child)
+                key = { node_kind::NEGATE, *child, 0 };
+            break;
+        }
+
+        case node_kind::FUNCTION:
+            for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+                number(*arg);
+            break;
+
+        default: {
+            if (!is_arithmetic_or_comparison(tree.get_kind()))
+                break;
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            std::optional<size_t> left = number(binary.get_left());
+            std::optional<size_t> right = number(binary.get_right());
+
+            if (!left || !right || (tree.get_kind() == node_kind::DIVIDE && can_fault(binary)))
+                break;
+
+            key = { tree.get_kind(), *left, *right };
+            break;
+        }
+        }
+
+        if (!key)
+            return std::nullopt;
+
+        size_t result = intern(*key);
+        numbered_[&tree] = result;
+
+        if (!rewrite_ && !is_leaf(tree))
+            ++ uses_[result];
+
+        return result;
+    }
+
+    void replace(std::unique_ptr<node> &tree, temporaries &available,
+                 node_list *preceding) {
+        auto found = numbered_.find(tree.get());
+        if (found != numbered_.end() && !is_leaf(*tree)) {
+            size_t number = found->second;
+
+            if (auto temporary = available.find(number); temporary != available.end()) {
+                auto &[name, slot] = temporary->second;
+                tree = std::make_unique<id_node>(name, slot);
+
+                ++ removed_;
+                return;
+            }
+
+            if (preceding && uses_[number] >= 2) {
+                std::unique_ptr<node> expression = std::move(tree);
+
+                // Other copies won't compute anything inside of it:
+                discount_subtrees(*expression, uses_[number] - 1);
+
+                std::string name = get_temporary_name();
+                size_t slot = context_.create_variable(name);
+                available[number] = { name, slot };
+
+                // Repeated parts of it get their own temporaries, assigned before this one:
+                replace_children(*expression, available, preceding);
+
+                auto target = std::make_unique<id_node>(name, slot);
+                preceding->push_back(std::make_unique<assign_node>(std::move(target), std::move(expression)));
+
+                tree = std::make_unique<id_node>(name, slot);
+                return;
+            }
+        }
+
+        replace_children(*tree, available, preceding);
+    }
+
+    void replace_children(node &tree, temporaries &available, node_list *preceding) {
+        switch (tree.get_kind()) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(tree).get_args())
+                replace(arg, available, preceding);
+            return;
+
+        case node_kind::NEGATE:
+            replace(static_cast<negate_node&>(tree).get_child(), available, preceding);
+            return;
+
+        default:
+            if (!is_arithmetic_or_comparison(tree.get_kind()))
+                return;
+
+            auto &binary = static_cast<binary_node&>(tree);
+            replace(binary.get_left(), available, preceding);
+            replace(binary.get_right(), available, preceding);
+            return;
+        }
+    }
+
+    void discount_subtrees(const node &tree, size_t times) {
+        auto discount = [&](const node &child) {
+            if (auto found = numbered_.find(&child); found != numbered_.end() && !is_leaf(child))
+                uses_[found->second] -= std::min(uses_[found->second], times);
+
+            discount_subtrees(child, times);
+        };
+
+        switch (tree.get_kind()) {
+        case node_kind::NEGATE:
+            discount(static_cast<const negate_node&>(tree).get_child());
+            return;
+
+        default:
+            if (!is_arithmetic_or_comparison(tree.get_kind()))
+                return;
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            discount(binary.get_left());
+            discount(binary.get_right());
+            return;
+        }
+    }
+
+    // Such names can't come from the source, so they never clash with user's variables
+    std::string get_temporary_name() {
+        for (;; ++ next_temporary_) {
+            std::string name = "$cse" + std::to_string(next_temporary_);
+            if (!context_.check_var_existing(name))
+                return name;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t eliminate_common_subexpressions(ast &tree) {
+    common_subexpression_eliminator pass(tree.get_context());
+    pass.run(tree.get_scope());
+
+    return pass.get_removed_count();
+}
+
+} // end namespace paracl
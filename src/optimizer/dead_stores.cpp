@@ -0,0 +1,268 @@
+#include "paracl/optimizer/dead_stores.h"
+
+#include <cassert>
+
+
+namespace paracl {
+
+namespace {
+
+using live_set = std::vector<bool>;
+
+void merge(live_set &live, const live_set &other) {
+    for (size_t slot = 0; slot < live.size(); ++ slot)
+        live[slot] = live[slot] || other[slot];
+}
+
+// Division fails on zero, and on -1 when dividend is the smallest value
+bool can_divide_fail(const node &divisor) {
+    if (divisor.get_kind() != node_kind::NUMBER)
+        return true;
+
+    int64_t value = static_cast<const number_node&>(divisor).get_number();
+    return value == 0 || value == -1;
+}
+
+// Reading input, printing and division that can fail must not be removed
+bool has_side_effects(const node &tree) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::ID:
+        return false;
+
+    case node_kind::NEGATE:
+        return has_side_effects(static_cast<const negate_node&>(tree).get_child());
+
+    case node_kind::DIVIDE: {
+        const auto &divide = static_cast<const binary_node&>(tree);
+
+        if (can_divide_fail(divide.get_right()))
+            return true;
+
+        return has_side_effects(divide.get_left());
+    }
+
+    default:
+        if (!is_arithmetic_or_comparison(tree.get_kind()))
+            return true;
+
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return has_side_effects(binary.get_left()) || has_side_effects(binary.get_right());
+    }
+}
+
+void add_uses(const node &tree, live_set &live) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::SCAN:
+        return;
+
+    case node_kind::ID:
+        live[static_cast<const id_node&>(tree).get_slot()] = true;
+        return;
+
+    case node_kind::FUNCTION:
+        for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+            add_uses(*arg, live);
+        return;
+
+    case node_kind::NEGATE:
+        add_uses(static_cast<const negate_node&>(tree).get_child(), live);
+        return;
+
+    default: {
+        assert(is_arithmetic_or_comparison(tree.get_kind()) && "unexpected node in expression");
+
+        const auto &binary = static_cast<const binary_node&>(tree);
+        add_uses(binary.get_left(), live);
+        add_uses(binary.get_right(), live);
+        return;
+    }
+    }
+}
+
+class dead_store_eliminator {
+public:
+    size_t get_removed_count() const {
+        return removed_;
+    }
+
+    // Walks scope backwards, live holds variables that are read after the scope
+    // and becomes variables that are read before it. Dead stores are removed
+    // only if eliminate is set, otherwise scope is just analyzed.
+    void transfer_scope(node_list &scope, live_set &live, bool eliminate) {
+        node_list kept;
+
+        for (auto it = scope.rbegin(); it != scope.rend(); ++ it) {
+            if (transfer_statement(*it, live, eliminate) && eliminate)
+                kept.push_back(std::move(*it));
+        }
+
+        if (!eliminate)
+            return;
+
+        scope.assign(std::make_move_iterator(kept.rbegin()), std::make_move_iterator(kept.rend()));
+    }
+
+private:
+    size_t removed_ = 0;
+
+    // Returns false if statement is dead
+    bool transfer_statement(std::unique_ptr<node> &statement, live_set &live, bool eliminate) {
+        switch (statement->get_kind()) {
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(*statement);
+
+            live_set body = live;
+            transfer_scope(if_statement.get_scope(), body, eliminate);
+
+            merge(live, body);
+            add_uses(*if_statement.get_condition(), live);
+            return true;
+        }
+
+        case node_kind::WHILE: {
+            auto &while_statement = static_cast<while_node&>(*statement);
+
+            // Whatever body reads is live at the loop head, repeat until it stops growing:
+            live_set head = live;
+            add_uses(*while_statement.get_condition(), head);
+            for (;;) {
+                live_set body = head;
+                transfer_scope(while_statement.get_scope(), body, false);
+
+                live_set merged = head;
+                merge(merged, body);
+                if (merged == head)
+                    break;
+
+                head = std::move(merged);
+            }
+
+            if (eliminate) {
+                live_set body = head;
+                transfer_scope(while_statement.get_scope(), body, true);
+            }
+
+            live = std::move(head);
+            return true;
+        }
+
+        default:
+            break;
+        }
+
+        if (!is_assignment(statement->get_kind())) {
+            add_uses(*statement, live);
+            return true;
+        }
+
+        auto &assignment = static_cast<binary_node&>(*statement);
+        size_t slot = static_cast<const id_node&>(*assignment.get_left()).get_slot();
+
+        // Division that can fail needs the old value of the variable, so it's kept whole:
+        bool is_failing_division = statement->get_kind() == node_kind::DIVIDE_ASSIGN &&
+                                   can_divide_fail(*assignment.get_right());
+
+        if (!live[slot] && !is_failing_division) {
+            if (!has_side_effects(*assignment.get_right())) {
+                if (eliminate)
+                    ++ removed_;
+
+                return false;
+            }
+
+            // Only value isn't needed, so assigned expression becomes a statement on its own:
+            add_uses(*assignment.get_right(), live);
+            if (eliminate)
+                statement = std::move(assignment.get_right());
+
+            return true;
+        }
+
+        live[slot] = statement->get_kind() != node_kind::ASSIGN;
+        add_uses(*assignment.get_right(), live);
+        return true;
+    }
+};
+
+template <typename visitor_type>
+void for_each_variable(node &tree, visitor_type &visitor);
+
+template <bool is_loop, typename visitor_type>
+void for_each_variable_in_conditional(conditional_operation_node<is_loop> &conditional, visitor_type &visitor) {
+    for_each_variable(*conditional.get_condition(), visitor);
+    for (auto &statement: conditional.get_scope())
+        for_each_variable(*statement, visitor);
+}
+
+// Calls visitor for every variable in the tree, including assigned ones
+template <typename visitor_type>
+void for_each_variable(node &tree, visitor_type &visitor) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::SCAN:
+        return;
+
+    case node_kind::ID:
+        visitor(static_cast<id_node&>(tree));
+        return;
+
+    case node_kind::FUNCTION:
+        for (auto &arg: static_cast<function_node&>(tree).get_args())
+            for_each_variable(*arg, visitor);
+        return;
+
+    case node_kind::NEGATE:
+        for_each_variable(*static_cast<negate_node&>(tree).get_child(), visitor);
+        return;
+
+    case node_kind::IF:
+        for_each_variable_in_conditional(static_cast<if_node&>(tree), visitor);
+        return;
+
+    case node_kind::WHILE:
+        for_each_variable_in_conditional(static_cast<while_node&>(tree), visitor);
+        return;
+
+    default: {
+        auto &binary = static_cast<binary_node&>(tree);
+        for_each_variable(*binary.get_left(), visitor);
+        for_each_variable(*binary.get_right(), visitor);
+        return;
+    }
+    }
+}
+
+} // end anonymous namespace
+
+
+size_t eliminate_dead_stores(ast &tree) {
+    context &ctx = tree.get_context();
+
+    // Nothing is read after the program ends:
+    live_set live(ctx.get_variable_count(), false);
+
+    dead_store_eliminator pass;
+    pass.transfer_scope(tree.get_scope(), live, true);
+
+    std::vector<bool> used(ctx.get_variable_count(), false);
+    auto mark_used = [&](id_node &variable) {
+        used[variable.get_slot()] = true;
+    };
+
+    for (auto &statement: tree.get_scope())
+        for_each_variable(*statement, mark_used);
+
+    std::vector<size_t> remap = ctx.compact(used);
+    auto move_slot = [&](id_node &variable) {
+        variable.set_slot(remap[variable.get_slot()]);
+    };
+
+    for (auto &statement: tree.get_scope())
+        for_each_variable(*statement, move_slot);
+
+    return pass.get_removed_count();
+}
+
+} // end namespace paracl
@@ -0,0 +1,167 @@
+#include "paracl/optimizer/folding.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+
+namespace paracl {
+
+namespace {
+
+template <typename operator_type>
+int64_t apply(int64_t lhs, int64_t rhs) {
+    return static_cast<int64_t>(typename operator_type::operation{}(lhs, rhs));
+}
+
+} // end anonymous namespace
+
+
+std::optional<int64_t> evaluate_operation(node_kind kind, int64_t lhs, int64_t rhs) {
+    switch (kind) {
+    case node_kind::PLUS:            return apply<plus_node>(lhs, rhs);
+    case node_kind::MINUS:           return apply<minus_node>(lhs, rhs);
+    case node_kind::MULTIPLY:        return apply<multiply_node>(lhs, rhs);
+    case node_kind::EQUAL:           return apply<equal_node>(lhs, rhs);
+    case node_kind::LESS:            return apply<less_node>(lhs, rhs);
+    case node_kind::BIGGER:          return apply<bigger_node>(lhs, rhs);
+    case node_kind::LESS_OR_EQUAL:   return apply<less_or_equal_node>(lhs, rhs);
+    case node_kind::BIGGER_OR_EQUAL: return apply<bigger_or_equal_node>(lhs, rhs);
+
+    case node_kind::DIVIDE:
+        // Left as is to fail at runtime, as it would without folding:
+        if (rhs == 0 || (lhs == std::numeric_limits<int64_t>::min() && rhs == -1))
+            return std::nullopt;
+
+        return apply<divide_node>(lhs, rhs);
+
+    default:
+        return std::nullopt;
+    }
+}
+
+
+namespace {
+
+std::optional<int64_t> get_constant(const node &tree) {
+    if (tree.get_kind() != node_kind::NUMBER)
+        return std::nullopt;
+
+    return static_cast<const number_node&>(tree).get_number();
+}
+
+class folder {
+public:
+    size_t get_change_count() const {
+        return changes_;
+    }
+
+    void fold_scope(node_list &scope) {
+        node_list folded;
+        for (auto &statement: scope)
+            fold_statement(statement, folded);
+
+        scope = std::move(folded);
+    }
+
+private:
+    size_t changes_ = 0;
+
+    void fold_statement(std::unique_ptr<node> &statement, node_list &folded) {
+        switch (statement->get_kind()) {
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(*statement);
+            fold(if_statement.get_condition());
+            fold_scope(if_statement.get_scope());
+
+            std::optional<int64_t> condition = get_constant(*if_statement.get_condition());
+            if (!condition)
+                break;
+
+            ++ changes_;
+            if (*condition != 0) {
+                for (auto &nested: if_statement.get_scope())
+                    folded.push_back(std::move(nested));
+            }
+            return;
+        }
+
+        case node_kind::WHILE: {
+            auto &while_statement = static_cast<while_node&>(*statement);
+            fold(while_statement.get_condition());
+            fold_scope(while_statement.get_scope());
+
+            if (get_constant(*while_statement.get_condition()) == 0) {
+                ++ changes_;
+                return;
+            }
+            break;
+        }
+
+        default:
+            fold(statement);
+            break;
+        }
+
+        folded.push_back(std::move(statement));
+    }
+
+    void fold(std::unique_ptr<node> &tree) {
+        switch (tree->get_kind()) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(*tree).get_args())
+                fold(arg);
+            return;
+
+        case node_kind::NEGATE: {
+            auto &child = static_cast<negate_node&>(*tree).get_child();
+            fold(child);
+
+            std::optional<int64_t> value = get_constant(*child);
+            if (value && *value != std::numeric_limits<int64_t>::min())
+                replace(tree, std::negate<int64_t>{}(*value));
+            return;
+        }
+
+        default:
+            break;
+        }
+
+        if (is_assignment(tree->get_kind())) {
+            fold(static_cast<binary_node&>(*tree).get_right());
+            return;
+        }
+
+        if (!is_arithmetic_or_comparison(tree->get_kind()))
+            return;
+
+        auto &binary = static_cast<binary_node&>(*tree);
+        fold(binary.get_left());
+        fold(binary.get_right());
+
+        std::optional<int64_t> lhs = get_constant(*binary.get_left());
+        std::optional<int64_t> rhs = get_constant(*binary.get_right());
+        if (!lhs || !rhs)
+            return;
+
+        if (std::optional<int64_t> value = evaluate_operation(tree->get_kind(), *lhs, *rhs))
+            replace(tree, *value);
+    }
+
+    void replace(std::unique_ptr<node> &tree, int64_t value) {
+        tree = std::make_unique<number_node>(value);
+        ++ changes_;
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t fold_constants(ast &tree) {
+    folder pass;
+    pass.fold_scope(tree.get_scope());
+
+    return pass.get_change_count();
+}
+
+} // end namespace paracl
@@ -0,0 +1,164 @@
+#include "paracl/optimizer/fusion.h"
+#include "paracl/ast/fused_nodes.h"
+
+
+namespace paracl {
+
+namespace {
+
+bool is_leaf(const node &tree) {
+    return tree.get_kind() == node_kind::NUMBER || tree.get_kind() == node_kind::ID;
+}
+
+// Operation with a variable on the left and a constant or a variable on the right
+bool is_fusable(const node &operation) {
+    if (!is_assignment(operation.get_kind()) && !is_arithmetic_or_comparison(operation.get_kind()))
+        return false;
+
+    const auto &binary = static_cast<const binary_node&>(operation);
+    return binary.get_left().get_kind() == node_kind::ID && is_leaf(binary.get_right());
+}
+
+template <template <typename, typename> class fused_type, typename operation>
+std::unique_ptr<node> fuse_operands(std::unique_ptr<node> original, const node &operands) {
+    if (static_cast<const binary_node&>(operands).get_right().get_kind() == node_kind::NUMBER)
+        return std::make_unique<fused_type<operation, constant_operand>>(std::move(original));
+
+    return std::make_unique<fused_type<operation, variable_operand>>(std::move(original));
+}
+
+std::unique_ptr<node> fuse_assignment(std::unique_ptr<node> assignment) {
+    const node &operands = *assignment;
+
+    switch (operands.get_kind()) {
+    case node_kind::ASSIGN:
+        return fuse_operands<fused_assign_node, assign_node::operation>(std::move(assignment), operands);
+    case node_kind::PLUS_ASSIGN:
+        return fuse_operands<fused_assign_node, plus_assign_node::operation>(std::move(assignment), operands);
+    case node_kind::MINUS_ASSIGN:
+        return fuse_operands<fused_assign_node, minus_assign_node::operation>(std::move(assignment), operands);
+    case node_kind::MULTIPLY_ASSIGN:
+        return fuse_operands<fused_assign_node, multiply_assign_node::operation>(std::move(assignment), operands);
+    case node_kind::DIVIDE_ASSIGN:
+        if (!is_divisor_checked(operands))
+            return fuse_operands<fused_assign_node, std::divides<int64_t>>(std::move(assignment), operands);
+
+        return fuse_operands<fused_assign_node, divide_assign_node::operation>(std::move(assignment), operands);
+    default:
+        return assignment;
+    }
+}
+
+// Fuses original with the given operator, which is either original itself or its condition
+template <template <typename, typename> class fused_type>
+std::unique_ptr<node> fuse_operator(std::unique_ptr<node> original, const node &operands) {
+    switch (operands.get_kind()) {
+    case node_kind::PLUS:
+        return fuse_operands<fused_type, plus_node::operation>(std::move(original), operands);
+    case node_kind::MINUS:
+        return fuse_operands<fused_type, minus_node::operation>(std::move(original), operands);
+    case node_kind::MULTIPLY:
+        return fuse_operands<fused_type, multiply_node::operation>(std::move(original), operands);
+    case node_kind::DIVIDE:
+        if (!is_divisor_checked(operands))
+            return fuse_operands<fused_type, std::divides<int64_t>>(std::move(original), operands);
+
+        return fuse_operands<fused_type, divide_node::operation>(std::move(original), operands);
+    case node_kind::EQUAL:
+        return fuse_operands<fused_type, equal_node::operation>(std::move(original), operands);
+    case node_kind::LESS:
+        return fuse_operands<fused_type, less_node::operation>(std::move(original), operands);
+    case node_kind::BIGGER:
+        return fuse_operands<fused_type, bigger_node::operation>(std::move(original), operands);
+    case node_kind::LESS_OR_EQUAL:
+        return fuse_operands<fused_type, less_or_equal_node::operation>(std::move(original), operands);
+    case node_kind::BIGGER_OR_EQUAL:
+        return fuse_operands<fused_type, bigger_or_equal_node::operation>(std::move(original), operands);
+    default:
+        return original;
+    }
+}
+
+class fuser {
+public:
+    size_t get_fused_count() const {
+        return fused_;
+    }
+
+    void fuse_scope(node_list &scope) {
+        for (auto &statement: scope)
+            fuse(statement);
+    }
+
+    void fuse(std::unique_ptr<node> &tree) {
+        switch (tree->get_kind()) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(*tree).get_args())
+                fuse(arg);
+            return;
+
+        case node_kind::NEGATE:
+            fuse(static_cast<negate_node&>(*tree).get_child());
+            return;
+
+        case node_kind::IF:
+            fuse_conditional<fused_if_node>(static_cast<if_node&>(*tree), tree);
+            return;
+
+        case node_kind::WHILE:
+            fuse_conditional<fused_while_node>(static_cast<while_node&>(*tree), tree);
+            return;
+
+        default:
+            break;
+        }
+
+        if (!is_assignment(tree->get_kind()) && !is_arithmetic_or_comparison(tree->get_kind()))
+            return;
+
+        if (!is_fusable(*tree)) {
+            auto &binary = static_cast<binary_node&>(*tree);
+            fuse(binary.get_left());
+            fuse(binary.get_right());
+            return;
+        }
+
+        ++ fused_;
+        if (is_assignment(tree->get_kind())) {
+            tree = fuse_assignment(std::move(tree));
+            return;
+        }
+
+        const node &operands = *tree;
+        tree = fuse_operator<fused_operator_node>(std::move(tree), operands);
+    }
+
+private:
+    size_t fused_ = 0;
+
+    template <template <typename, typename> class fused_type, bool is_loop>
+    void fuse_conditional(conditional_operation_node<is_loop> &conditional, std::unique_ptr<node> &tree) {
+        fuse_scope(conditional.get_scope());
+
+        const node &condition = *conditional.get_condition();
+        if (!is_arithmetic_or_comparison(condition.get_kind()) || !is_fusable(condition)) {
+            fuse(conditional.get_condition());
+            return;
+        }
+
+        ++ fused_;
+        tree = fuse_operator<fused_type>(std::move(tree), condition);
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t fuse_superinstructions(ast &tree) {
+    fuser pass;
+    pass.fuse_scope(tree.get_scope());
+
+    return pass.get_fused_count();
+}
+
+} // end namespace paracl
@@ -0,0 +1,226 @@
+#include "paracl/optimizer/induction.h"
+#include "paracl/ast/closed_form_nodes.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+
+
+namespace paracl {
+
+namespace {
+
+class induction_analysis {
+public:
+    explicit induction_analysis(const while_node &loop) {
+        for (const auto &statement: loop.get_scope()) {
+            if (is_assignment(statement->get_kind()))
+                written_.push_back(get_target(*statement));
+        }
+    }
+
+    // Degree of expression as a polynomial of counter, if it's computed
+    // without reading input, failing, or reading other variables loop writes
+    std::optional<int> get_degree(const node &tree, size_t counter) const {
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+            return 0;
+
+        case node_kind::ID: {
+            size_t slot = static_cast<const id_node&>(tree).get_slot();
+            if (slot == counter)
+                return 1;
+
+            if (std::ranges::find(written_, slot) != written_.end())
+                return std::nullopt;
+
+            return 0;
+        }
+
+        case node_kind::NEGATE:
+            return get_degree(static_cast<const negate_node&>(tree).get_child(), counter);
+
+        default:
+            break;
+        }
+
+        if (!is_arithmetic_or_comparison(tree.get_kind()))
+            return std::nullopt;
+
+        const auto &binary = static_cast<const binary_node&>(tree);
+
+        std::optional<int> left  = get_degree(binary.get_left(),  counter);
+        std::optional<int> right = get_degree(binary.get_right(), counter);
+        if (!left || !right)
+            return std::nullopt;
+
+        switch (tree.get_kind()) {
+        case node_kind::PLUS:
+        case node_kind::MINUS:
+            return std::max(*left, *right);
+
+        case node_kind::MULTIPLY:
+            return *left + *right;
+
+        case node_kind::DIVIDE: {
+            const node &divisor = binary.get_right();
+            if (divisor.get_kind() != node_kind::NUMBER)
+                return std::nullopt;
+
+            int64_t value = static_cast<const number_node&>(divisor).get_number();
+            if (value == 0 || value == -1 || *left != 0)
+                return std::nullopt;
+
+            return 0;
+        }
+
+        default:
+            // Comparisons are linear only if they don't depend on counter:
+            if (*left != 0 || *right != 0)
+                return std::nullopt;
+
+            return 0;
+        }
+    }
+
+    static size_t get_target(const node &assignment) {
+        const node &target = static_cast<const binary_node&>(assignment).get_left();
+        return static_cast<const id_node&>(target).get_slot();
+    }
+
+private:
+    std::vector<size_t> written_;
+};
+
+bool is_counter_comparison(node_kind kind) {
+    return kind == node_kind::LESS   || kind == node_kind::LESS_OR_EQUAL ||
+           kind == node_kind::BIGGER || kind == node_kind::BIGGER_OR_EQUAL;
+}
+
+std::optional<int64_t> get_step(const node &assignment) {
+    const node &right = static_cast<const binary_node&>(assignment).get_right();
+    if (right.get_kind() != node_kind::NUMBER)
+        return std::nullopt;
+
+    int64_t step = static_cast<const number_node&>(right).get_number();
+    if (step == 0 || step == std::numeric_limits<int64_t>::min())
+        return std::nullopt;
+
+    return assignment.get_kind() == node_kind::PLUS_ASSIGN ? step : -step;
+}
+
+std::unique_ptr<node> try_closed_form(std::unique_ptr<node> &statement, optimization_remarks *remarks) {
+    auto &loop = static_cast<while_node&>(*statement);
+
+    auto missed = [&](const char *reason) {
+        if (remarks)
+            remarks->missed("induction", loop, reason);
+
+        return nullptr;
+    };
+
+    const node &condition = *loop.get_condition();
+    if (!is_counter_comparison(condition.get_kind()))
+        return missed("loop condition doesn't compare a counter with a bound");
+
+    const auto &comparison = static_cast<const binary_node&>(condition);
+    if (comparison.get_left().get_kind() != node_kind::ID)
+        return missed("loop condition doesn't compare a counter with a bound");
+
+    size_t counter = static_cast<const id_node&>(comparison.get_left()).get_slot();
+    induction_analysis analysis(loop);
+
+    if (analysis.get_degree(comparison.get_right(), counter) != 0)
+        return missed("loop bound changes inside the loop");
+
+    std::optional<int64_t> step;
+    std::vector<closed_form_loop_node::accumulation> accumulations;
+
+    for (const auto &nested: loop.get_scope()) {
+        node_kind kind = nested->get_kind();
+        if (kind != node_kind::PLUS_ASSIGN && kind != node_kind::MINUS_ASSIGN)
+            return missed("loop body does more than add to variables");
+
+        auto &assignment = static_cast<binary_node&>(*nested);
+
+        size_t target = induction_analysis::get_target(assignment);
+        if (target == counter) {
+            if (step) // counter has to be stepped exactly once
+                return missed("counter is stepped more than once per iteration");
+
+            step = get_step(assignment);
+            if (!step)
+                return missed("counter isn't stepped by a constant");
+
+            continue;
+        }
+
+        std::optional<int> degree = analysis.get_degree(*assignment.get_right(), counter);
+        if (!degree || *degree > 1)
+            return missed("value added in the loop isn't linear in the counter");
+
+        accumulations.push_back({
+            .slot = target,
+            .is_subtracted = kind == node_kind::MINUS_ASSIGN,
+            .value = assignment.get_right().get(),
+            .is_after_step = step.has_value()
+        });
+    }
+
+    if (!step)
+        return missed("counter isn't stepped in the loop");
+
+    if (remarks)
+        remarks->passed("induction", loop, "loop is replaced with a closed formula");
+
+    return std::make_unique<closed_form_loop_node>(std::move(statement), counter, *step,
+                                                   std::move(accumulations));
+}
+
+class induction_replacer {
+public:
+    explicit induction_replacer(optimization_remarks *remarks):
+        remarks_(remarks) {}
+
+    size_t get_replaced_count() const {
+        return replaced_;
+    }
+
+    void replace_scope(node_list &scope) {
+        for (auto &statement: scope) {
+            switch (statement->get_kind()) {
+            case node_kind::IF:
+                replace_scope(static_cast<if_node&>(*statement).get_scope());
+                break;
+
+            case node_kind::WHILE:
+                replace_scope(static_cast<while_node&>(*statement).get_scope());
+
+                if (std::unique_ptr<node> replacement = try_closed_form(statement, remarks_)) {
+                    statement = std::move(replacement);
+                    ++ replaced_;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+private:
+    optimization_remarks *remarks_;
+    size_t replaced_ = 0;
+};
+
+} // end anonymous namespace
+
+
+size_t replace_induction_loops(ast &tree, optimization_remarks *remarks) {
+    induction_replacer pass(remarks);
+    pass.replace_scope(tree.get_scope());
+
+    return pass.get_replaced_count();
+}
+
+} // end namespace paracl
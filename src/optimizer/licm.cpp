@@ -0,0 +1,286 @@
+#include "paracl/optimizer/licm.h"
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+namespace paracl {
+
+namespace {
+
+bool reads_input(const node &tree) {
+    switch (tree.get_kind()) {
+    case node_kind::SCAN:
+        return true;
+
+    case node_kind::NEGATE:
+        return reads_input(static_cast<const negate_node&>(tree).get_child());
+
+    default:
+        if (!is_arithmetic_or_comparison(tree.get_kind()))
+            return false;
+
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return reads_input(binary.get_left()) || reads_input(binary.get_right());
+    }
+}
+
+bool can_fault(const node &tree) {
+    switch (tree.get_kind()) {
+    case node_kind::NEGATE:
+        return can_fault(static_cast<const negate_node&>(tree).get_child());
+
+    case node_kind::DIVIDE: {
+        const node &divisor = static_cast<const binary_node&>(tree).get_right();
+        if (divisor.get_kind() != node_kind::NUMBER)
+            return true;
+
+        int64_t value = static_cast<const number_node&>(divisor).get_number();
+        if (value == 0 || value == -1)
+            return true;
+
+        break;
+    }
+
+    default:
+        if (!is_arithmetic_or_comparison(tree.get_kind()))
+            return false;
+
+        break;
+    }
+
+    const auto &binary = static_cast<const binary_node&>(tree);
+    return can_fault(binary.get_left()) || can_fault(binary.get_right());
+}
+
+void collect_writes(const node &tree, std::vector<bool> &written);
+
+template <bool is_loop>
+void collect_writes(const conditional_operation_node<is_loop> &conditional, std::vector<bool> &written) {
+    for (const auto &statement: conditional.get_scope())
+        collect_writes(*statement, written);
+}
+
+void collect_writes(const node &tree, std::vector<bool> &written) {
+    switch (tree.get_kind()) {
+    case node_kind::IF:
+        collect_writes(static_cast<const if_node&>(tree), written);
+        return;
+
+    case node_kind::WHILE:
+        collect_writes(static_cast<const while_node&>(tree), written);
+        return;
+
+    default:
+        if (!is_assignment(tree.get_kind()))
+            return;
+
+        const node &target = static_cast<const binary_node&>(tree).get_left();
+        written[static_cast<const id_node&>(target).get_slot()] = true;
+        return;
+    }
+}
+
+class hoister {
+public:
+    hoister(context &ctx, optimization_remarks *remarks):
+        context_(ctx), remarks_(remarks) {}
+
+    size_t get_hoisted_count() const {
+        return hoisted_;
+    }
+
+    // Loops are processed from the outermost, so everything that's invariant
+    // in the outer loop leaves both of them, and only the rest stays in outer
+    // loop's body, in front of the inner loop.
+    void hoist_scope(node_list &scope) {
+        node_list hoisted;
+
+        for (auto &statement: scope) {
+            switch (statement->get_kind()) {
+            case node_kind::IF:
+                hoist_scope(static_cast<if_node&>(*statement).get_scope());
+                break;
+
+            case node_kind::WHILE: {
+                auto &loop = static_cast<while_node&>(*statement);
+                hoist_loop(loop, hoisted);
+                hoist_scope(loop.get_scope());
+                break;
+            }
+
+            default:
+                break;
+            }
+
+            hoisted.push_back(std::move(statement));
+        }
+
+        scope = std::move(hoisted);
+    }
+
+private:
+    context &context_;
+    optimization_remarks *remarks_;
+
+    size_t hoisted_ = 0;
+
+    struct loop_state {
+        std::vector<bool> written;
+        std::unordered_map<std::string, std::pair<std::string, size_t>> temporaries;
+        node_list &preheader;
+    };
+
+    void hoist_loop(while_node &loop, node_list &preheader) {
+        loop_state state { std::vector<bool>(context_.get_variable_count(), false), {}, preheader };
+        collect_writes(loop, state.written);
+
+        auto &condition = loop.get_condition();
+        hoist_expression(condition, state, !reads_input(*condition));
+
+        hoist_statements(loop.get_scope(), state);
+    }
+
+    void hoist_statements(node_list &scope, loop_state &state) {
+        for (auto &statement: scope) {
+            switch (statement->get_kind()) {
+            case node_kind::IF: {
+                auto &nested = static_cast<if_node&>(*statement);
+                hoist_expression(nested.get_condition(), state, false);
+                hoist_statements(nested.get_scope(), state);
+                break;
+            }
+
+            case node_kind::WHILE: {
+                auto &nested = static_cast<while_node&>(*statement);
+                hoist_expression(nested.get_condition(), state, false);
+                hoist_statements(nested.get_scope(), state);
+                break;
+            }
+
+            default:
+                if (is_assignment(statement->get_kind()))
+                    hoist_expression(static_cast<binary_node&>(*statement).get_right(), state, false);
+                else
+                    hoist_expression(statement, state, false);
+                break;
+            }
+        }
+    }
+
+    bool is_invariant(const node &tree, const loop_state &state) const {
+        switch (tree.get_kind()) {
+        // Input is never hoisted anyway, but it's checked separately, so that
+        // it can be reported as the only thing that keeps expression in the loop:
+        case node_kind::NUMBER:
+        case node_kind::SCAN:
+            return true;
+
+        case node_kind::ID: {
+            size_t slot = static_cast<const id_node&>(tree).get_slot();
+            return slot >= state.written.size() || !state.written[slot];
+        }
+
+        case node_kind::NEGATE:
+            return is_invariant(static_cast<const negate_node&>(tree).get_child(), state);
+
+        default:
+            if (!is_arithmetic_or_comparison(tree.get_kind()))
+                return false;
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            return is_invariant(binary.get_left(), state) && is_invariant(binary.get_right(), state);
+        }
+    }
+
+    // Replaces largest invariant subexpressions with temporaries. Only the largest
+    // expression that can't be hoisted is reported, not every part of it.
+    void hoist_expression(std::unique_ptr<node> &expression, loop_state &state, bool allow_faults,
+                          bool is_reported = false) {
+        node_kind kind = expression->get_kind();
+        if (kind == node_kind::NUMBER || kind == node_kind::ID)
+            return;
+
+        if (is_invariant(*expression, state)) {
+            if (!reads_input(*expression) && (allow_faults || !can_fault(*expression))) {
+                if (remarks_)
+                    remarks_->passed("licm", *expression, "invariant expression is hoisted out of the loop");
+
+                expression = create_temporary(std::move(expression), state);
+                return;
+            }
+
+            if (remarks_ && !is_reported && kind != node_kind::SCAN) {
+                remarks_->missed("licm", *expression, reads_input(*expression)
+                    ? "scan inside loop body prevents hoisting this invariant expression"
+                    : "division that can fail is never hoisted, loop might not run it");
+                is_reported = true;
+            }
+        }
+
+        switch (kind) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(*expression).get_args())
+                hoist_expression(arg, state, allow_faults, is_reported);
+            return;
+
+        case node_kind::NEGATE:
+            hoist_expression(static_cast<negate_node&>(*expression).get_child(), state, allow_faults, is_reported);
+            return;
+
+        default: {
+            if (!is_arithmetic_or_comparison(kind))
+                return;
+
+            auto &binary = static_cast<binary_node&>(*expression);
+            hoist_expression(binary.get_left(), state, allow_faults, is_reported);
+            hoist_expression(binary.get_right(), state, allow_faults, is_reported);
+            return;
+        }
+        }
+    }
+
+    std::unique_ptr<node> create_temporary(std::unique_ptr<node> expression, loop_state &state) {
+        // Same text reads same variables, so its value is the same too:
+        std::stringstream text;
+        expression->dump(text);
+
+        auto [it, inserted] = state.temporaries.try_emplace(text.str());
+        auto &[name, slot] = it->second;
+
+        if (inserted) {
+            name = get_temporary_name();
+            slot = context_.create_variable(name);
+
+            auto target = std::make_unique<id_node>(name, slot);
+            state.preheader.push_back(std::make_unique<assign_node>(std::move(target), std::move(expression)));
+
+            ++ hoisted_;
+        }
+
+        return std::make_unique<id_node>(name, slot);
+    }
+
+    // Such names can't come from the source, so they never clash with user's variables
+    std::string get_temporary_name() const {
+        for (size_t index = 0; ; ++ index) {
+            std::string name = "$licm" + std::to_string(index);
+            if (!context_.check_var_existing(name))
+                return name;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t hoist_loop_invariants(ast &tree, optimization_remarks *remarks) {
+    hoister pass(tree.get_context(), remarks);
+    pass.hoist_scope(tree.get_scope());
+
+    return pass.get_hoisted_count();
+}
+
+} // end namespace paracl
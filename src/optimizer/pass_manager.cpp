@@ -0,0 +1,283 @@
+#include "paracl/optimizer/pass_manager.h"
+#include "paracl/optimizer/cse.h"
+#include "paracl/optimizer/dead_stores.h"
+#include "paracl/optimizer/folding.h"
+#include "paracl/optimizer/fusion.h"
+#include "paracl/optimizer/induction.h"
+#include "paracl/optimizer/licm.h"
+#include "paracl/optimizer/propagation.h"
+#include "paracl/optimizer/ranges.h"
+#include "paracl/optimizer/slots.h"
+#include "paracl/optimizer/unrolling.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <iomanip>
+#include <stdexcept>
+
+
+namespace paracl {
+
+namespace {
+
+template <size_t (*pass)(ast&)>
+size_t without_remarks(ast &tree, [[maybe_unused]] optimization_remarks *remarks) {
+    return pass(tree);
+}
+
+const optimization_pass default_passes[] = {
+    { "propagation", "sccp",   without_remarks<propagate_constants>             },
+    { "folding",     "fold",   without_remarks<fold_constants>                  },
+    { "licm",        nullptr,  hoist_loop_invariants                            },
+    { "dead-stores", "dce",    without_remarks<eliminate_dead_stores>           },
+    { "slots",       nullptr,  without_remarks<share_variable_slots>            },
+    { "induction",   nullptr,  replace_induction_loops                          },
+    { "ranges",      nullptr,  remove_divisor_checks                            },
+    { "unrolling",   "unroll", unroll_loops                                     },
+    { "cse",         nullptr,  without_remarks<eliminate_common_subexpressions> },
+    { "fusion",      nullptr,  without_remarks<fuse_superinstructions>          },
+};
+
+// Closed form nodes replace loops after induction, these passes don't expect them
+bool is_closed_form_blind(std::string_view name) {
+    return name == "folding" || name == "licm" || name == "dead-stores";
+}
+
+size_t count_nodes(const node &tree) {
+    const node &current = get_unfused(tree);
+
+    switch (current.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::ID:
+    case node_kind::SCAN:
+        return 1;
+
+    case node_kind::FUNCTION: {
+        size_t count = 1;
+        for (const auto &arg: static_cast<const function_node&>(current).get_args())
+            count += count_nodes(*arg);
+        return count;
+    }
+
+    case node_kind::NEGATE:
+        return 1 + count_nodes(static_cast<const negate_node&>(current).get_child());
+
+    case node_kind::IF:
+    case node_kind::WHILE: {
+        const auto &conditional = static_cast<const while_node&>(current);
+
+        size_t count = 1 + count_nodes(conditional.get_condition());
+        for (const auto &statement: conditional.get_scope())
+            count += count_nodes(*statement);
+        return count;
+    }
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(current);
+        return 1 + count_nodes(binary.get_left()) + count_nodes(binary.get_right());
+    }
+    }
+}
+
+class tree_verifier {
+public:
+    explicit tree_verifier(const context &ctx):
+        context_(ctx) {}
+
+    std::optional<std::string> verify_scope(const node_list &scope) {
+        for (const auto &statement: scope) {
+            if (!statement)
+                return "missing statement";
+
+            if (std::optional<std::string> problem = verify_statement(*statement))
+                return problem;
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    const context &context_;
+
+    std::optional<std::string> verify_statement(const node &statement) {
+        const node &current = get_unfused(statement);
+
+        switch (current.get_kind()) {
+        case node_kind::IF:
+        case node_kind::WHILE: {
+            const auto &conditional = static_cast<const while_node&>(current);
+            if (std::optional<std::string> problem = verify_expression(&conditional.get_condition()))
+                return problem;
+
+            return verify_scope(conditional.get_scope());
+        }
+
+        default:
+            break;
+        }
+
+        // Calls, and dead stores that are kept for side effects of their values:
+        if (!is_assignment(current.get_kind()))
+            return verify_expression(&current);
+
+        const auto &assignment = static_cast<const binary_node&>(current);
+        if (assignment.get_left().get_kind() != node_kind::ID)
+            return "assignment to something that isn't a variable";
+
+        if (std::optional<std::string> problem = verify_expression(&assignment.get_left()))
+            return problem;
+
+        return verify_expression(&assignment.get_right());
+    }
+
+    std::optional<std::string> verify_expression(const node *expression) {
+        if (!expression)
+            return "missing operand";
+
+        const node &current = get_unfused(*expression);
+
+        switch (current.get_kind()) {
+        case node_kind::NUMBER:
+        case node_kind::SCAN:
+            return std::nullopt;
+
+        case node_kind::ID: {
+            const auto &id = static_cast<const id_node&>(current);
+            if (id.get_slot() >= context_.get_variable_count())
+                return "variable " + id.get_name() + " refers to a slot that doesn't exist";
+
+            if (!context_.has_name(id.get_slot(), id.get_name()))
+                return "variable " + id.get_name() + " refers to a slot of " + context_.get_name(id.get_slot());
+
+            return std::nullopt;
+        }
+
+        case node_kind::FUNCTION:
+            for (const auto &arg: static_cast<const function_node&>(current).get_args()) {
+                if (std::optional<std::string> problem = verify_expression(arg.get()))
+                    return problem;
+            }
+            return std::nullopt;
+
+        case node_kind::NEGATE:
+            return verify_expression(&static_cast<const negate_node&>(current).get_child());
+
+        default:
+            break;
+        }
+
+        if (!is_arithmetic_or_comparison(current.get_kind()))
+            return "statement used as an operand";
+
+        const auto &binary = static_cast<const binary_node&>(current);
+        if (std::optional<std::string> problem = verify_expression(&binary.get_left()))
+            return problem;
+
+        return verify_expression(&binary.get_right());
+    }
+};
+
+} // end anonymous namespace
+
+
+std::span<const optimization_pass> get_default_passes() {
+    return default_passes;
+}
+
+const optimization_pass *find_pass(std::string_view name) {
+    for (const optimization_pass &pass: default_passes) {
+        if (pass.name == name || (pass.alias && pass.alias == name))
+            return &pass;
+    }
+
+    return nullptr;
+}
+
+size_t count_nodes(const ast &tree) {
+    size_t count = 0;
+    for (const auto &statement: tree.get_scope())
+        count += count_nodes(*statement);
+
+    return count;
+}
+
+std::optional<std::string> verify_tree(const ast &tree) {
+    tree_verifier verifier(tree.get_context());
+    return verifier.verify_scope(tree.get_scope());
+}
+
+std::optional<pass_manager> pass_manager::parse(std::string_view pipeline) {
+    pass_manager manager;
+    bool has_closed_forms = false;
+
+    while (!pipeline.empty()) {
+        size_t comma = std::min(pipeline.find(','), pipeline.size());
+
+        const optimization_pass *pass = find_pass(pipeline.substr(0, comma));
+        if (!pass)
+            return std::nullopt;
+
+        // Fused nodes cache slots and hide their operands from other passes:
+        if (!manager.passes_.empty() && std::string_view(manager.passes_.back().name) == "fusion")
+            return std::nullopt;
+
+        if (has_closed_forms && is_closed_form_blind(pass->name))
+            return std::nullopt;
+
+        has_closed_forms = has_closed_forms || std::string_view(pass->name) == "induction";
+
+        manager.add_pass(*pass);
+        pipeline.remove_prefix(std::min(comma + 1, pipeline.size()));
+    }
+
+    return manager;
+}
+
+void pass_manager::run(ast &tree) {
+    statistics_.clear();
+
+    // Nodes that passes make go to the same arena as parsed ones:
+    arena::scope in_arena{tree.get_arena()};
+
+    for (const optimization_pass &pass: passes_) {
+        size_t nodes_before = count_nodes(tree);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t changes = pass.run(tree, remarks_);
+        auto end = std::chrono::steady_clock::now();
+
+        statistics_.push_back({
+            .name = pass.name,
+            .changes = changes,
+            .nodes_before = nodes_before,
+            .nodes_after = count_nodes(tree),
+            .time = end - start
+        });
+
+        if (!verify_)
+            continue;
+
+        if (std::optional<std::string> problem = verify_tree(tree))
+            throw std::logic_error(std::string("pass ") + pass.name + " broke the tree: " + *problem);
+    }
+}
+
+void pass_manager::dump_statistics(std::ostream &ostr) const {
+    ostr << std::left  << std::setw(14) << "pass"
+         << std::right << std::setw(10) << "changes" << std::setw(10) << "before"
+                       << std::setw(10) << "after"   << std::setw(12) << "time, ms" << "\n";
+
+    std::chrono::duration<double> total{};
+    for (const pass_statistics &pass: statistics_) {
+        ostr << std::left  << std::setw(14) << pass.name
+             << std::right << std::setw(10) << pass.changes << std::setw(10) << pass.nodes_before
+                           << std::setw(10) << pass.nodes_after
+                           << std::setw(12) << std::fixed << std::setprecision(3) << pass.time.count() * 1000 << "\n";
+
+        total += pass.time;
+    }
+
+    ostr << std::left  << std::setw(44) << "total"
+         << std::right << std::setw(12) << std::fixed << std::setprecision(3) << total.count() * 1000 << "\n";
+}
+
+} // end namespace paracl
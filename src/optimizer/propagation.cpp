@@ -0,0 +1,296 @@
+#include "paracl/optimizer/propagation.h"
+#include "paracl/optimizer/folding.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+
+namespace paracl {
+
+namespace {
+
+// What is known about a variable at some point of the program
+struct variable_state {
+    std::optional<int64_t> constant;
+
+    // Variable it was assigned from, neither was written since
+    std::optional<size_t> copy_of;
+
+    bool operator==(const variable_state&) const = default;
+};
+
+using state = std::vector<variable_state>;
+
+// Keeps only what is known on both paths
+void merge(state &known, const state &other) {
+    for (size_t slot = 0; slot < known.size(); ++ slot) {
+        if (known[slot].constant != other[slot].constant)
+            known[slot].constant = std::nullopt;
+
+        if (known[slot].copy_of != other[slot].copy_of)
+            known[slot].copy_of = std::nullopt;
+    }
+}
+
+std::optional<int64_t> evaluate(const node &tree, const state &known) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+        return static_cast<const number_node&>(tree).get_number();
+
+    case node_kind::ID:
+        return known[static_cast<const id_node&>(tree).get_slot()].constant;
+
+    case node_kind::NEGATE: {
+        std::optional<int64_t> value = evaluate(static_cast<const negate_node&>(tree).get_child(), known);
+        if (!value || *value == std::numeric_limits<int64_t>::min())
+            return std::nullopt;
+
+        return -*value;
+    }
+
+    default:
+        break;
+    }
+
+    if (!is_arithmetic_or_comparison(tree.get_kind()))
+        return std::nullopt;
+
+    const auto &binary = static_cast<const binary_node&>(tree);
+
+    std::optional<int64_t> lhs = evaluate(binary.get_left(), known);
+    std::optional<int64_t> rhs = evaluate(binary.get_right(), known);
+    if (!lhs || !rhs)
+        return std::nullopt;
+
+    return evaluate_operation(tree.get_kind(), *lhs, *rhs);
+}
+
+node_kind get_operation(node_kind assignment) {
+    switch (assignment) {
+    case node_kind::PLUS_ASSIGN:     return node_kind::PLUS;
+    case node_kind::MINUS_ASSIGN:    return node_kind::MINUS;
+    case node_kind::MULTIPLY_ASSIGN: return node_kind::MULTIPLY;
+    case node_kind::DIVIDE_ASSIGN:   return node_kind::DIVIDE;
+    default:                         return assignment;
+    }
+}
+
+class propagator {
+public:
+    explicit propagator(const context &ctx):
+        context_(ctx) {}
+
+    size_t get_folded_count() const {
+        return folded_;
+    }
+
+    // Walks scope forward, known holds what is known before the scope and becomes
+    // what is known after it. Scope is rewritten only if rewrite is set, otherwise
+    // it's just analyzed.
+    void transfer_scope(node_list &scope, state &known, bool rewrite) {
+        if (!rewrite) {
+            for (auto &statement: scope)
+                transfer_statement(statement, known, nullptr);
+            return;
+        }
+
+        node_list kept;
+        for (auto &statement: scope)
+            transfer_statement(statement, known, &kept);
+
+        scope = std::move(kept);
+    }
+
+private:
+    const context &context_;
+    size_t folded_ = 0;
+
+    // Rewritten statement is moved to kept, or statements it's replaced with, if any
+    void transfer_statement(std::unique_ptr<node> &statement, state &known,
+                            node_list *kept) {
+        switch (statement->get_kind()) {
+        case node_kind::IF:
+            transfer_if(statement, known, kept);
+            return;
+
+        case node_kind::WHILE:
+            transfer_while(statement, known, kept);
+            return;
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            // Replacements cache parts of their originals, so they are never rewritten,
+            // and nothing is assumed about variables after them:
+            known.assign(known.size(), variable_state{});
+            break;
+
+        default:
+            if (is_assignment(statement->get_kind())) {
+                transfer_assignment(statement, known, kept != nullptr);
+                break;
+            }
+
+            if (kept)
+                replace_uses(statement, known);
+            break;
+        }
+
+        if (kept)
+            kept->push_back(std::move(statement));
+    }
+
+    void transfer_if(std::unique_ptr<node> &statement, state &known,
+                     node_list *kept) {
+        auto &if_statement = static_cast<if_node&>(*statement);
+        std::optional<int64_t> condition = evaluate(*if_statement.get_condition(), known);
+
+        // Known conditions are pure, there is nothing left to run when body is dropped:
+        if (condition == 0)
+            return;
+
+        if (condition) {
+            transfer_scope(if_statement.get_scope(), known, kept != nullptr);
+            if (kept) {
+                for (auto &nested: if_statement.get_scope())
+                    kept->push_back(std::move(nested));
+            }
+            return;
+        }
+
+        if (kept)
+            replace_uses(if_statement.get_condition(), known);
+
+        state body = known;
+        transfer_scope(if_statement.get_scope(), body, kept != nullptr);
+        merge(known, body);
+
+        if (kept)
+            kept->push_back(std::move(statement));
+    }
+
+    void transfer_while(std::unique_ptr<node> &statement, state &known,
+                        node_list *kept) {
+        auto &while_statement = static_cast<while_node&>(*statement);
+
+        // Whatever body changes isn't known at the loop head, repeat until it stops changing:
+        state head = known;
+        while (evaluate(*while_statement.get_condition(), head) != 0) {
+            state body = head;
+            transfer_scope(while_statement.get_scope(), body, false);
+
+            state merged = head;
+            merge(merged, body);
+            if (merged == head)
+                break;
+
+            head = std::move(merged);
+        }
+
+        known = head;
+        if (!kept)
+            return;
+
+        if (evaluate(*while_statement.get_condition(), head) == 0)
+            return;
+
+        replace_uses(while_statement.get_condition(), head);
+        transfer_scope(while_statement.get_scope(), head, true);
+
+        kept->push_back(std::move(statement));
+    }
+
+    void transfer_assignment(std::unique_ptr<node> &statement, state &known, bool rewrite) {
+        auto &assignment = static_cast<binary_node&>(*statement);
+        size_t slot = static_cast<const id_node&>(*assignment.get_left()).get_slot();
+
+        std::optional<size_t> copy_of = get_copy_source(*assignment.get_right(), known);
+        if (statement->get_kind() != node_kind::ASSIGN || copy_of == slot)
+            copy_of = std::nullopt;
+
+        if (rewrite)
+            replace_uses(assignment.get_right(), known);
+
+        std::optional<int64_t> value = evaluate(*assignment.get_right(), known);
+        if (statement->get_kind() != node_kind::ASSIGN) {
+            std::optional<int64_t> old = known[slot].constant;
+            value = old && value ? evaluate_operation(get_operation(statement->get_kind()), *old, *value)
+                                 : std::nullopt;
+
+            // Variable's old value is a use too, with it known whole assignment is:
+            if (rewrite && value) {
+                statement = std::make_unique<assign_node>(std::move(assignment.get_left()),
+                                                          std::make_unique<number_node>(*value));
+                ++ folded_;
+            }
+        }
+
+        for (variable_state &variable: known) {
+            if (variable.copy_of == slot)
+                variable.copy_of = std::nullopt;
+        }
+
+        known[slot] = { .constant = value, .copy_of = copy_of };
+    }
+
+    // Variable that read of the given one really reads, following copies
+    std::optional<size_t> get_copy_source(const node &tree, const state &known) const {
+        if (tree.get_kind() != node_kind::ID)
+            return std::nullopt;
+
+        size_t slot = static_cast<const id_node&>(tree).get_slot();
+        return known[slot].copy_of ? known[slot].copy_of : slot;
+    }
+
+    void replace_uses(std::unique_ptr<node> &tree, const state &known) {
+        switch (tree->get_kind()) {
+        case node_kind::ID: {
+            const variable_state &variable = known[static_cast<const id_node&>(*tree).get_slot()];
+            if (variable.constant) {
+                tree = std::make_unique<number_node>(*variable.constant);
+                ++ folded_;
+            } else if (variable.copy_of) {
+                tree = std::make_unique<id_node>(context_.get_name(*variable.copy_of), *variable.copy_of);
+                ++ folded_;
+            }
+            return;
+        }
+
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(*tree).get_args())
+                replace_uses(arg, known);
+            return;
+
+        case node_kind::NEGATE:
+            replace_uses(static_cast<negate_node&>(*tree).get_child(), known);
+            return;
+
+        default:
+            break;
+        }
+
+        if (!is_arithmetic_or_comparison(tree->get_kind()))
+            return;
+
+        auto &binary = static_cast<binary_node&>(*tree);
+        replace_uses(binary.get_left(), known);
+        replace_uses(binary.get_right(), known);
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t propagate_constants(ast &tree) {
+    const context &ctx = tree.get_context();
+
+    // Variables can be set before the program runs, so nothing is known about them:
+    state known(ctx.get_variable_count());
+
+    propagator pass(ctx);
+    pass.transfer_scope(tree.get_scope(), known, true);
+
+    return pass.get_folded_count();
+}
+
+} // end namespace paracl
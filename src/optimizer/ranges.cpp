@@ -0,0 +1,391 @@
+#include "paracl/optimizer/ranges.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+
+
+namespace paracl {
+
+namespace {
+
+using wide = __int128;
+
+constexpr int64_t min_value = std::numeric_limits<int64_t>::min();
+constexpr int64_t max_value = std::numeric_limits<int64_t>::max();
+
+// Values from min to max, inclusive
+struct range {
+    int64_t min = min_value;
+    int64_t max = max_value;
+
+    bool contains(int64_t value) const {
+        return min <= value && value <= max;
+    }
+
+    bool operator==(const range&) const = default;
+};
+
+// Arithmetic wraps around, so a result that doesn't fit can be anything
+range make_range(wide min, wide max) {
+    if (min < min_value || max > max_value)
+        return {};
+
+    return { static_cast<int64_t>(min), static_cast<int64_t>(max) };
+}
+
+range join(range lhs, range rhs) {
+    return { std::min(lhs.min, rhs.min), std::max(lhs.max, rhs.max) };
+}
+
+// Bounds that keep moving go straight to the end, so loops reach fixed point fast
+range widen(range old, range next) {
+    return { next.min < old.min ? min_value : old.min,
+             next.max > old.max ? max_value : old.max };
+}
+
+using state = std::vector<range>;
+
+void join(state &known, const state &other) {
+    for (size_t slot = 0; slot < known.size(); ++ slot)
+        known[slot] = join(known[slot], other[slot]);
+}
+
+range apply(node_kind operation, range lhs, range rhs) {
+    switch (operation) {
+    case node_kind::PLUS_ASSIGN:
+    case node_kind::PLUS:
+        return make_range(wide{lhs.min} + rhs.min, wide{lhs.max} + rhs.max);
+
+    case node_kind::MINUS_ASSIGN:
+    case node_kind::MINUS:
+        return make_range(wide{lhs.min} - rhs.max, wide{lhs.max} - rhs.min);
+
+    case node_kind::MULTIPLY_ASSIGN:
+    case node_kind::MULTIPLY: {
+        wide corners[] = { wide{lhs.min} * rhs.min, wide{lhs.min} * rhs.max,
+                           wide{lhs.max} * rhs.min, wide{lhs.max} * rhs.max };
+
+        return make_range(std::ranges::min(corners), std::ranges::max(corners));
+    }
+
+    case node_kind::DIVIDE_ASSIGN:
+    case node_kind::DIVIDE: {
+        if (rhs.contains(0)) {
+            // Division never makes value bigger by absolute value
+            wide largest = std::max(-wide{lhs.min}, wide{lhs.max});
+            return make_range(-largest, largest);
+        }
+
+        // With divisor of a single sign, division is monotonic in both operands
+        wide corners[] = { wide{lhs.min} / rhs.min, wide{lhs.min} / rhs.max,
+                           wide{lhs.max} / rhs.min, wide{lhs.max} / rhs.max };
+
+        return make_range(std::ranges::min(corners), std::ranges::max(corners));
+    }
+
+    case node_kind::EQUAL:
+    case node_kind::LESS:
+    case node_kind::BIGGER:
+    case node_kind::LESS_OR_EQUAL:
+    case node_kind::BIGGER_OR_EQUAL:
+        return { 0, 1 };
+
+    default:
+        return {};
+    }
+}
+
+range evaluate(const node &tree, const state &known) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER: {
+        int64_t value = static_cast<const number_node&>(tree).get_number();
+        return { value, value };
+    }
+
+    case node_kind::ID:
+        return known[static_cast<const id_node&>(tree).get_slot()];
+
+    case node_kind::NEGATE: {
+        range value = evaluate(static_cast<const negate_node&>(tree).get_child(), known);
+        return make_range(-wide{value.max}, -wide{value.min});
+    }
+
+    default:
+        break;
+    }
+
+    if (!is_arithmetic_or_comparison(tree.get_kind()))
+        return {};
+
+    const auto &binary = static_cast<const binary_node&>(tree);
+    return apply(tree.get_kind(), evaluate(binary.get_left(), known), evaluate(binary.get_right(), known));
+}
+
+// Comparison that holds when the given one holds with its operands swapped
+node_kind mirror(node_kind comparison) {
+    switch (comparison) {
+    case node_kind::LESS:            return node_kind::BIGGER;
+    case node_kind::BIGGER:          return node_kind::LESS;
+    case node_kind::LESS_OR_EQUAL:   return node_kind::BIGGER_OR_EQUAL;
+    case node_kind::BIGGER_OR_EQUAL: return node_kind::LESS_OR_EQUAL;
+    default:                         return comparison;
+    }
+}
+
+// Comparison that holds whenever the given one doesn't
+std::optional<node_kind> negate(node_kind comparison) {
+    switch (comparison) {
+    case node_kind::LESS:            return node_kind::BIGGER_OR_EQUAL;
+    case node_kind::BIGGER:          return node_kind::LESS_OR_EQUAL;
+    case node_kind::LESS_OR_EQUAL:   return node_kind::BIGGER;
+    case node_kind::BIGGER_OR_EQUAL: return node_kind::LESS;
+    default:                         return std::nullopt;
+    }
+}
+
+// Narrows variable's range, knowing that `variable comparison bound` holds
+void narrow(range &variable, node_kind comparison, range bound) {
+    range narrowed = variable;
+
+    switch (comparison) {
+    case node_kind::LESS:
+        if (bound.max == min_value)
+            return;
+        narrowed.max = std::min(variable.max, bound.max - 1);
+        break;
+
+    case node_kind::LESS_OR_EQUAL:
+        narrowed.max = std::min(variable.max, bound.max);
+        break;
+
+    case node_kind::BIGGER:
+        if (bound.min == max_value)
+            return;
+        narrowed.min = std::max(variable.min, bound.min + 1);
+        break;
+
+    case node_kind::BIGGER_OR_EQUAL:
+        narrowed.min = std::max(variable.min, bound.min);
+        break;
+
+    case node_kind::EQUAL:
+        narrowed = { std::max(variable.min, bound.min), std::min(variable.max, bound.max) };
+        break;
+
+    default:
+        return;
+    }
+
+    // Path that can't be taken at all isn't tracked, it just keeps what was known
+    if (narrowed.min <= narrowed.max)
+        variable = narrowed;
+}
+
+// Narrows ranges of variables in condition, knowing that it's either true or false
+void assume(const node &condition, bool is_true, state &known) {
+    if (condition.get_kind() == node_kind::ID) {
+        range &variable = known[static_cast<const id_node&>(condition).get_slot()];
+        if (!is_true) {
+            narrow(variable, node_kind::EQUAL, { 0, 0 });
+            return;
+        }
+
+        // Non-zero is a hole in the middle, it can only cut zero off an edge
+        if (variable.min == 0 && variable.max != 0)
+            variable.min = 1;
+
+        if (variable.max == 0 && variable.min != 0)
+            variable.max = -1;
+        return;
+    }
+
+    node_kind kind = condition.get_kind();
+    if (kind != node_kind::EQUAL && !negate(kind))
+        return;
+
+    // Unequal values can be on both sides, that says nothing about a range:
+    std::optional<node_kind> comparison = is_true ? kind : negate(kind);
+    if (!comparison)
+        return;
+
+    const auto &binary = static_cast<const binary_node&>(condition);
+    range left  = evaluate(binary.get_left(),  known);
+    range right = evaluate(binary.get_right(), known);
+
+    if (binary.get_left().get_kind() == node_kind::ID)
+        narrow(known[static_cast<const id_node&>(binary.get_left()).get_slot()], *comparison, right);
+
+    if (binary.get_right().get_kind() == node_kind::ID)
+        narrow(known[static_cast<const id_node&>(binary.get_right()).get_slot()], mirror(*comparison), left);
+}
+
+class range_analysis {
+public:
+    explicit range_analysis(optimization_remarks *remarks):
+        remarks_(remarks) {}
+
+    size_t get_removed_count() const {
+        return removed_;
+    }
+
+    // Walks scope forward, known holds ranges before the scope and becomes ranges
+    // after it. Checks are removed only if rewrite is set, otherwise it's just analyzed.
+    void transfer_scope(node_list &scope, state &known, bool rewrite) {
+        for (auto &statement: scope)
+            transfer_statement(*statement, known, rewrite);
+    }
+
+private:
+    optimization_remarks *remarks_;
+    size_t removed_ = 0;
+
+    void transfer_statement(node &statement, state &known, bool rewrite) {
+        switch (statement.get_kind()) {
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(statement);
+            if (rewrite)
+                remove_checks(*if_statement.get_condition(), known);
+
+            state body = known;
+            assume(*if_statement.get_condition(), true, body);
+            transfer_scope(if_statement.get_scope(), body, rewrite);
+
+            assume(*if_statement.get_condition(), false, known);
+            join(known, body);
+            return;
+        }
+
+        case node_kind::WHILE:
+            transfer_while(static_cast<while_node&>(statement), known, rewrite);
+            return;
+
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            // Checks in replacements are left as is, and variables they write can be anything:
+            known.assign(known.size(), range{});
+            return;
+
+        default:
+            break;
+        }
+
+        if (!is_assignment(statement.get_kind())) {
+            if (rewrite)
+                remove_checks(statement, known);
+            return;
+        }
+
+        auto &assignment = static_cast<binary_node&>(statement);
+        if (rewrite)
+            remove_checks(*assignment.get_right(), known);
+
+        size_t slot = static_cast<const id_node&>(*assignment.get_left()).get_slot();
+        range value = evaluate(*assignment.get_right(), known);
+
+        if (statement.get_kind() == node_kind::DIVIDE_ASSIGN && rewrite)
+            remove_check(statement, value);
+
+        known[slot] = statement.get_kind() == node_kind::ASSIGN
+            ? value : apply(statement.get_kind(), known[slot], value);
+    }
+
+    void transfer_while(while_node &loop, state &known, bool rewrite) {
+        const node &condition = *loop.get_condition();
+
+        // Ranges at the loop head cover every iteration once they stop growing:
+        state head = known;
+        for (;;) {
+            state body = head;
+            assume(condition, true, body);
+            transfer_scope(loop.get_scope(), body, false);
+
+            state next = head;
+            join(next, body);
+            if (next == head)
+                break;
+
+            for (size_t slot = 0; slot < head.size(); ++ slot)
+                head[slot] = widen(head[slot], next[slot]);
+        }
+
+        if (rewrite) {
+            remove_checks(*loop.get_condition(), head);
+
+            state body = head;
+            assume(condition, true, body);
+            transfer_scope(loop.get_scope(), body, true);
+        }
+
+        assume(condition, false, head);
+        known = std::move(head);
+    }
+
+    void remove_check(node &division, range divisor) {
+        if (!is_divisor_checked(division))
+            return;
+
+        if (divisor.contains(0)) {
+            if (remarks_)
+                remarks_->missed("ranges", division, divisor == range{}
+                    ? "divisor can be anything, so it's checked for zero"
+                    : "divisor is in [" + std::to_string(divisor.min) + ", " + std::to_string(divisor.max)
+                      + "], so it's checked for zero");
+            return;
+        }
+
+        if (remarks_)
+            remarks_->passed("ranges", division, "divisor is never zero here, its check is removed");
+
+        if (division.get_kind() == node_kind::DIVIDE)
+            static_cast<divide_node&>(division).set_divisor_checked(false);
+        else
+            static_cast<divide_assign_node&>(division).set_divisor_checked(false);
+
+        ++ removed_;
+    }
+
+    void remove_checks(node &expression, const state &known) {
+        switch (expression.get_kind()) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(expression).get_args())
+                remove_checks(*arg, known);
+            return;
+
+        case node_kind::NEGATE:
+            remove_checks(*static_cast<negate_node&>(expression).get_child(), known);
+            return;
+
+        default:
+            break;
+        }
+
+        if (!is_arithmetic_or_comparison(expression.get_kind()))
+            return;
+
+        auto &binary = static_cast<binary_node&>(expression);
+        remove_checks(*binary.get_left(), known);
+        remove_checks(*binary.get_right(), known);
+
+        if (expression.get_kind() == node_kind::DIVIDE)
+            remove_check(expression, evaluate(*binary.get_right(), known));
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t remove_divisor_checks(ast &tree, optimization_remarks *remarks) {
+    // Variables can be set before the program runs, so they can be anything:
+    state known(tree.get_context().get_variable_count());
+
+    range_analysis pass(remarks);
+    pass.transfer_scope(tree.get_scope(), known, true);
+
+    return pass.get_removed_count();
+}
+
+} // end namespace paracl
@@ -0,0 +1,70 @@
+#include "paracl/optimizer/remarks.h"
+
+#include <print>
+
+
+namespace paracl {
+
+namespace {
+
+const char *get_kind_name(remark_kind kind) {
+    return kind == remark_kind::PASSED ? "passed" : "missed";
+}
+
+void dump_json_string(std::ostream &ostr, std::string_view text) {
+    ostr << '"';
+    for (char symbol: text) {
+        switch (symbol) {
+        case '"':  ostr << "\\\""; break;
+        case '\\': ostr << "\\\\"; break;
+        case '\n': ostr << "\\n";  break;
+        case '\t': ostr << "\\t";  break;
+        default:   ostr << symbol; break;
+        }
+    }
+    ostr << '"';
+}
+
+void dump_json_position(std::ostream &ostr, const text_position &position) {
+    ostr << "{ \"line\": " << position.line << ", \"column\": " << position.column + 1 << " }";
+}
+
+} // end anonymous namespace
+
+
+void optimization_remarks::print(file &source, std::FILE *stream) const {
+    for (const remark &current: remarks_) {
+        std::string message = std::string("remark: ") + current.message + " [" + get_kind_name(current.kind)
+                            + " " + current.pass + "]";
+
+        if (!current.range) {
+            std::print(stream, "{}: {}\n", source.filename, message);
+            continue;
+        }
+
+        source.message(message, { rng{ *current.range, current.pass } }, stream);
+    }
+}
+
+void optimization_remarks::dump_json(std::ostream &ostr) const {
+    ostr << "[";
+    for (size_t i = 0; i < remarks_.size(); ++ i) {
+        const remark &current = remarks_[i];
+
+        ostr << (i == 0 ? "\n" : ",\n") << "  { \"kind\": \"" << get_kind_name(current.kind)
+             << "\", \"pass\": \"" << current.pass << "\", \"message\": ";
+        dump_json_string(ostr, current.message);
+
+        if (current.range) {
+            ostr << ", \"begin\": ";
+            dump_json_position(ostr, current.range->begin);
+            ostr << ", \"end\": ";
+            dump_json_position(ostr, current.range->end);
+        }
+
+        ostr << " }";
+    }
+    ostr << (remarks_.empty() ? "]\n" : "\n]\n");
+}
+
+} // end namespace paracl
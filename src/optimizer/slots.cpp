@@ -0,0 +1,317 @@
+#include "paracl/optimizer/slots.h"
+
+#include <cassert>
+#include <limits>
+#include <optional>
+
+
+namespace paracl {
+
+namespace {
+
+using live_set = std::vector<bool>;
+
+void merge(live_set &live, const live_set &other) {
+    for (size_t slot = 0; slot < live.size(); ++ slot)
+        live[slot] = live[slot] || other[slot];
+}
+
+bool has_replacements(const node &tree);
+
+template <bool is_loop>
+bool has_replacements_in_conditional(const conditional_operation_node<is_loop> &conditional) {
+    if (has_replacements(conditional.get_condition()))
+        return true;
+
+    for (const auto &statement: conditional.get_scope())
+        if (has_replacements(*statement))
+            return true;
+
+    return false;
+}
+
+bool has_replacements(const node &tree) {
+    switch (tree.get_kind()) {
+    case node_kind::FUSED:
+    case node_kind::CLOSED_FORM:
+        return true;
+
+    case node_kind::NUMBER:
+    case node_kind::ID:
+    case node_kind::SCAN:
+        return false;
+
+    case node_kind::FUNCTION:
+        for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+            if (has_replacements(*arg))
+                return true;
+        return false;
+
+    case node_kind::NEGATE:
+        return has_replacements(static_cast<const negate_node&>(tree).get_child());
+
+    case node_kind::IF:
+        return has_replacements_in_conditional(static_cast<const if_node&>(tree));
+
+    case node_kind::WHILE:
+        return has_replacements_in_conditional(static_cast<const while_node&>(tree));
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return has_replacements(binary.get_left()) || has_replacements(binary.get_right());
+    }
+    }
+}
+
+class interference_graph {
+public:
+    explicit interference_graph(size_t variable_count):
+        neighbours_(variable_count), used_(variable_count, false) {}
+
+    // Walks scope backwards, live holds variables that are read after the scope
+    // and becomes variables that are read before it. Interferences are recorded
+    // only if record is set, otherwise scope is just analyzed.
+    void transfer_scope(const node_list &scope, live_set &live, bool record) {
+        for (auto it = scope.rbegin(); it != scope.rend(); ++ it)
+            transfer_statement(**it, live, record);
+    }
+
+    // Variables live at the start of the program are read before they are
+    // written, each of them needs its own initial value
+    void add_initial(const live_set &live) {
+        for (size_t slot = 0; slot < live.size(); ++ slot) {
+            if (!live[slot])
+                continue;
+
+            for (size_t other = slot + 1; other < live.size(); ++ other)
+                if (live[other])
+                    add_edge(slot, other);
+        }
+    }
+
+    // Greedy coloring in order of slots, every used variable gets the lowest
+    // slot that none of its neighbours got. Returns new slot for every old one.
+    std::vector<std::optional<size_t>> assign_slots(size_t &slot_count) const {
+        std::vector<std::optional<size_t>> storage(neighbours_.size());
+
+        // Which variable has last seen the slot taken, so it's not cleared between variables
+        constexpr size_t free = std::numeric_limits<size_t>::max();
+        std::vector<size_t> taken_by;
+
+        slot_count = 0;
+        for (size_t slot = 0; slot < neighbours_.size(); ++ slot) {
+            if (!used_[slot])
+                continue;
+
+            for (size_t neighbour: neighbours_[slot])
+                if (storage[neighbour])
+                    taken_by[*storage[neighbour]] = slot;
+
+            size_t shared = 0;
+            while (shared < slot_count && taken_by[shared] == slot)
+                ++ shared;
+
+            if (shared == slot_count) {
+                taken_by.push_back(free);
+                ++ slot_count;
+            }
+
+            storage[slot] = shared;
+        }
+
+        return storage;
+    }
+
+private:
+    std::vector<std::vector<size_t>> neighbours_;
+    std::vector<bool> used_;
+
+    void add_edge(size_t first, size_t second) {
+        neighbours_[first].push_back(second);
+        neighbours_[second].push_back(first);
+    }
+
+    void add_reads(const node &tree, live_set &live, bool record) {
+        switch (tree.get_kind()) {
+        case node_kind::NUMBER:
+        case node_kind::SCAN:
+            return;
+
+        case node_kind::ID: {
+            size_t slot = static_cast<const id_node&>(tree).get_slot();
+            live[slot] = true;
+            if (record)
+                used_[slot] = true;
+            return;
+        }
+
+        case node_kind::FUNCTION:
+            for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+                add_reads(*arg, live, record);
+            return;
+
+        case node_kind::NEGATE:
+            add_reads(static_cast<const negate_node&>(tree).get_child(), live, record);
+            return;
+
+        default: {
+            assert(is_arithmetic_or_comparison(tree.get_kind()) && "unexpected node in expression");
+
+            const auto &binary = static_cast<const binary_node&>(tree);
+            add_reads(binary.get_left(), live, record);
+            add_reads(binary.get_right(), live, record);
+            return;
+        }
+        }
+    }
+
+    void transfer_statement(const node &statement, live_set &live, bool record) {
+        switch (statement.get_kind()) {
+        case node_kind::IF: {
+            const auto &if_statement = static_cast<const if_node&>(statement);
+
+            live_set body = live;
+            transfer_scope(if_statement.get_scope(), body, record);
+
+            merge(live, body);
+            add_reads(if_statement.get_condition(), live, record);
+            return;
+        }
+
+        case node_kind::WHILE: {
+            const auto &while_statement = static_cast<const while_node&>(statement);
+
+            // Whatever body reads is live at the loop head, repeat until it stops growing:
+            live_set head = live;
+            add_reads(while_statement.get_condition(), head, record);
+            for (;;) {
+                live_set body = head;
+                transfer_scope(while_statement.get_scope(), body, false);
+
+                live_set merged = head;
+                merge(merged, body);
+                if (merged == head)
+                    break;
+
+                head = std::move(merged);
+            }
+
+            if (record) {
+                live_set body = head;
+                transfer_scope(while_statement.get_scope(), body, true);
+            }
+
+            live = std::move(head);
+            return;
+        }
+
+        default:
+            break;
+        }
+
+        if (!is_assignment(statement.get_kind())) {
+            add_reads(statement, live, record);
+            return;
+        }
+
+        const auto &assignment = static_cast<const binary_node&>(statement);
+        size_t slot = static_cast<const id_node&>(assignment.get_left()).get_slot();
+
+        if (record) {
+            // Engines may compute value right into the variable before all
+            // of its operands are read, so it interferes with them too:
+            live_set clobbered = live;
+            add_reads(assignment.get_right(), clobbered, false);
+
+            for (size_t other = 0; other < clobbered.size(); ++ other)
+                if (clobbered[other] && other != slot)
+                    add_edge(slot, other);
+
+            used_[slot] = true;
+        }
+
+        live[slot] = statement.get_kind() != node_kind::ASSIGN;
+        add_reads(assignment.get_right(), live, record);
+    }
+};
+
+using slot_map = std::vector<std::optional<size_t>>;
+
+void move_slots(node &tree, const slot_map &storage);
+
+template <bool is_loop>
+void move_slots_in_conditional(conditional_operation_node<is_loop> &conditional, const slot_map &storage) {
+    move_slots(*conditional.get_condition(), storage);
+    for (auto &statement: conditional.get_scope())
+        move_slots(*statement, storage);
+}
+
+void move_slots(node &tree, const slot_map &storage) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::SCAN:
+        return;
+
+    case node_kind::ID: {
+        auto &variable = static_cast<id_node&>(tree);
+        assert(storage[variable.get_slot()] && "referenced variable didn't get a slot");
+
+        variable.set_slot(*storage[variable.get_slot()]);
+        return;
+    }
+
+    case node_kind::FUNCTION:
+        for (auto &arg: static_cast<function_node&>(tree).get_args())
+            move_slots(*arg, storage);
+        return;
+
+    case node_kind::NEGATE:
+        move_slots(*static_cast<negate_node&>(tree).get_child(), storage);
+        return;
+
+    case node_kind::IF:
+        move_slots_in_conditional(static_cast<if_node&>(tree), storage);
+        return;
+
+    case node_kind::WHILE:
+        move_slots_in_conditional(static_cast<while_node&>(tree), storage);
+        return;
+
+    default: {
+        auto &binary = static_cast<binary_node&>(tree);
+        move_slots(*binary.get_left(), storage);
+        move_slots(*binary.get_right(), storage);
+        return;
+    }
+    }
+}
+
+} // end anonymous namespace
+
+
+size_t share_variable_slots(ast &tree) {
+    for (const auto &statement: tree.get_scope())
+        if (has_replacements(*statement))
+            return 0;
+
+    context &ctx = tree.get_context();
+    size_t variable_count = ctx.get_variable_count();
+
+    // Nothing is read after the program ends:
+    live_set live(variable_count, false);
+
+    interference_graph graph(variable_count);
+    graph.transfer_scope(tree.get_scope(), live, true);
+    graph.add_initial(live);
+
+    size_t slot_count = 0;
+    slot_map storage = graph.assign_slots(slot_count);
+
+    ctx.share(storage, slot_count);
+    for (auto &statement: tree.get_scope())
+        move_slots(*statement, storage);
+
+    return variable_count - slot_count;
+}
+
+} // end namespace paracl
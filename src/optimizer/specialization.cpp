@@ -0,0 +1,167 @@
+#include "paracl/optimizer/specialization.h"
+#include "paracl/optimizer/folding.h"
+#include "paracl/optimizer/propagation.h"
+#include "paracl/ast/fused_nodes.h"
+
+#include <algorithm>
+
+
+namespace paracl {
+
+namespace {
+
+bool reads_input(const node &tree) {
+    const node &current = get_unfused(tree);
+
+    switch (current.get_kind()) {
+    case node_kind::SCAN:
+        return true;
+
+    case node_kind::NUMBER:
+    case node_kind::ID:
+        return false;
+
+    case node_kind::FUNCTION:
+        for (const auto &arg: static_cast<const function_node&>(current).get_args()) {
+            if (reads_input(*arg))
+                return true;
+        }
+        return false;
+
+    case node_kind::NEGATE:
+        return reads_input(static_cast<const negate_node&>(current).get_child());
+
+    case node_kind::IF:
+    case node_kind::WHILE: {
+        const auto &conditional = static_cast<const while_node&>(current);
+        if (reads_input(conditional.get_condition()))
+            return true;
+
+        for (const auto &statement: conditional.get_scope()) {
+            if (reads_input(*statement))
+                return true;
+        }
+        return false;
+    }
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(current);
+        return reads_input(binary.get_left()) || reads_input(binary.get_right());
+    }
+    }
+}
+
+class input_specializer {
+public:
+    explicit input_specializer(std::span<const int64_t> inputs):
+        inputs_(inputs) {}
+
+    size_t get_replaced_count() const {
+        return next_;
+    }
+
+    // Replaces reads in order they are run, stops at the first statement
+    // that runs an unknown number of them. Returns number of replaced reads.
+    size_t replace_scope(node_list &scope) {
+        size_t start = next_;
+
+        for (auto &statement: scope) {
+            if (!replace_statement(*statement))
+                break;
+        }
+
+        return next_ - start;
+    }
+
+private:
+    std::span<const int64_t> inputs_;
+    size_t next_ = 0;
+
+    // Whether all reads of the statement are known now
+    bool replace_statement(node &statement) {
+        switch (statement.get_kind()) {
+        case node_kind::IF: {
+            auto &if_statement = static_cast<if_node&>(statement);
+            replace_expression(if_statement.get_condition());
+
+            // Body reads only if condition holds:
+            return !is_exhausted() && !std::ranges::any_of(if_statement.get_scope(), [](const auto &nested) {
+                return reads_input(*nested);
+            });
+        }
+
+        case node_kind::WHILE:
+        case node_kind::FUSED:
+        case node_kind::CLOSED_FORM:
+            // Loop reads as many values as it runs iterations:
+            return !reads_input(statement);
+
+        default:
+            break;
+        }
+
+        if (is_assignment(statement.get_kind()))
+            replace_expression(static_cast<binary_node&>(statement).get_right());
+        else
+            replace_expression_children(statement);
+
+        return !is_exhausted();
+    }
+
+    bool is_exhausted() const {
+        return next_ == inputs_.size();
+    }
+
+    // Operands are evaluated left to right, so are the reads in them
+    void replace_expression(std::unique_ptr<node> &expression) {
+        if (expression->get_kind() == node_kind::SCAN) {
+            if (!is_exhausted())
+                expression = std::make_unique<number_node>(inputs_[next_ ++]);
+            return;
+        }
+
+        replace_expression_children(*expression);
+    }
+
+    void replace_expression_children(node &expression) {
+        switch (expression.get_kind()) {
+        case node_kind::FUNCTION:
+            for (auto &arg: static_cast<function_node&>(expression).get_args())
+                replace_expression(arg);
+            return;
+
+        case node_kind::NEGATE:
+            replace_expression(static_cast<negate_node&>(expression).get_child());
+            return;
+
+        default:
+            if (!is_arithmetic_or_comparison(expression.get_kind()))
+                return;
+
+            auto &binary = static_cast<binary_node&>(expression);
+            replace_expression(binary.get_left());
+            replace_expression(binary.get_right());
+            return;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t specialize_input(ast &tree, std::span<const int64_t> inputs) {
+    input_specializer pass(inputs);
+
+    // Known values can decide conditions, which makes reads after them certain:
+    for (;;) {
+        size_t replaced = pass.replace_scope(tree.get_scope());
+        size_t folded = propagate_constants(tree) + fold_constants(tree);
+
+        if (replaced == 0 && folded == 0)
+            break;
+    }
+
+    return pass.get_replaced_count();
+}
+
+} // end namespace paracl
@@ -0,0 +1,391 @@
+#include "paracl/optimizer/unrolling.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+
+
+namespace paracl {
+
+namespace {
+
+// Unrolled body of at most this many nodes is still cheap to keep around
+constexpr size_t unrolled_size_budget = 64;
+
+std::unique_ptr<node> make_binary(node_kind kind, std::unique_ptr<node> left, std::unique_ptr<node> right) {
+    switch (kind) {
+    case node_kind::ASSIGN:          return std::make_unique<assign_node>         (std::move(left), std::move(right));
+    case node_kind::PLUS_ASSIGN:     return std::make_unique<plus_assign_node>    (std::move(left), std::move(right));
+    case node_kind::MINUS_ASSIGN:    return std::make_unique<minus_assign_node>   (std::move(left), std::move(right));
+    case node_kind::MULTIPLY_ASSIGN: return std::make_unique<multiply_assign_node>(std::move(left), std::move(right));
+    case node_kind::DIVIDE_ASSIGN:   return std::make_unique<divide_assign_node>  (std::move(left), std::move(right));
+    case node_kind::PLUS:            return std::make_unique<plus_node>           (std::move(left), std::move(right));
+    case node_kind::MINUS:           return std::make_unique<minus_node>          (std::move(left), std::move(right));
+    case node_kind::MULTIPLY:        return std::make_unique<multiply_node>       (std::move(left), std::move(right));
+    case node_kind::DIVIDE:          return std::make_unique<divide_node>         (std::move(left), std::move(right));
+    case node_kind::EQUAL:           return std::make_unique<equal_node>          (std::move(left), std::move(right));
+    case node_kind::LESS:            return std::make_unique<less_node>           (std::move(left), std::move(right));
+    case node_kind::BIGGER:          return std::make_unique<bigger_node>         (std::move(left), std::move(right));
+    case node_kind::LESS_OR_EQUAL:   return std::make_unique<less_or_equal_node>  (std::move(left), std::move(right));
+    case node_kind::BIGGER_OR_EQUAL: return std::make_unique<bigger_or_equal_node>(std::move(left), std::move(right));
+    default:                         return nullptr;
+    }
+}
+
+node_list clone_scope(const node_list &scope);
+
+std::unique_ptr<node> clone(const node &tree);
+
+std::unique_ptr<node> copy_node(const node &tree) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+        return std::make_unique<number_node>(static_cast<const number_node&>(tree).get_number());
+
+    case node_kind::ID: {
+        const auto &id = static_cast<const id_node&>(tree);
+        return std::make_unique<id_node>(id.get_name(), id.get_slot());
+    }
+
+    case node_kind::FUNCTION: {
+        const auto &function = static_cast<const function_node&>(tree);
+        return std::make_unique<function_node>(function.get_name(), clone_scope(function.get_args()));
+    }
+
+    case node_kind::NEGATE:
+        return std::make_unique<negate_node>(clone(static_cast<const negate_node&>(tree).get_child()));
+
+    case node_kind::IF: {
+        const auto &if_statement = static_cast<const if_node&>(tree);
+        return std::make_unique<if_node>(clone(if_statement.get_condition()), clone_scope(if_statement.get_scope()));
+    }
+
+    case node_kind::WHILE: {
+        const auto &loop = static_cast<const while_node&>(tree);
+        return std::make_unique<while_node>(clone(loop.get_condition()), clone_scope(loop.get_scope()));
+    }
+
+    case node_kind::SCAN:
+        return std::make_unique<scan_node>();
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(tree);
+        std::unique_ptr<node> copy = make_binary(tree.get_kind(), clone(binary.get_left()), clone(binary.get_right()));
+
+        if (tree.get_kind() == node_kind::DIVIDE)
+            static_cast<divide_node&>(*copy).set_divisor_checked(is_divisor_checked(tree));
+
+        if (tree.get_kind() == node_kind::DIVIDE_ASSIGN)
+            static_cast<divide_assign_node&>(*copy).set_divisor_checked(is_divisor_checked(tree));
+
+        return copy;
+    }
+    }
+}
+
+// Deep copy of a tree without replacement nodes in it, copies come from the same source
+std::unique_ptr<node> clone(const node &tree) {
+    std::unique_ptr<node> copy = copy_node(tree);
+    copy->set_range(tree.get_range());
+    return copy;
+}
+
+node_list clone_scope(const node_list &scope) {
+    node_list copy;
+    for (const auto &statement: scope)
+        copy.push_back(clone(*statement));
+
+    return copy;
+}
+
+// Number of nodes in tree, or nothing if it has loops, which make
+// unrolling pointless, or replacement nodes, which can't be copied
+std::optional<size_t> get_size(const node &tree) {
+    auto add = [](std::optional<size_t> total, std::optional<size_t> size) -> std::optional<size_t> {
+        if (!total || !size)
+            return std::nullopt;
+
+        return *total + *size;
+    };
+
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+    case node_kind::ID:
+    case node_kind::SCAN:
+        return 1;
+
+    case node_kind::FUNCTION: {
+        std::optional<size_t> size = 1;
+        for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+            size = add(size, get_size(*arg));
+        return size;
+    }
+
+    case node_kind::NEGATE:
+        return add(1, get_size(static_cast<const negate_node&>(tree).get_child()));
+
+    case node_kind::IF: {
+        const auto &if_statement = static_cast<const if_node&>(tree);
+
+        std::optional<size_t> size = add(1, get_size(if_statement.get_condition()));
+        for (const auto &statement: if_statement.get_scope())
+            size = add(size, get_size(*statement));
+        return size;
+    }
+
+    case node_kind::WHILE:
+    case node_kind::FUSED:
+    case node_kind::CLOSED_FORM:
+        return std::nullopt;
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return add(add(1, get_size(binary.get_left())), get_size(binary.get_right()));
+    }
+    }
+}
+
+size_t get_target(const node &assignment) {
+    return static_cast<const id_node&>(static_cast<const binary_node&>(assignment).get_left()).get_slot();
+}
+
+void collect_writes(const node &tree, std::vector<size_t> &written) {
+    if (tree.get_kind() == node_kind::IF) {
+        for (const auto &statement: static_cast<const if_node&>(tree).get_scope())
+            collect_writes(*statement, written);
+        return;
+    }
+
+    if (is_assignment(tree.get_kind()))
+        written.push_back(get_target(tree));
+}
+
+// Whether value doesn't change while loop runs and can be computed again
+// any number of times: no input, no failing division, no written variables
+bool is_invariant(const node &tree, const std::vector<size_t> &written) {
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:
+        return true;
+
+    case node_kind::ID:
+        return std::ranges::find(written, static_cast<const id_node&>(tree).get_slot()) == written.end();
+
+    case node_kind::NEGATE:
+        return is_invariant(static_cast<const negate_node&>(tree).get_child(), written);
+
+    default:
+        break;
+    }
+
+    if (!is_arithmetic_or_comparison(tree.get_kind()))
+        return false;
+
+    const auto &binary = static_cast<const binary_node&>(tree);
+    if (tree.get_kind() == node_kind::DIVIDE) {
+        const node &divisor = binary.get_right();
+        if (divisor.get_kind() != node_kind::NUMBER)
+            return false;
+
+        int64_t value = static_cast<const number_node&>(divisor).get_number();
+        if (value == 0 || value == -1)
+            return false;
+    }
+
+    return is_invariant(binary.get_left(), written) && is_invariant(binary.get_right(), written);
+}
+
+// Constant the statement steps counter by, if it does
+std::optional<int64_t> get_step(const node &statement, size_t counter) {
+    node_kind kind = statement.get_kind();
+    if (kind != node_kind::PLUS_ASSIGN && kind != node_kind::MINUS_ASSIGN)
+        return std::nullopt;
+
+    if (get_target(statement) != counter)
+        return std::nullopt;
+
+    const node &right = static_cast<const binary_node&>(statement).get_right();
+    if (right.get_kind() != node_kind::NUMBER)
+        return std::nullopt;
+
+    int64_t step = static_cast<const number_node&>(right).get_number();
+    if (step == 0 || step == std::numeric_limits<int64_t>::min())
+        return std::nullopt;
+
+    return kind == node_kind::PLUS_ASSIGN ? step : -step;
+}
+
+class loop_unroller {
+public:
+    loop_unroller(size_t max_factor, optimization_remarks *remarks):
+        max_factor_(max_factor), remarks_(remarks) {}
+
+    size_t get_unrolled_count() const {
+        return unrolled_;
+    }
+
+    void unroll_scope(node_list &scope) {
+        node_list rewritten;
+
+        for (auto &statement: scope) {
+            switch (statement->get_kind()) {
+            case node_kind::IF:
+                unroll_scope(static_cast<if_node&>(*statement).get_scope());
+                break;
+
+            case node_kind::WHILE:
+                unroll_scope(static_cast<while_node&>(*statement).get_scope());
+
+                if (std::unique_ptr<node> unrolled = try_unroll(static_cast<while_node&>(*statement))) {
+                    rewritten.push_back(std::move(unrolled));
+                    ++ unrolled_;
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            rewritten.push_back(std::move(statement));
+        }
+
+        scope = std::move(rewritten);
+    }
+
+private:
+    size_t max_factor_;
+    optimization_remarks *remarks_;
+
+    size_t unrolled_ = 0;
+
+    std::unique_ptr<node> missed(const while_node &loop, const char *reason) {
+        if (remarks_)
+            remarks_->missed("unrolling", loop, reason);
+
+        return nullptr;
+    }
+
+    // Loop that does the first iterations of the given one, factor at a time,
+    // the given loop is left as is and finishes the rest
+    std::unique_ptr<node> try_unroll(const while_node &loop) {
+        const node &condition = loop.get_condition();
+
+        node_kind comparison = condition.get_kind();
+        bool is_increasing = comparison == node_kind::LESS || comparison == node_kind::LESS_OR_EQUAL;
+        if (!is_increasing && comparison != node_kind::BIGGER && comparison != node_kind::BIGGER_OR_EQUAL)
+            return missed(loop, "loop condition doesn't compare a counter with a bound");
+
+        const auto &compared = static_cast<const binary_node&>(condition);
+        if (compared.get_left().get_kind() != node_kind::ID)
+            return missed(loop, "loop condition doesn't compare a counter with a bound");
+
+        size_t counter = static_cast<const id_node&>(compared.get_left()).get_slot();
+
+        std::optional<int64_t> step;
+        std::vector<size_t> written;
+
+        for (const auto &statement: loop.get_scope()) {
+            if (!get_size(*statement))
+                return missed(loop, "loop has a nested loop in its body");
+
+            if (std::optional<int64_t> statement_step = get_step(*statement, counter)) {
+                if (step) // counter has to be stepped exactly once
+                    return missed(loop, "counter is stepped more than once per iteration");
+
+                step = statement_step;
+                continue;
+            }
+
+            collect_writes(*statement, written);
+        }
+
+        if (!step || std::ranges::find(written, counter) != written.end())
+            return missed(loop, "counter isn't stepped by a constant exactly once per iteration");
+
+        // Comparison has to move towards its end, or else loop stops only on overflow:
+        if ((*step > 0) != is_increasing)
+            return missed(loop, "counter moves away from the bound");
+
+        written.push_back(counter);
+        if (!is_invariant(compared.get_right(), written))
+            return missed(loop, "loop bound changes inside the loop");
+
+        std::optional<size_t> factor = get_factor(loop);
+        if (!factor)
+            return missed(loop, "loop body is too large to unroll");
+
+        // Every one of unrolled iterations runs if the last of them would, that is,
+        // counter is this far from the bound:
+        uint64_t distance = static_cast<uint64_t>(*step > 0 ? *step : -*step);
+        if (distance > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) / (*factor - 1))
+            return missed(loop, "counter step is too large to unroll");
+
+        int64_t offset = static_cast<int64_t>(distance * (*factor - 1));
+
+        // Bound is moved by offset, when it can't go past the edge of int64_t:
+        int64_t edge = is_increasing ? std::numeric_limits<int64_t>::min() + offset
+                                     : std::numeric_limits<int64_t>::max() - offset;
+
+        const node &bound = compared.get_right();
+
+        std::unique_ptr<node> moved;
+        if (bound.get_kind() == node_kind::NUMBER) {
+            int64_t value = static_cast<const number_node&>(bound).get_number();
+            if (is_increasing ? value < edge : value > edge)
+                return missed(loop, "loop bound is too close to the edge of int64");
+
+            moved = std::make_unique<number_node>(is_increasing ? value - offset : value + offset);
+        } else {
+            moved = make_binary(is_increasing ? node_kind::MINUS : node_kind::PLUS,
+                                clone(bound), std::make_unique<number_node>(offset));
+        }
+
+        node_list body;
+        for (size_t i = 0; i < *factor; ++ i) {
+            for (auto &statement: clone_scope(loop.get_scope()))
+                body.push_back(std::move(statement));
+        }
+
+        std::unique_ptr<node> unrolled = std::make_unique<while_node>(
+            make_binary(comparison, clone(compared.get_left()), std::move(moved)), std::move(body));
+
+        if (remarks_)
+            remarks_->passed("unrolling", loop, "loop is unrolled by a factor of " + std::to_string(*factor));
+
+        if (bound.get_kind() == node_kind::NUMBER)
+            return unrolled;
+
+        node_list guarded;
+        guarded.push_back(std::move(unrolled));
+
+        auto guard = make_binary(is_increasing ? node_kind::BIGGER_OR_EQUAL : node_kind::LESS_OR_EQUAL,
+                                 clone(bound), std::make_unique<number_node>(edge));
+
+        return std::make_unique<if_node>(std::move(guard), std::move(guarded));
+    }
+
+    std::optional<size_t> get_factor(const while_node &loop) const {
+        size_t size = 0;
+        for (const auto &statement: loop.get_scope())
+            size += *get_size(*statement);
+
+        size_t factor = std::min(max_factor_, unrolled_size_budget / size);
+        if (factor < 2)
+            return std::nullopt;
+
+        return factor;
+    }
+};
+
+} // end anonymous namespace
+
+
+size_t unroll_loops(ast &tree, size_t max_factor, optimization_remarks *remarks) {
+    loop_unroller pass(max_factor, remarks);
+    pass.unroll_scope(tree.get_scope());
+
+    return pass.get_unrolled_count();
+}
+
+} // end namespace paracl
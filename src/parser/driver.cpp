@@ -1,21 +1,65 @@
 #include "paracl/lexer/lexer.h"
 #include "paracl/text/file.h"
 #include "paracl/ast/ast.h"
+#include "paracl/ast/flat.h"
+#include "paracl/ir/ir.h"
 
 #include <iostream>
+#include <string_view>
 
 
 int main(int argc, const char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " [FILE]\n";
+    bool dump_ir = false;
+    bool dump_ir_gv = false;
+    bool dump_flat = false;
+    bool dump_flat_gv = false;
+
+    const char *filename = nullptr;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; ++ i) {
+        std::string_view arg = argv[i];
+
+        if (arg == "--dump-ir")
+            dump_ir = true;
+        else if (arg == "--dump-ir-gv")
+            dump_ir_gv = true;
+        else if (arg == "--dump-flat")
+            dump_flat = true;
+        else if (arg == "--dump-flat-gv")
+            dump_flat_gv = true;
+        else if (!filename && !arg.starts_with("-"))
+            filename = argv[i];
+        else
+            valid = false;
+    }
+
+    if (!filename || !valid || dump_ir + dump_ir_gv + dump_flat + dump_flat_gv > 1) {
+        std::cerr << "Usage: " << argv[0] << " [--dump-ir|--dump-ir-gv|--dump-flat|--dump-flat-gv] [FILE]\n";
         return EXIT_FAILURE;
     }
 
-    std::string filename = argv[1];
     std::string text = paracl::read_file(filename);
 
     std::vector<paracl::token> tokens = paracl::tokenize(text);
 
     paracl::ast ast(tokens);
-    ast.dump();
+    if (dump_flat || dump_flat_gv) {
+        paracl::flat_ast flat(ast.get_scope(), ast.get_context());
+        if (dump_flat)
+            flat.dump();
+        else
+            flat.dump_gv();
+        return EXIT_SUCCESS;
+    }
+
+    if (!dump_ir && !dump_ir_gv) {
+        ast.dump();
+        return EXIT_SUCCESS;
+    }
+
+    paracl::ir::function function = paracl::ir::build_ir(ast.get_scope(), ast.get_context());
+    if (dump_ir)
+        function.dump();
+    else
+        function.dump_gv();
 }
@@ -0,0 +1,465 @@
+#include "paracl/ast/flat.h"
+#include "paracl/ast/fused_nodes.h"
+#include "paracl/ast/input.h"
+#include "paracl/ast/output.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+
+
+namespace paracl {
+
+namespace {
+
+flat_ast::kind get_flat_kind(const node &tree) {
+    using kind = flat_ast::kind;
+
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER:          return kind::NUMBER;
+    case node_kind::ID:              return kind::ID;
+    case node_kind::FUNCTION:        return kind::FUNCTION;
+    case node_kind::ASSIGN:          return kind::ASSIGN;
+    case node_kind::PLUS_ASSIGN:     return kind::PLUS_ASSIGN;
+    case node_kind::MINUS_ASSIGN:    return kind::MINUS_ASSIGN;
+    case node_kind::MULTIPLY_ASSIGN: return kind::MULTIPLY_ASSIGN;
+    case node_kind::DIVIDE_ASSIGN:
+        return is_divisor_checked(tree) ? kind::DIVIDE_ASSIGN : kind::DIVIDE_ASSIGN_UNCHECKED;
+    case node_kind::NEGATE:          return kind::NEGATE;
+    case node_kind::PLUS:            return kind::PLUS;
+    case node_kind::MINUS:           return kind::MINUS;
+    case node_kind::MULTIPLY:        return kind::MULTIPLY;
+    case node_kind::DIVIDE:
+        return is_divisor_checked(tree) ? kind::DIVIDE : kind::DIVIDE_UNCHECKED;
+    case node_kind::EQUAL:           return kind::EQUAL;
+    case node_kind::LESS:            return kind::LESS;
+    case node_kind::BIGGER:          return kind::BIGGER;
+    case node_kind::LESS_OR_EQUAL:   return kind::LESS_OR_EQUAL;
+    case node_kind::BIGGER_OR_EQUAL: return kind::BIGGER_OR_EQUAL;
+    case node_kind::IF:              return kind::IF;
+    case node_kind::WHILE:           return kind::WHILE;
+    case node_kind::SCAN:            return kind::SCAN;
+    case node_kind::FUSED:
+    case node_kind::CLOSED_FORM:
+        break;
+    }
+
+    assert(false && "replacement nodes are flattened as their originals");
+    return kind::SCAN;
+}
+
+bool is_flat_assignment(flat_ast::kind node_kind) {
+    return node_kind >= flat_ast::kind::ASSIGN && node_kind <= flat_ast::kind::DIVIDE_ASSIGN_UNCHECKED;
+}
+
+// Names as nodes.h prints them
+const char *get_flat_name(flat_ast::kind node_kind) {
+    using kind = flat_ast::kind;
+
+    switch (node_kind) {
+    case kind::ASSIGN:                  return "=";
+    case kind::PLUS_ASSIGN:             return "+=";
+    case kind::MINUS_ASSIGN:            return "-=";
+    case kind::MULTIPLY_ASSIGN:         return "*=";
+    case kind::DIVIDE_ASSIGN:
+    case kind::DIVIDE_ASSIGN_UNCHECKED: return "/=";
+    case kind::NEGATE:
+    case kind::MINUS:                   return "-";
+    case kind::PLUS:                    return "+";
+    case kind::MULTIPLY:                return "*";
+    case kind::DIVIDE:
+    case kind::DIVIDE_UNCHECKED:        return "/";
+    case kind::EQUAL:                   return "==";
+    case kind::LESS:                    return "&lt;";
+    case kind::BIGGER:                  return "&gt;";
+    case kind::LESS_OR_EQUAL:           return "&le;";
+    case kind::BIGGER_OR_EQUAL:         return "&ge;";
+    case kind::IF:                      return "if";
+    case kind::WHILE:                   return "while";
+    case kind::SCAN:                    return "scan";
+    default:
+        assert(false && "node has no fixed name");
+        return "";
+    }
+}
+
+// Operation both of binary operators and compound assignments
+int64_t apply(flat_ast::kind operation, int64_t lhs, int64_t rhs) {
+    using kind = flat_ast::kind;
+
+    switch (operation) {
+    case kind::ASSIGN:                  return rhs;
+    case kind::PLUS_ASSIGN:
+    case kind::PLUS:                    return std::plus<int64_t>{}(lhs, rhs);
+    case kind::MINUS_ASSIGN:
+    case kind::MINUS:                   return std::minus<int64_t>{}(lhs, rhs);
+    case kind::MULTIPLY_ASSIGN:
+    case kind::MULTIPLY:                return std::multiplies<int64_t>{}(lhs, rhs);
+    case kind::DIVIDE_ASSIGN:
+    case kind::DIVIDE:                  return checked_divides{}(lhs, rhs);
+    case kind::DIVIDE_ASSIGN_UNCHECKED:
+    case kind::DIVIDE_UNCHECKED:        return std::divides<int64_t>{}(lhs, rhs);
+    case kind::EQUAL:                   return lhs == rhs;
+    case kind::LESS:                    return lhs <  rhs;
+    case kind::BIGGER:                  return lhs >  rhs;
+    case kind::LESS_OR_EQUAL:           return lhs <= rhs;
+    case kind::BIGGER_OR_EQUAL:         return lhs >= rhs;
+    default:
+        assert(false && "node is not a binary operation");
+        return 0;
+    }
+}
+
+} // end anonymous namespace
+
+
+flat_ast::flat_ast(const node_list &scope, const context &ctx) {
+    for (size_t slot = 0; slot < ctx.get_variable_count(); ++ slot)
+        variables_.push_back(ctx.get_name(slot));
+
+    program_ = flatten_list(scope);
+
+    kinds_.shrink_to_fit();
+    first_.shrink_to_fit();
+    second_.shrink_to_fit();
+    lists_.shrink_to_fit();
+}
+
+flat_ast::index flat_ast::add_node(kind node_kind, index first, index second) {
+    assert(kinds_.size() < std::numeric_limits<index>::max() && "tree is too big for 32-bit indices");
+
+    kinds_.push_back(node_kind);
+    first_.push_back(first);
+    second_.push_back(second);
+
+    return static_cast<index>(kinds_.size() - 1);
+}
+
+// Nodes are added before their children, so walking the tree mostly goes forward
+flat_ast::index flat_ast::flatten(const node &original) {
+    const node &tree = get_unfused(original);
+
+    kind flat_kind = get_flat_kind(tree);
+    index added = add_node(flat_kind);
+
+    switch (tree.get_kind()) {
+    case node_kind::NUMBER: {
+        auto value = static_cast<uint64_t>(static_cast<const number_node&>(tree).get_number());
+        first_[added] = static_cast<index>(value);
+        second_[added] = static_cast<index>(value >> 32);
+        break;
+    }
+
+    case node_kind::ID:
+        first_[added] = static_cast<index>(static_cast<const id_node&>(tree).get_slot());
+        break;
+
+    case node_kind::FUNCTION: {
+        const auto &function = static_cast<const function_node&>(tree);
+
+        auto found = std::find(functions_.begin(), functions_.end(), function.get_name());
+        if (found == functions_.end())
+            found = functions_.insert(functions_.end(), function.get_name());
+
+        index name = static_cast<index>(found - functions_.begin());
+        index args = flatten_list(function.get_args());
+
+        first_[added] = name;
+        second_[added] = args;
+        break;
+    }
+
+    case node_kind::NEGATE: {
+        index child = flatten(static_cast<const negate_node&>(tree).get_child());
+        first_[added] = child;
+        break;
+    }
+
+    case node_kind::IF:
+    case node_kind::WHILE: {
+        auto flatten_conditional = [&](const auto &conditional) {
+            index condition = flatten(conditional.get_condition());
+            index scope = flatten_list(conditional.get_scope());
+
+            first_[added] = condition;
+            second_[added] = scope;
+        };
+
+        if (tree.get_kind() == node_kind::IF)
+            flatten_conditional(static_cast<const if_node&>(tree));
+        else
+            flatten_conditional(static_cast<const while_node&>(tree));
+        break;
+    }
+
+    case node_kind::SCAN:
+        break;
+
+    default: {
+        const auto &binary = static_cast<const binary_node&>(tree);
+
+        if (is_flat_assignment(flat_kind)) {
+            assert(binary.get_left().get_kind() == node_kind::ID && "only variables can be assigned");
+            first_[added] = static_cast<index>(static_cast<const id_node&>(binary.get_left()).get_slot());
+        } else {
+            index left = flatten(binary.get_left());
+            first_[added] = left;
+        }
+
+        index right = flatten(binary.get_right());
+        second_[added] = right;
+        break;
+    }
+    }
+
+    return added;
+}
+
+// Elements are only known after they are flattened, and they could add lists
+// of their own, so list is reserved first and filled in afterwards
+flat_ast::index flat_ast::flatten_list(const node_list &list) {
+    index offset = static_cast<index>(lists_.size());
+    lists_.resize(lists_.size() + list.size() + 1);
+    lists_[offset] = static_cast<index>(list.size());
+
+    for (size_t i = 0; i < list.size(); ++ i) {
+        index element = flatten(*list[i]);
+        lists_[offset + 1 + i] = element;
+    }
+
+    return offset;
+}
+
+
+void flat_ast::run(context &ctx) const {
+    execute_list(program_, ctx.get_variables());
+}
+
+void flat_ast::execute_list(index list, int64_t *variables) const {
+    const index *statements = get_list(list);
+    for (index i = 0, size = get_list_size(list); i < size; ++ i)
+        evaluate(statements[i], variables);
+}
+
+int64_t flat_ast::evaluate(index node, int64_t *variables) const {
+    kind node_kind = kinds_[node];
+
+    switch (node_kind) {
+    case kind::NUMBER:
+        return get_number(node);
+
+    case kind::ID:
+        return variables[first_[node]];
+
+    case kind::FUNCTION: {
+        if (functions_[first_[node]] != "print")
+            return 0;
+
+        index args = second_[node];
+        const index *values = get_list(args);
+        output_sink &output = get_output();
+
+        for (index i = 0, size = get_list_size(args); i < size; ++ i) {
+            if (i != 0)
+                output.put(' ');
+
+            output.write_number(evaluate(values[i], variables));
+        }
+        output.end_line();
+        return 1;
+    }
+
+    case kind::NEGATE:
+        return std::negate<int64_t>{}(evaluate(first_[node], variables));
+
+    case kind::IF:
+        if (evaluate(first_[node], variables) != 0)
+            execute_list(second_[node], variables);
+        return 1;
+
+    case kind::WHILE:
+        while (evaluate(first_[node], variables) != 0)
+            execute_list(second_[node], variables);
+        return 1;
+
+    case kind::SCAN:
+        return get_input().read_number();
+
+    default:
+        break;
+    }
+
+    // Operands are evaluated left to right, for assignments left is the variable:
+    if (is_flat_assignment(node_kind)) {
+        int64_t &variable = variables[first_[node]];
+        int64_t lhs = variable;
+        int64_t rhs = evaluate(second_[node], variables);
+
+        variable = apply(node_kind, lhs, rhs);
+        return 1;
+    }
+
+    int64_t lhs = evaluate(first_[node], variables);
+    int64_t rhs = evaluate(second_[node], variables);
+    return apply(node_kind, lhs, rhs);
+}
+
+
+void flat_ast::dump(std::ostream &ostr) const {
+    ostr << "main( ";
+
+    const index *statements = get_list(program_);
+    for (index i = 0, size = get_list_size(program_); i < size; ++ i) {
+        dump(statements[i], ostr);
+        ostr << " ";
+    }
+
+    ostr << ")";
+}
+
+void flat_ast::dump(index node, std::ostream &ostr) const {
+    kind node_kind = kinds_[node];
+
+    switch (node_kind) {
+    case kind::NUMBER:
+        ostr << get_number(node);
+        return;
+
+    case kind::ID:
+        ostr << variables_[first_[node]];
+        return;
+
+    case kind::FUNCTION: {
+        ostr << functions_[first_[node]] << "( ";
+
+        index args = second_[node];
+        for (index i = 0, size = get_list_size(args); i < size; ++ i) {
+            dump(get_list(args)[i], ostr);
+            ostr << " ";
+        }
+
+        ostr << ")";
+        return;
+    }
+
+    case kind::NEGATE:
+        ostr << get_flat_name(node_kind) << " (";
+        dump(first_[node], ostr);
+        ostr << ")";
+        return;
+
+    case kind::IF:
+    case kind::WHILE: {
+        ostr << get_flat_name(node_kind) << " ((";
+        dump(first_[node], ostr);
+        ostr << ")";
+
+        index scope = second_[node];
+        for (index i = 0, size = get_list_size(scope); i < size; ++ i) {
+            ostr << " (";
+            dump(get_list(scope)[i], ostr);
+            ostr << ")";
+        }
+
+        ostr << ")";
+        return;
+    }
+
+    case kind::SCAN:
+        ostr << get_flat_name(node_kind);
+        return;
+
+    default:
+        break;
+    }
+
+    ostr << get_flat_name(node_kind) << " (";
+    if (is_flat_assignment(node_kind))
+        ostr << variables_[first_[node]];
+    else
+        dump(first_[node], ostr);
+
+    ostr << " ";
+    dump(second_[node], ostr);
+    ostr << ")";
+}
+
+void flat_ast::dump_gv(std::ostream &ostr) const {
+    graphviz graph{};
+
+    auto program = graph.insert_node(graphviz_formatter::conditional, "program");
+
+    const index *statements = get_list(program_);
+    for (index i = 0, size = get_list_size(program_); i < size; ++ i)
+        dump_gv(statements[i], graph, program);
+
+    graph.print(ostr);
+}
+
+void flat_ast::dump_gv(index node, graphviz &graph, node_proxy &parent) const {
+    kind node_kind = kinds_[node];
+
+    auto add = [&](graphviz_formatting format, std::string label) {
+        auto inserted = graph.insert_node(format, label);
+        parent.connect(graphviz_formatter::default_edge, inserted);
+        return inserted;
+    };
+
+    switch (node_kind) {
+    case kind::NUMBER:
+        add(graphviz_formatter::number, std::to_string(get_number(node)));
+        return;
+
+    case kind::ID:
+        add(graphviz_formatter::id, variables_[first_[node]]);
+        return;
+
+    case kind::FUNCTION: {
+        auto function = add(graphviz_formatter::function, functions_[first_[node]]);
+
+        index args = second_[node];
+        for (index i = 0, size = get_list_size(args); i < size; ++ i)
+            dump_gv(get_list(args)[i], graph, function);
+        return;
+    }
+
+    case kind::NEGATE: {
+        auto negation = add(graphviz_formatter::negation, get_flat_name(node_kind));
+        dump_gv(first_[node], graph, negation);
+        return;
+    }
+
+    case kind::IF:
+    case kind::WHILE: {
+        auto conditional = add(graphviz_formatter::conditional, get_flat_name(node_kind));
+        dump_gv(first_[node], graph, conditional);
+
+        index scope = second_[node];
+        for (index i = 0, size = get_list_size(scope); i < size; ++ i)
+            dump_gv(get_list(scope)[i], graph, conditional);
+        return;
+    }
+
+    case kind::SCAN:
+        add(graphviz_formatter::scan, get_flat_name(node_kind));
+        return;
+
+    default:
+        break;
+    }
+
+    if (is_flat_assignment(node_kind)) {
+        auto assignment = add(graphviz_formatter::assignment, get_flat_name(node_kind));
+        assignment.connect(graphviz_formatter::default_edge,
+                           graph.insert_node(graphviz_formatter::id, variables_[first_[node]]));
+        dump_gv(second_[node], graph, assignment);
+        return;
+    }
+
+    auto operation = add(graphviz_formatter::arithmetic_and_comparative, get_flat_name(node_kind));
+    dump_gv(first_[node], graph, operation);
+    dump_gv(second_[node], graph, operation);
+}
+
+} // end namespace paracl
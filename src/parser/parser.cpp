@@ -44,7 +44,12 @@ int parser::get_operator_precedence(token_type type) const {
     }
 }
 
+text_range parser::get_range_from(text_position begin) const {
+    return text_range{begin, tokens_[current_token_num_ - 1].range.end};
+}
+
 std::unique_ptr<node> parser::parse_expression(int min_precedence) {
+    text_position begin = current_token().range.begin;
     std::unique_ptr<node> left = parse_id_or_num();
 
     while (current_token().type != token_type::RIGHT_PARENTHESIS &&
@@ -91,11 +96,14 @@ std::unique_ptr<node> parser::parse_expression(int min_precedence) {
                 // добавить обработку ошибки
                 return nullptr;
         }
+
+        left->set_range(get_range_from(begin));
     }
     return left;
 }
 
 std::unique_ptr<node> parser::parse_id_or_num(bool create_variable) {
+    text_position begin = current_token().range.begin;
     token current_token = eat_token();
 
     if (current_token.type == token_type::LEFT_PARENTHESIS) {
@@ -103,6 +111,9 @@ std::unique_ptr<node> parser::parse_id_or_num(bool create_variable) {
         if (eat_token().type != token_type::RIGHT_PARENTHESIS) {
             // добавить обработку ошибки
         }
+
+        if (expr)
+            expr->set_range(get_range_from(begin));
         return expr;
     }
 
@@ -112,6 +123,7 @@ std::unique_ptr<node> parser::parse_id_or_num(bool create_variable) {
         current_token = eat_token();
     }
 
+    std::unique_ptr<node> operand;
     switch(current_token.type) {
         case token_type::ID: {
             std::string id_name{current_token.id.data(), current_token.id.size()};
@@ -120,30 +132,27 @@ std::unique_ptr<node> parser::parse_id_or_num(bool create_variable) {
                 //обработка
             }
 
-            context_.create_variable(id_name);
-            std::unique_ptr<node> new_id_node = std::make_unique<id_node>(id_name);
-            if (is_neg) {
-                return std::make_unique<negate_node>(std::move(new_id_node));
-            }
-            return new_id_node;
-        }
-        case token_type::NUMBER: {
-            std::unique_ptr<node> new_num_node = std::make_unique<number_node>(current_token.number);
-            if (is_neg) {
-                return std::make_unique<negate_node>(std::move(new_num_node));
-            }
-            return new_num_node;
-        }
-        case token_type::SCAN: {
-            std::unique_ptr<node> new_scan_node = std::make_unique<scan_node>();
-            if (is_neg) {
-                return std::make_unique<negate_node>(std::move(new_scan_node));
-            }
-            return new_scan_node;
+            size_t slot = context_.create_variable(id_name);
+            operand = std::make_unique<id_node>(id_name, slot);
+            break;
         }
+        case token_type::NUMBER:
+            operand = std::make_unique<number_node>(current_token.number);
+            break;
+        case token_type::SCAN:
+            operand = std::make_unique<scan_node>();
+            break;
         default:
             return nullptr; //добавить обработку ошибки
     }
+
+    operand->set_range(current_token.range);
+    if (!is_neg)
+        return operand;
+
+    std::unique_ptr<node> negated = std::make_unique<negate_node>(std::move(operand));
+    negated->set_range(get_range_from(begin));
+    return negated;
 }
 
 std::unique_ptr<node> parser::parse_function() {
@@ -154,7 +163,7 @@ std::unique_ptr<node> parser::parse_function() {
     std::string function_name{function.id.data(), function.id.size()};
 
     eat_token();
-    std::vector<std::unique_ptr<node>> args;
+    node_list args;
     while (current_token().type != token_type::RIGHT_PARENTHESIS) {
         args.push_back(parse_expression(0));
 
@@ -162,7 +171,10 @@ std::unique_ptr<node> parser::parse_function() {
         //if (eat_token().type !=token_type::COMMA)
     }
     eat_token();
-    return std::make_unique<function_node>(function_name, std::move(args));
+
+    std::unique_ptr<node> call = std::make_unique<function_node>(function_name, std::move(args));
+    call->set_range(get_range_from(function.range.begin));
+    return call;
 }
 
 std::unique_ptr<node> parser::parse_assing_operation() {
@@ -191,8 +203,8 @@ std::unique_ptr<node> parser::parse_condition() {
     return condition;
 }
 
-std::vector<std::unique_ptr<node>> parser::parse_scope() {
-    std::vector<std::unique_ptr<node>> scope;
+node_list parser::parse_scope() {
+    node_list scope;
 
     while (current_token_num_ != tokens_.size()
            && current_token().type != token_type::RIGHT_CURLY_BRACKET) {
@@ -208,19 +220,24 @@ std::vector<std::unique_ptr<node>> parser::parse_scope() {
             case token_type::IF: {
                 token keyword = eat_token();
                 std::unique_ptr<node> condition = parse_condition();
+                text_range header = get_range_from(keyword.range.begin);
 
                 if (eat_token().type != token_type::LEFT_CURLY_BRACKET) return {}; // добавить обработку ошибки
-                std::vector<std::unique_ptr<node>> body = parse_scope();
+                context_.enter_scope();
+                node_list body = parse_scope();
+                context_.leave_scope();
                 if (eat_token().type != token_type::RIGHT_CURLY_BRACKET) return {}; // добавить обработку ошибки
 
                 if (keyword.type == token_type::WHILE) {
                     std::unique_ptr<node> while_n = std::make_unique<while_node>(std::move(condition),
                                                                                  std::move(body));
+                    while_n->set_range(header);
                     scope.push_back(std::move(while_n));
                 }
                 else if (keyword.type == token_type::IF) {
                     std::unique_ptr<node> if_n = std::make_unique<if_node>(std::move(condition),
                                                                            std::move(body));
+                    if_n->set_range(header);
                     scope.push_back(std::move(if_n));
                 }
                 else {
@@ -48,15 +48,15 @@ void colored_text::set_attribute(colored_text::attribute attribute) {
     set_formatting({ .attribute = attribute });
 }
 
-void colored_text::print() const {
-    bool should_colorize = isatty(fileno(stdout));
+void colored_text::print(std::FILE *stream) const {
+    bool should_colorize = isatty(fileno(stream));
     bool should_reset = false;
 
     size_t overlay_index = 0;
     for (size_t i = 0; i < text_.size(); ++ i) {
         if (should_colorize && overlay_index < overlays_.size()) {
             if (overlays_[overlay_index].begin == i) {
-                std::print("{}",
+                std::print(stream, "{}",
                     overlays_[overlay_index].formatting.get_ansi_code()
                 );
 
@@ -64,14 +64,14 @@ void colored_text::print() const {
             }
         }
 
-        std::print("{}", text_[i]);
+        std::print(stream, "{}", text_[i]);
 
         if (should_colorize && overlay_index < overlays_.size()) {
             if (overlays_[overlay_index].end == i + 1) {
                 assert(should_reset && "overlay ended but haven't begun");
                 should_reset = false;
 
-                std::print("{}", RESET_SEQUENCE);
+                std::print(stream, "{}", RESET_SEQUENCE);
                 overlay_index ++;
             }
         }
@@ -5,11 +5,12 @@
 #include <span>
 #include <cassert>
 #include <algorithm>
+#include <print>
 
 
 namespace paracl {
 
-void file::message(const std::string &message, std::vector<rng> rngs) {
+void file::message(const std::string &message, std::vector<rng> rngs, std::FILE *stream) {
     assert(rngs.size() != 0);
 
     std::vector<annotated_range> ranges;
@@ -18,11 +19,11 @@ void file::message(const std::string &message, std::vector<rng> rngs) {
 
     std::sort(ranges.begin(), ranges.end());
 
-    std::cout << filename << ":" << ranges[0].range.begin.line << ":" << ranges[0].range.begin.column << ": " << message << "\n";
+    std::print(stream, "{}:{}:{}: {}\n", filename, ranges[0].range.begin.line, ranges[0].range.begin.column + 1, message);
 
-    colored_text stream = annotate(text, ranges);
+    colored_text annotated = annotate(text, ranges);
 
-    stream.print();
+    annotated.print(stream);
 }
 
 } // end namespace paracl
@@ -2,6 +2,14 @@
 
 #include <sstream>
 #include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 namespace paracl {
@@ -15,5 +23,68 @@ std::string read_file(const std::string &filename) {
     return saved_saved_stream.str();
 }
 
-} // end namespace paracl
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::string &filename) {
+    std::ifstream stream{filename, std::ios::binary};
+    if (!stream)
+        throw std::runtime_error("can't open " + filename);
+
+    std::stringstream text;
+    text << stream.rdbuf();
+
+    text_ = text.str();
+    data_ = text_.data();
+    size_ = text_.size();
+}
+
+mapped_file::~mapped_file() = default;
+
+#else
+
+mapped_file::mapped_file(const std::string &filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("can't open " + filename);
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        throw std::runtime_error("can't open " + filename);
+    }
+
+    // Size of pipes and devices isn't known, they are left open to be read from:
+    if (!S_ISREG(status.st_mode)) {
+        fd_ = fd;
+        return;
+    }
 
+    size_ = static_cast<size_t>(status.st_size);
+
+    // Empty files can't be mapped, and there is nothing to map anyway:
+    if (size_ != 0) {
+        void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("can't map " + filename);
+        }
+
+        // It's read through once, front to back:
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+    }
+
+    close(fd);
+}
+
+mapped_file::~mapped_file() {
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+#endif
+
+} // end namespace paracl
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+
+namespace paracl::testing {
+
+// Points stream at another buffer until the end of scope, tests that expect
+// programs to throw mustn't leave std::cout writing to a destroyed buffer
+class scoped_rdbuf {
+public:
+    scoped_rdbuf(std::ios &stream, std::streambuf *buffer):
+        stream_(stream), old_buffer_(stream.rdbuf(buffer)) {}
+
+    scoped_rdbuf(const scoped_rdbuf &other) = delete;
+    scoped_rdbuf &operator=(const scoped_rdbuf &other) = delete;
+
+    ~scoped_rdbuf() {
+        // Unfinished line of a failed program belongs to the captured output
+        get_output().flush();
+        stream_.rdbuf(old_buffer_);
+    }
+
+private:
+    std::ios &stream_;
+    std::streambuf *old_buffer_;
+};
+
+// Everything program prints to std::cout while it runs
+template <typename program_type>
+std::string capture_output(program_type &&program) {
+    std::stringstream output;
+    {
+        scoped_rdbuf redirect(std::cout, output.rdbuf());
+        std::forward<program_type>(program)();
+    }
+
+    return output.str();
+}
+
+// Output of the program on tree evaluator, after transform is applied to its tree
+template <typename transform_type>
+std::string run_tree(std::string input, transform_type &&transform) {
+    paracl::ast ast(paracl::tokenize(input));
+    std::forward<transform_type>(transform)(ast);
+
+    return capture_output([&] { ast.run(); });
+}
+
+inline std::string run_tree(std::string input) {
+    return run_tree(std::move(input), [](paracl::ast&) {});
+}
+
+inline std::string dump(const paracl::ast &ast) {
+    std::stringstream output;
+    ast.dump(output);
+    return output.str();
+}
+
+} // end namespace paracl::testing
@@ -0,0 +1,243 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/interpreter/bytecode.h"
+#include "paracl/interpreter/vm.h"
+#include "paracl/optimizer/fusion.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::run_tree;
+
+std::string run_bytecode(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::bytecode program = paracl::compile_bytecode(ast.get_scope(), ast.get_context());
+
+    return paracl::testing::capture_output([&] {
+        paracl::vm machine;
+        machine.run(program, ast.get_context());
+    });
+}
+
+std::string run_ir(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+
+    paracl::ir::function function = paracl::ir::build_ir(ast.get_scope(), ast.get_context());
+    paracl::bytecode program = paracl::compile_bytecode(function, ast.get_context());
+
+    return paracl::testing::capture_output([&] {
+        paracl::vm machine;
+        machine.run(program, ast.get_context());
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("run ParaCL program on bytecode vm") {
+    using namespace paracl;
+
+    SECTION("no program") {
+        REQUIRE(run_bytecode("") == "");
+    }
+
+    SECTION("factorial") {
+        std::string input = R"(
+            max_border = 5;
+            res        = 1;
+            cur_it     = 1;
+
+            while (cur_it <= max_border) {
+                res    *= cur_it;
+                cur_it += 1;
+                print(res);
+            }
+        )";
+
+        REQUIRE(run_bytecode(input) == "1\n2\n6\n24\n120\n");
+        REQUIRE(run_bytecode(input) == run_tree(input));
+    }
+
+    SECTION("fibonacci") {
+        std::string input = R"(
+            max_border = 8;
+            cur_it     = 1;
+
+            fn   = 0;
+            fn_2 = 0;
+            fn_1 = 1;
+
+            while(cur_it < max_border) {
+                fn = fn_1 + fn_2;
+                fn_2 = fn_1;
+                fn_1 = fn;
+                cur_it += 1;
+            }
+
+            print(fn);
+        )";
+
+        REQUIRE(run_bytecode(input) == "21\n");
+        REQUIRE(run_bytecode(input) == run_tree(input));
+    }
+
+    SECTION("number of even digits") {
+        std::string input = R"(
+            num = 1234567890;
+            res = 0;
+
+            while(num > 0) {
+                if(num / 2 * 2 == num) {
+                    res += 1;
+                }
+                num /= 10;
+            }
+
+            print(res);
+        )";
+
+        REQUIRE(run_bytecode(input) == "5\n");
+        REQUIRE(run_bytecode(input) == run_tree(input));
+    }
+
+    SECTION("complex expression") {
+        std::string input = R"(
+            anishka = (3 + 5 * (4 - 8) / -4) * (6 - (2 + 3) * 2) + 10 / (5 - 3);
+
+            print(anishka);
+        )";
+
+        REQUIRE(run_bytecode(input) == "-27\n");
+        REQUIRE(run_bytecode(input) == run_tree(input));
+    }
+
+    SECTION("conditions") {
+        std::string input = R"(
+            a = 3;
+            b = a;
+
+            if (a == b) {
+                a = a * (b + 1);
+            }
+
+            if (a - 12) {
+                a = 0;
+            }
+
+            while (b) {
+                print(a + b);
+                b -= 1;
+            }
+        )";
+
+        REQUIRE(run_bytecode(input) == "15\n14\n13\n");
+        REQUIRE(run_bytecode(input) == run_tree(input));
+    }
+
+    SECTION("variables are stored back to context") {
+        std::string input = R"(
+            x = 2;
+            y = x * x;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        paracl::bytecode program = paracl::compile_bytecode(ast.get_scope(), ast.get_context());
+
+        paracl::vm machine;
+        machine.run(program, ast.get_context());
+
+        std::optional<size_t> y = ast.get_context().find_variable("y");
+        REQUIRE(y);
+        REQUIRE(*ast.get_context().get_variable(*y) == 4);
+    }
+
+    SECTION("divide by zero") {
+        std::string input = R"(
+            zero = 0;
+            x = 1 / zero;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        paracl::bytecode program = paracl::compile_bytecode(ast.get_scope(), ast.get_context());
+
+        paracl::vm machine;
+        REQUIRE_THROWS(machine.run(program, ast.get_context()));
+    }
+
+    SECTION("fused nodes are compiled through their original") {
+        std::string input = R"(
+            i = 0;
+            s = 0;
+            while (i < 10) {
+                s += i * 2;
+                if (s > 20) {
+                    s -= 20;
+                }
+                i += 1;
+            }
+            print(s);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE(paracl::fuse_superinstructions(ast) > 0);
+
+        paracl::bytecode program = paracl::compile_bytecode(ast.get_scope(), ast.get_context());
+
+        std::string output = paracl::testing::capture_output([&] {
+            paracl::vm machine;
+            machine.run(program, ast.get_context());
+        });
+        REQUIRE(output == run_tree(input));
+    }
+
+    SECTION("lowered from ssa form") {
+        std::vector<std::string> inputs = {
+            R"(
+                a = 1;
+                b = 2;
+                i = 0;
+                while (i < 3) {
+                    t = a;
+                    a = b;
+                    b = t;
+                    i += 1;
+                    print(a);
+                }
+                print(b);
+            )",
+            R"(
+                num = 1234567890;
+                res = 0;
+                while (num > 0) {
+                    if (num / 2 * 2 == num) {
+                        res += 1;
+                    }
+                    num /= 10;
+                }
+                print(res);
+            )",
+            R"(
+                x = 5;
+                y = 0;
+                while (x) {
+                    if (x - 2) {
+                        y += x;
+                    }
+                    x -= 1;
+                    if (x < 0) {
+                        print(-1);
+                    }
+                }
+                print(y);
+                print(-x * 3 + 2);
+            )",
+        };
+
+        for (const std::string &input: inputs)
+            REQUIRE(run_ir(input) == run_tree(input));
+
+        REQUIRE(run_ir(inputs[0]) == "2\n1\n2\n1\n");
+    }
+}
@@ -0,0 +1,114 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/closures.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::run_tree;
+
+std::string run_closures(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::closure program = paracl::compile_scope(ast.get_scope(), ast.get_context());
+
+    return paracl::testing::capture_output([&] { program(); });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("run ParaCL program as closures") {
+    using namespace paracl;
+
+    SECTION("no program") {
+        REQUIRE(run_closures("") == "");
+    }
+
+    SECTION("factorial") {
+        std::string input = R"(
+            max_border = 5;
+            res        = 1;
+            cur_it     = 1;
+
+            while (cur_it <= max_border) {
+                res    *= cur_it;
+                cur_it += 1;
+                print(res);
+            }
+        )";
+
+        REQUIRE(run_closures(input) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("number of even digits") {
+        std::string input = R"(
+            num = 1234567890;
+            res = 0;
+
+            while(num > 0) {
+                if(num / 2 * 2 == num) {
+                    res += 1;
+                }
+                num /= 10;
+            }
+
+            print(res);
+        )";
+
+        REQUIRE(run_closures(input) == "5\n");
+    }
+
+    SECTION("every kind of operand") {
+        std::string input = R"(
+            a = 7;
+            b = -a;
+            c = (3 + 5 * (4 - 8) / -4) * (6 - (2 + 3) * 2) + 10 / (5 - 3);
+
+            print(a + 1);
+            print(1 - a);
+            print(a * b);
+            print(b / (a - 5));
+            print(c);
+            print(a == 7);
+            print((a < b) + (a > b) * 2 + (a <= 7) * 4 + (b >= a) * 8);
+
+            if (a - 7) {
+                a = 0;
+            }
+
+            d = 10;
+            d -= a;
+            d /= 3 - 2;
+            print(d);
+        )";
+
+        REQUIRE(run_closures(input) == run_tree(input));
+    }
+
+    SECTION("variables are shared with context") {
+        std::string input = R"(
+            x = 2;
+            y = x * x;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        compile_scope(ast.get_scope(), ast.get_context())();
+
+        std::optional<size_t> y = ast.get_context().find_variable("y");
+        REQUIRE(y);
+        REQUIRE(*ast.get_context().get_variable(*y) == 4);
+    }
+
+    SECTION("divide by zero") {
+        std::string input = R"(
+            zero = 0;
+            x = 1;
+            x /= zero;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE_THROWS(compile_scope(ast.get_scope(), ast.get_context())());
+    }
+}
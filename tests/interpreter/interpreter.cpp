@@ -1,6 +1,7 @@
 #include "paracl/lexer/lexer.h"
 #include "paracl/ast/ast.h"
 #include "catch2/catch2.h"
+#include "common/capture.h"
 
 TEST_CASE("run ParaCL program") {
     using namespace paracl;
@@ -9,13 +10,8 @@ TEST_CASE("run ParaCL program") {
         std::vector<token> tokens = {};
 
         paracl::ast ast(tokens);
-        std::stringstream output;
-        std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
-
-        ast.run();
-
-        std::cout.rdbuf(old_cout);
-        REQUIRE(output.str() == "");
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "");
     }
 
     SECTION("factorial") {
@@ -34,13 +30,8 @@ TEST_CASE("run ParaCL program") {
 
         paracl::ast ast(tokens);
 
-        std::stringstream output;
-        std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
-
-        ast.run();
-
-        std::cout.rdbuf(old_cout);
-        REQUIRE(output.str() == "1\n2\n6\n24\n120\n");
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "1\n2\n6\n24\n120\n");
     }
 
     SECTION("fibonacci") {
@@ -65,13 +56,8 @@ TEST_CASE("run ParaCL program") {
 
         paracl::ast ast(tokens);
 
-        std::stringstream output;
-        std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
-
-        ast.run();
-
-        std::cout.rdbuf(old_cout);
-        REQUIRE(output.str() == "21\n");
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "21\n");
     }
 
     SECTION("number of even digits") {
@@ -92,13 +78,8 @@ TEST_CASE("run ParaCL program") {
 
         paracl::ast ast(tokens);
 
-        std::stringstream output;
-        std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
-
-        ast.run();
-
-        std::cout.rdbuf(old_cout);
-        REQUIRE(output.str() == "5\n");
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "5\n");
     }
 
     SECTION("complex expression") {
@@ -111,12 +92,41 @@ TEST_CASE("run ParaCL program") {
 
         paracl::ast ast(tokens);
 
-        std::stringstream output;
-        std::streambuf* old_cout = std::cout.rdbuf(output.rdbuf());
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "-27\n");
+    }
 
-        ast.run();
+    SECTION("divisor is evaluated once") {
+        std::string input = R"(
+            x = 100 / ?;
+            y = ?;
+            y /= ?;
+            print(x + y);
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
+
+        std::stringstream values("5 30 3");
+        paracl::testing::scoped_rdbuf redirect(std::cin, values.rdbuf());
+
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "Input: Input: Input: 30\n");
+    }
+
+    SECTION("full 64-bit values") {
+        std::string input = R"(
+            half = 4611686018427387904;
+            print(half - 1 + half);
+            print(-half - half);
+            print((half - 1 + half) / 3 * 2);
+            print(-half - half < 0);
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
 
-        std::cout.rdbuf(old_cout);
-        REQUIRE(output.str() == "-27\n");
+        std::string output = paracl::testing::capture_output([&] { ast.run(); });
+        REQUIRE(output == "9223372036854775807\n-9223372036854775808\n6148914691236517204\n1\n");
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,206 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/interpreter/jit.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::run_tree;
+
+std::string run_jit(std::string input, size_t expected_compiled_loops) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::jit engine(ast.get_context());
+
+    std::string output = paracl::testing::capture_output([&] {
+        engine.run(ast.get_scope());
+    });
+
+    if (paracl::jit::is_available())
+        REQUIRE(engine.get_compiled_loop_count() == expected_compiled_loops);
+
+    return output;
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("run ParaCL program with jit") {
+    using namespace paracl;
+
+    SECTION("factorial falls back because of print") {
+        std::string input = R"(
+            max_border = 5;
+            res        = 1;
+            cur_it     = 1;
+
+            while (cur_it <= max_border) {
+                res    *= cur_it;
+                cur_it += 1;
+                print(res);
+            }
+        )";
+
+        REQUIRE(run_jit(input, 0) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("fibonacci") {
+        std::string input = R"(
+            max_border = 8;
+            cur_it     = 1;
+
+            fn   = 0;
+            fn_2 = 0;
+            fn_1 = 1;
+
+            while(cur_it < max_border) {
+                fn = fn_1 + fn_2;
+                fn_2 = fn_1;
+                fn_1 = fn;
+                cur_it += 1;
+            }
+
+            print(fn);
+        )";
+
+        REQUIRE(run_jit(input, 1) == "21\n");
+    }
+
+    SECTION("number of even digits") {
+        std::string input = R"(
+            num = 1234567890;
+            res = 0;
+
+            while(num > 0) {
+                if(num / 2 * 2 == num) {
+                    res += 1;
+                }
+                num /= 10;
+            }
+
+            print(res);
+        )";
+
+        REQUIRE(run_jit(input, 1) == "5\n");
+    }
+
+    SECTION("more variables than registers") {
+        std::string input = R"(
+            a = 1; b = 2; c = 3; d = 4; e = 5; f = 6; g = 7; h = 8;
+            i = 0;
+
+            while (i < 1000) {
+                a = b + c - (d * e);
+                b = c + 1;
+                c = (d - a) / 3;
+                d = e * -f + g;
+                e = h - (a == b) + (c >= d) * 5;
+                f = f + (g <= h);
+                g = g - (h > a) + (a < b);
+                h = -h;
+                i += 1;
+            }
+
+            print(a);
+            print(b);
+            print(c);
+            print(d);
+            print(e);
+            print(f);
+            print(g);
+            print(h);
+        )";
+
+        REQUIRE(run_jit(input, 1) == run_tree(input));
+    }
+
+    SECTION("nested loops inside of an interpreted loop") {
+        std::string input = R"(
+            n = 0;
+            while (n < 4) {
+                sum = 0;
+                i = 0;
+                while (i <= n * 1000) {
+                    j = 0;
+                    while (j < 3) {
+                        sum += i * j - 5000000000;
+                        j += 1;
+                    }
+                    i += 1;
+                }
+                print(sum);
+                n += 1;
+            }
+        )";
+
+        REQUIRE(run_jit(input, 1) == run_tree(input));
+    }
+
+    SECTION("divide by zero inside of a loop") {
+        std::string input = R"(
+            i = 3;
+            x = 0;
+            while (i > -3) {
+                x += 12 / i;
+                i -= 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        paracl::jit engine(ast.get_context());
+
+        REQUIRE_THROWS(engine.run(ast.get_scope()));
+
+        // State of the loop is preserved up to the failing division:
+        context &ctx = ast.get_context();
+        REQUIRE(*ctx.get_variable(*ctx.find_variable("i")) == 0);
+        REQUIRE(*ctx.get_variable(*ctx.find_variable("x")) == 4 + 6 + 12);
+    }
+
+    SECTION("values of dead stores are computed") {
+        std::string input = R"(
+            a = 6;
+            b = 2;
+            i = 0;
+            while (i < 3) {
+                x = a / b;
+                i += 1;
+                b -= 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        // Dead stores leave such statements, parser never makes them:
+        auto &loop = static_cast<paracl::while_node&>(*ast.get_scope()[3]);
+        auto &store = static_cast<paracl::binary_node&>(*loop.get_scope()[0]);
+        loop.get_scope()[0] = std::move(store.get_right());
+
+        paracl::jit engine(ast.get_context());
+        REQUIRE_THROWS_WITH(engine.run(ast.get_scope()), "divide by zero");
+
+        if (paracl::jit::is_available())
+            REQUIRE(engine.get_compiled_loop_count() == 1);
+    }
+
+    SECTION("divide by zero while an operand is on the stack") {
+        std::string input = R"(
+            a = 1;
+            b = 0;
+            c = 2;
+            d = 3;
+            i = 0;
+            while (i < 1) {
+                x = a / b + c * d;
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        paracl::jit engine(ast.get_context());
+
+        REQUIRE_THROWS_WITH(engine.run(ast.get_scope()), "divide by zero");
+        REQUIRE(*ast.get_context().get_variable(*ast.get_context().find_variable("i")) == 0);
+    }
+}
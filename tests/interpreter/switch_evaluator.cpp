@@ -0,0 +1,113 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/switch_evaluator.h"
+#include "paracl/optimizer/fusion.h"
+#include "paracl/optimizer/induction.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::run_tree;
+
+std::string run_switch(std::string input, bool optimize = false) {
+    paracl::ast ast(paracl::tokenize(input));
+    if (optimize) {
+        paracl::replace_induction_loops(ast);
+        paracl::fuse_superinstructions(ast);
+    }
+
+    return paracl::testing::capture_output([&] {
+        paracl::switch_evaluator evaluator(ast.get_context());
+        evaluator.run(ast.get_scope());
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("run ParaCL program with switch dispatch") {
+    using namespace paracl;
+
+    SECTION("no program") {
+        REQUIRE(run_switch("") == "");
+    }
+
+    SECTION("factorial") {
+        std::string input = R"(
+            max_border = 5;
+            res        = 1;
+            cur_it     = 1;
+
+            while (cur_it <= max_border) {
+                res    *= cur_it;
+                cur_it += 1;
+                print(res);
+            }
+        )";
+
+        REQUIRE(run_switch(input) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("every kind of operand") {
+        std::string input = R"(
+            a = 7;
+            b = -a;
+            c = (3 + 5 * (4 - 8) / -4) * (6 - (2 + 3) * 2) + 10 / (5 - 3);
+
+            print(a + 1);
+            print(1 - a);
+            print(a * b);
+            print(b / (a - 5));
+            print(c);
+            print(a == 7);
+            print((a < b) + (a > b) * 2 + (a <= 7) * 4 + (b >= a) * 8);
+
+            if (a - 7) {
+                a = 0;
+            }
+
+            d = 10;
+            d -= a;
+            d /= 3 - 2;
+            print(d);
+        )";
+
+        REQUIRE(run_switch(input) == run_tree(input));
+    }
+
+    SECTION("fused and closed form nodes") {
+        std::string input = R"(
+            i = 0;
+            s = 0;
+            while (i < 100) {
+                s += i;
+                i += 1;
+            }
+            print(s);
+
+            j = 0;
+            while (j * j < 50) {
+                j += 1;
+                if (j / 2 * 2 == j) {
+                    print(j);
+                }
+            }
+        )";
+
+        REQUIRE(run_switch(input, true) == run_tree(input));
+    }
+
+    SECTION("divide by zero") {
+        std::string input = R"(
+            zero = 0;
+            x = 1;
+            x /= zero;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        switch_evaluator evaluator(ast.get_context());
+        REQUIRE_THROWS(evaluator.run(ast.get_scope()));
+    }
+}
@@ -0,0 +1,83 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/interpreter/tiering.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <sstream>
+
+
+namespace {
+
+std::string run_tiered(std::string input, size_t threshold, size_t expected_promotions,
+                       std::ostream *trace = nullptr) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::tiered_engine engine(ast.get_context(), { .hotness_threshold = threshold, .trace = trace });
+
+    std::string output = paracl::testing::capture_output([&] {
+        engine.run(ast.get_scope());
+    });
+
+    REQUIRE(engine.get_promoted_loop_count() == expected_promotions);
+    return output;
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("run ParaCL program with tiering") {
+    using namespace paracl;
+
+    std::string factorial = R"(
+        max_border = 5;
+        res        = 1;
+        cur_it     = 1;
+
+        while (cur_it <= max_border) {
+            res    *= cur_it;
+            cur_it += 1;
+            print(res);
+        }
+    )";
+
+    SECTION("cold loop stays in tree-walker") {
+        REQUIRE(run_tiered(factorial, 1000, 0) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("hot loop moves to bytecode in the middle") {
+        REQUIRE(run_tiered(factorial, 2, 1) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("loop becomes hot on the last iteration") {
+        REQUIRE(run_tiered(factorial, 5, 1) == "1\n2\n6\n24\n120\n");
+    }
+
+    SECTION("inner loop gets hot across several runs") {
+        std::string input = R"(
+            i = 0;
+            total = 0;
+            while (i < 10) {
+                j = 0;
+                while (j < 3) {
+                    total += i * j;
+                    j += 1;
+                }
+                i += 1;
+            }
+            print(total);
+        )";
+
+        // Inner loop does 3 iterations a run, so it gets hot during the 4th run
+        // of the outer loop, and outer loop itself never gets hot:
+        REQUIRE(run_tiered(input, 12, 1) == "135\n");
+        REQUIRE(run_tiered(input, 1, 2) == "135\n");
+    }
+
+    SECTION("transitions are traced") {
+        std::stringstream trace;
+        run_tiered(factorial, 3, 1, &trace);
+
+        REQUIRE(trace.str() == "tiering: while (&le; (cur_it max_border)) "
+                               "moved from tree-walker to bytecode after 3 iterations\n");
+    }
+}
@@ -0,0 +1,167 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/cse.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool eliminate) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (eliminate)
+            paracl::eliminate_common_subexpressions(ast);
+    });
+}
+
+size_t count_nodes(const paracl::node &tree) {
+    using namespace paracl;
+
+    switch (tree.get_kind()) {
+    case node_kind::NEGATE:
+        return 1 + count_nodes(static_cast<const negate_node&>(tree).get_child());
+
+    case node_kind::FUNCTION: {
+        size_t count = 1;
+        for (const auto &arg: static_cast<const function_node&>(tree).get_args())
+            count += count_nodes(*arg);
+        return count;
+    }
+
+    case node_kind::IF:
+    case node_kind::WHILE: {
+        const auto &conditional = static_cast<const while_node&>(tree);
+
+        size_t count = 1 + count_nodes(conditional.get_condition());
+        for (const auto &statement: conditional.get_scope())
+            count += count_nodes(*statement);
+        return count;
+    }
+
+    default:
+        if (tree.get_kind() == node_kind::NUMBER || tree.get_kind() == node_kind::ID ||
+            tree.get_kind() == node_kind::SCAN)
+            return 1;
+
+        const auto &binary = static_cast<const binary_node&>(tree);
+        return 1 + count_nodes(binary.get_left()) + count_nodes(binary.get_right());
+    }
+}
+
+size_t count_nodes(const paracl::ast &ast) {
+    size_t count = 0;
+    for (const auto &statement: ast.get_scope())
+        count += count_nodes(*statement);
+
+    return count;
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("eliminate common subexpressions") {
+    using namespace paracl;
+
+    SECTION("repeated expression in a statement") {
+        std::string input = R"(
+            a = ?;
+            b = ?;
+            x = a * b + a * b;
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 1);
+        REQUIRE(dump(ast) == "main( = (a scan) = (b scan) = ($cse0 * (a b)) = (x + ($cse0 $cse0)) print( x ) )");
+    }
+
+    SECTION("writes in between make expressions different") {
+        std::string input = R"(
+            x = 7;
+            y = x - 1;
+            x = y;
+            z = x - 1;
+            print(y * z);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 0);
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("largest repeated expression is reused") {
+        std::string input = R"(
+            a = ?;
+            c = ?;
+            x = (a * 2 + c) * (a * 2 + c);
+            y = a * 2;
+            print(x - y);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 2);
+        REQUIRE(dump(ast) == "main( = (a scan) = (c scan) = ($cse1 * (a 2)) = ($cse0 + ($cse1 c)) "
+                             "= (x * ($cse0 $cse0)) = (y $cse1) print( - (x y) ) )");
+    }
+
+    SECTION("loops reuse only what they don't change") {
+        std::string input = R"(
+            n = 5;
+            k = 3;
+            s = n * k;
+            i = 0;
+            while (i < n * k) {
+                s += (i - 1) * (i - 1) + n * k;
+                i += 1;
+            }
+            print(s);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 3);
+        REQUIRE(dump(ast) == "main( = (n 5) = (k 3) = ($cse0 * (n k)) = (s $cse0) = (i 0) "
+                             "while ((&lt; (i $cse0)) (= ($cse1 - (i 1))) (+= (s + (* ($cse1 $cse1) $cse0))) (+= (i 1))) "
+                             "print( s ) )");
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("input and failing division are kept") {
+        std::string input = R"(
+            d = 0;
+            x = ? + ?;
+            y = 1 / d + 1 / d;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 0);
+    }
+
+    SECTION("generated code gets smaller") {
+        std::string input = R"(
+            a = 3;
+            b = 4;
+            r = 0;
+            i = 0;
+            while (i < 100) {
+                r += (a * b - i * 2) * (a * b - i * 2) + (a * b - i * 2);
+                r -= (a * b - i * 2) / 3;
+                i += 1;
+            }
+            print(r);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        size_t before = count_nodes(ast);
+
+        REQUIRE(eliminate_common_subexpressions(ast) == 3);
+        REQUIRE(count_nodes(ast) < before);
+        REQUIRE(run(input, true) == run(input, false));
+    }
+}
@@ -0,0 +1,142 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/dead_stores.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <sstream>
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool eliminate) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (eliminate)
+            paracl::eliminate_dead_stores(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("eliminate dead stores") {
+    using namespace paracl;
+
+    SECTION("unused variables are removed") {
+        std::string input = R"(
+            scratch = 5;
+            x = 1;
+            tmp = x * 2;
+            x = x + 1;
+            print(x);
+            x = 7;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_dead_stores(ast) == 3);
+        REQUIRE(dump(ast) == "main( = (x 1) = (x + (x 1)) print( x ) )");
+
+        context &ctx = ast.get_context();
+        REQUIRE(ctx.get_variable_count() == 1);
+        REQUIRE(!ctx.find_variable("scratch"));
+        REQUIRE(!ctx.find_variable("tmp"));
+        REQUIRE(*ctx.find_variable("x") == 0);
+    }
+
+    SECTION("stores read by later iterations are kept") {
+        std::string input = R"(
+            i = 0;
+            prev = 0;
+            unused = 0;
+            while (i < 5) {
+                if (i > 2) {
+                    print(prev);
+                }
+                prev = i * i;
+                unused = prev + 1;
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_dead_stores(ast) == 2);
+        REQUIRE(!ast.get_context().find_variable("unused"));
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("input is still read") {
+        std::string input = R"(
+            skipped = ?;
+            x = ?;
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_dead_stores(ast) == 0);
+        REQUIRE(dump(ast) == "main( scan = (x scan) print( x ) )");
+        REQUIRE(ast.get_context().get_variable_count() == 1);
+    }
+
+    SECTION("failing division is still evaluated") {
+        std::string input = R"(
+            zero = 0;
+            x = 1 / zero;
+            y = 1 / 2;
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_dead_stores(ast) == 1);
+        REQUIRE_THROWS(ast.run());
+    }
+
+    SECTION("saved program keeps variables that lost their top level mentions") {
+        std::string input = R"(
+            b = f;
+            i = 0;
+            while (i < 1) {
+                f = 8;
+                i += 1;
+            }
+            print(f);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE(eliminate_dead_stores(ast) == 1);
+
+        std::stringstream source;
+        ast.dump_source(source);
+        REQUIRE(source.str() == "f = 0;\n"
+                                "i = 0;\n"
+                                "while (i < 1) {\n"
+                                "    f = 8;\n"
+                                "    i += 1;\n"
+                                "}\n"
+                                "print(f);\n");
+
+        REQUIRE(paracl::testing::run_tree(source.str()) == run(input, false));
+        REQUIRE(run(input, false) == "8\n");
+    }
+
+    SECTION("failing division assignment is kept whole") {
+        std::string input = R"(
+            a = 0;
+            e = 3;
+            e /= a;
+            f = 3;
+            f /= 2;
+            print(1);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(eliminate_dead_stores(ast) == 2);
+        REQUIRE(dump(ast) == "main( = (a 0) = (e 3) /= (e a) print( 1 ) )");
+        REQUIRE_THROWS(ast.run());
+    }
+}
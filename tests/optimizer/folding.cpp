@@ -0,0 +1,114 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/folding.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <sstream>
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool fold) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (fold)
+            paracl::fold_constants(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("fold constants") {
+    using namespace paracl;
+
+    SECTION("constant expressions") {
+        std::string input = R"(
+            x = (3 + 4) * 2;
+            y = x + -2;
+            z = (1 < 2) + (x == 3 * 4);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(fold_constants(ast) == 5);
+        REQUIRE(dump(ast) == "main( = (x 14) = (y + (x -2)) = (z + (1 == (x 12))) )");
+    }
+
+    SECTION("branches with constant conditions") {
+        std::string input = R"(
+            x = 1;
+            if (0) {
+                x = 2;
+            }
+            if (2 - 1) {
+                x += 3;
+                if (1) {
+                    x *= 2;
+                }
+            }
+            while (5 < 4) {
+                x = 0;
+            }
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(fold_constants(ast) == 6);
+        REQUIRE(ast.get_scope().size() == 4);
+        REQUIRE(dump(ast) == "main( = (x 1) += (x 3) *= (x 2) print( x ) )");
+        REQUIRE(run(input, true) == "8\n");
+    }
+
+    SECTION("division by zero is kept") {
+        std::string input = R"(
+            x = 1;
+            if (x) {
+                y = 4 / (2 - 2);
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(fold_constants(ast) == 1);
+        REQUIRE_THROWS(ast.run());
+    }
+
+    SECTION("folded program runs the same") {
+        std::string input = R"(
+            anishka = (3 + 5 * (4 - 8) / -4) * (6 - (2 + 3) * 2) + 10 / (5 - 3);
+            i = 0;
+            while (i < 2 * 3) {
+                if (i == 10 / 5) {
+                    print(anishka - i * (7 - 6));
+                }
+                i += 1 + 0;
+            }
+        )";
+
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("saved program keeps variables of inlined blocks apart") {
+        std::string input = R"(
+            if (1) {
+                y = 5;
+                print(y);
+            }
+            print(y);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE(fold_constants(ast) == 1);
+
+        std::stringstream source;
+        ast.dump_source(source);
+        REQUIRE(source.str() == "y = 5;\nprint(y);\nprint(y_);\n");
+
+        REQUIRE(paracl::testing::run_tree(source.str()) == run(input, false));
+        REQUIRE(run(input, false) == "5\n0\n");
+    }
+}
@@ -0,0 +1,103 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/fused_nodes.h"
+#include "paracl/optimizer/fusion.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool fuse) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (fuse)
+            paracl::fuse_superinstructions(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("fuse superinstructions") {
+    using namespace paracl;
+
+    SECTION("idioms are fused") {
+        std::string input = R"(
+            x = 0;
+            y = 3;
+            while (x <= y) {
+                x += 1;
+                y *= x;
+                z = y - 2;
+                if (x == 100) {
+                    print(x / 7);
+                }
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        std::string original = dump(ast);
+
+        // x = 0, y = 3, while, x += 1, y *= x, y - 2, if, x / 7:
+        REQUIRE(fuse_superinstructions(ast) == 8);
+
+        REQUIRE(ast.get_scope()[2]->get_kind() == node_kind::FUSED);
+        REQUIRE(get_unfused(*ast.get_scope()[2]).get_kind() == node_kind::WHILE);
+
+        REQUIRE(dump(ast) == original);
+    }
+
+    SECTION("complex operands aren't fused") {
+        std::string input = R"(
+            x = 1;
+            y = (x + 1) * (2 - x);
+            while (x < y + 1) {
+                x = -x;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        // x = 1, x + 1, y + 1:
+        REQUIRE(fuse_superinstructions(ast) == 3);
+        REQUIRE(ast.get_scope()[1]->get_kind() == node_kind::ASSIGN);
+        REQUIRE(ast.get_scope()[2]->get_kind() == node_kind::WHILE);
+    }
+
+    SECTION("fused program runs the same") {
+        std::string input = R"(
+            num = 1234567890;
+            res = 0;
+
+            while(num > 0) {
+                if(num / 2 * 2 == num) {
+                    res += 1;
+                }
+                num /= 10;
+            }
+
+            a = 10;
+            b = 3;
+            print(res);
+            print(a - b);
+            print(a / b);
+            print(a >= b);
+            a -= b;
+            a /= 2;
+            print(a);
+        )";
+
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("fused division by zero") {
+        std::string input = "x = 1; y = x / 0;";
+
+        paracl::ast ast(paracl::tokenize(input));
+        fuse_superinstructions(ast);
+
+        REQUIRE_THROWS(ast.run());
+    }
+}
@@ -0,0 +1,117 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/closed_form_nodes.h"
+#include "paracl/optimizer/induction.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <limits>
+
+
+namespace {
+
+std::string run(std::string input, bool replace) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (replace)
+            paracl::replace_induction_loops(ast);
+    });
+}
+
+size_t count_replaced(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    return paracl::replace_induction_loops(ast);
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("replace induction loops with closed form") {
+    using namespace paracl;
+
+    SECTION("sums of linear values") {
+        std::string input = R"(
+            n = 1000;
+            k = 7;
+            i = 0;
+            s = 0;
+            t = 5;
+            c = 0;
+            while (i < n) {
+                s += i * 2 + 1;
+                i += 1;
+                t -= k * i - 3;
+                c += 1;
+            }
+            print(i);
+            print(s);
+            print(t);
+            print(c);
+        )";
+
+        REQUIRE(count_replaced(input) == 1);
+        REQUIRE(run(input, true) == run(input, false));
+        REQUIRE(run(input, true) == "1000\n1000000\n-3500495\n1000\n");
+    }
+
+    SECTION("steps and comparisons") {
+        for (std::string head: { "i < 17", "i <= 17", "i < 0", "i <= 0" }) {
+            std::string input = "i = 0; s = 0; while (" + head + ") { s += i * 2 - 1; i += 3; } print(i); print(s);";
+
+            REQUIRE(count_replaced(input) == 1);
+            REQUIRE(run(input, true) == run(input, false));
+        }
+
+        for (std::string head: { "i > -17", "i >= -17", "i > 0", "i >= 0" }) {
+            std::string input = "i = 0; s = 0; while (" + head + ") { i -= 4; s -= 2 * i; } print(i); print(s);";
+
+            REQUIRE(count_replaced(input) == 1);
+            REQUIRE(run(input, true) == run(input, false));
+        }
+    }
+
+    SECTION("billions of iterations") {
+        std::string input = R"(
+            n = 3000000000;
+            i = 0;
+            s = 0;
+            while (i < n) {
+                s += i * 2 + 1;
+                i += 1;
+            }
+            print(s);
+        )";
+
+        REQUIRE(run(input, true) == "9000000000000000000\n");
+    }
+
+    SECTION("loops that aren't replaced") {
+        // Not linear in counter:
+        REQUIRE(count_replaced("i = 0; s = 0; while (i < 10) { s += i * i; i += 1; }") == 0);
+
+        // Reads other variable written in the loop:
+        REQUIRE(count_replaced("i = 0; s = 0; while (i < 10) { s += s; i += 1; }") == 0);
+
+        // Bound changes:
+        REQUIRE(count_replaced("i = 0; s = 0; while (i < s) { s += 2; i += 1; }") == 0);
+
+        // Reads input, prints:
+        REQUIRE(count_replaced("i = 0; s = 0; while (i < 10) { s += ?; i += 1; }") == 0);
+        REQUIRE(count_replaced("i = 0; while (i < 10) { print(i); i += 1; }") == 0);
+
+        // Counter is stepped twice:
+        REQUIRE(count_replaced("i = 0; while (i < 10) { i += 1; i += 1; }") == 0);
+    }
+
+    SECTION("trip count") {
+        int64_t max = std::numeric_limits<int64_t>::max();
+
+        REQUIRE(get_trip_count(node_kind::LESS, 0, 10, 3) == 4);
+        REQUIRE(get_trip_count(node_kind::LESS_OR_EQUAL, 0, 9, 3) == 4);
+        REQUIRE(get_trip_count(node_kind::BIGGER, 10, 0, -3) == 4);
+        REQUIRE(get_trip_count(node_kind::LESS, 10, 0, 1) == 0);
+
+        // Never ends, or counter overflows first:
+        REQUIRE(get_trip_count(node_kind::LESS, 0, 10, -1) == std::nullopt);
+        REQUIRE(get_trip_count(node_kind::LESS, max - 3, max, 5) == std::nullopt);
+    }
+}
@@ -0,0 +1,102 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/licm.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool hoist) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (hoist)
+            paracl::hoist_loop_invariants(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("hoist loop invariants") {
+    using namespace paracl;
+
+    SECTION("invariant expressions leave the loop") {
+        std::string input = R"(
+            a = 3;
+            b = 4;
+            i = 0;
+            s = 0;
+            while (i < a * b) {
+                s += i * (a + b) - (a + b);
+                i += 1;
+            }
+            print(s);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(hoist_loop_invariants(ast) == 2);
+        REQUIRE(dump(ast) == "main( = (a 3) = (b 4) = (i 0) = (s 0) = ($licm0 * (a b)) = ($licm1 + (a b)) "
+                             "while ((&lt; (i $licm0)) (+= (s - (* (i $licm1) $licm1))) (+= (i 1))) print( s ) )");
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("nested loops") {
+        std::string input = R"(
+            n = 4;
+            k = 2;
+            i = 0;
+            while (i < n) {
+                j = 0;
+                while (j < n) {
+                    print(i * j + k * n + i * k);
+                    j += 1;
+                }
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        // k * n leaves both loops, i * k leaves only the inner one:
+        REQUIRE(hoist_loop_invariants(ast) == 2);
+        REQUIRE(ast.get_scope()[3]->get_kind() == node_kind::ASSIGN);
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("input and failing division stay in the loop") {
+        std::string input = R"(
+            a = 0;
+            i = 0;
+            while (i < 3) {
+                if (a) {
+                    x = 10 / a;
+                }
+                y = ? + 1;
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(hoist_loop_invariants(ast) == 0);
+    }
+
+    SECTION("division in condition is evaluated first anyway") {
+        std::string input = R"(
+            d = 2;
+            i = 0;
+            while (i < 10 / d) {
+                print(i / 3);
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(hoist_loop_invariants(ast) == 1);
+        REQUIRE(run(input, true) == run(input, false));
+    }
+}
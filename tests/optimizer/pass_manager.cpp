@@ -0,0 +1,146 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/pass_manager.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <stdexcept>
+
+
+namespace {
+
+std::string run(std::string input, std::string_view pipeline) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        paracl::pass_manager::parse(pipeline)->run(ast);
+    });
+}
+
+std::vector<std::string> get_names(const paracl::pass_manager &manager) {
+    std::vector<std::string> names;
+    for (const paracl::optimization_pass &pass: manager.get_passes())
+        names.push_back(pass.name);
+
+    return names;
+}
+
+// Makes the first assignment write to a slot that doesn't exist
+size_t break_first_assignment(paracl::ast &tree, paracl::optimization_remarks*) {
+    auto &assignment = static_cast<paracl::binary_node&>(*tree.get_scope().front());
+    static_cast<paracl::id_node&>(*assignment.get_left()).set_slot(1000);
+    return 1;
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("pass manager") {
+    using namespace paracl;
+
+    SECTION("default pipeline") {
+        pass_manager manager(get_default_passes());
+
+        REQUIRE(get_names(manager) == std::vector<std::string> {
+            "propagation", "folding", "licm", "dead-stores", "slots",
+            "induction", "ranges", "unrolling", "cse", "fusion"
+        });
+    }
+
+    SECTION("pipeline from names and aliases") {
+        std::optional<pass_manager> manager = pass_manager::parse("fold,dce,licm,folding");
+
+        REQUIRE(manager);
+        REQUIRE(get_names(*manager) == std::vector<std::string> { "folding", "dead-stores", "licm", "folding" });
+
+        REQUIRE(pass_manager::parse("")->get_passes().empty());
+        REQUIRE(!pass_manager::parse("fold,inline"));
+        REQUIRE(!pass_manager::parse("fold,,dce"));
+    }
+
+    SECTION("nothing runs after fusion") {
+        REQUIRE(pass_manager::parse("dce,fusion"));
+        REQUIRE(!pass_manager::parse("fusion,dce"));
+        REQUIRE(!pass_manager::parse("fusion,fusion"));
+    }
+
+    SECTION("only passes that handle closed forms run after induction") {
+        REQUIRE(pass_manager::parse("dce,fold,licm,induction,propagation,slots,ranges,unroll,cse,fusion"));
+        REQUIRE(!pass_manager::parse("induction,dead-stores"));
+        REQUIRE(!pass_manager::parse("induction,ranges,fold"));
+        REQUIRE(!pass_manager::parse("induction,licm"));
+    }
+
+    SECTION("statistics") {
+        std::string input = R"(
+            x = 2 * 3 + 4;
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(count_nodes(ast) == 9);
+
+        pass_manager manager = *pass_manager::parse("propagation,fold");
+        manager.run(ast);
+
+        const std::vector<pass_statistics> &statistics = manager.get_statistics();
+        REQUIRE(statistics.size() == 2);
+
+        REQUIRE(statistics[0].changes == 1);
+        REQUIRE(statistics[0].nodes_before == 9);
+        REQUIRE(statistics[0].nodes_after == 9);
+
+        REQUIRE(statistics[1].changes > 0);
+        REQUIRE(statistics[1].nodes_before == 9);
+        REQUIRE(statistics[1].nodes_after == 5);
+    }
+
+    SECTION("broken tree is reported") {
+        std::string input = R"(
+            x = 1;
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(!verify_tree(ast));
+
+        pass_manager manager;
+        manager.add_pass({ "broken", nullptr, break_first_assignment });
+        manager.set_verification(true);
+
+        REQUIRE_THROWS_AS(manager.run(ast), std::logic_error);
+        REQUIRE(verify_tree(ast));
+    }
+
+    SECTION("dead scans are valid statements") {
+        std::string input = R"(
+            x = ?;
+            print(1);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        pass_manager manager(get_default_passes());
+        manager.set_verification(true);
+
+        REQUIRE_NOTHROW(manager.run(ast));
+        REQUIRE(!verify_tree(ast));
+    }
+
+    SECTION("same output") {
+        std::string input = R"(
+            n = 10;
+            i = 0;
+            sum = 0;
+            while (i < n) {
+                sum += i * i + 2 * 3;
+                i += 1;
+            }
+            print(sum);
+        )";
+
+        REQUIRE(run(input, "propagation,folding,licm,dead-stores,induction,ranges,unrolling,cse,fusion") == "345\n");
+        REQUIRE(run(input, "unroll,fold,cse") == "345\n");
+        REQUIRE(run(input, "") == "345\n");
+    }
+}
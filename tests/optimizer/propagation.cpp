@@ -0,0 +1,129 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/propagation.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool propagate) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (propagate)
+            paracl::propagate_constants(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("propagate constants") {
+    using namespace paracl;
+
+    SECTION("known values replace reads") {
+        std::string input = R"(
+            max_border = 1000;
+            step = 2;
+            x = max_border / step;
+            x += 1;
+            print(x * step);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(propagate_constants(ast) == 5);
+        REQUIRE(dump(ast) == "main( = (max_border 1000) = (step 2) = (x / (1000 2)) = (x 501) print( * (501 2) ) )");
+        REQUIRE(run(input, true) == "1002\n");
+    }
+
+    SECTION("branches with known conditions") {
+        std::string input = R"(
+            debug = 0;
+            x = 5;
+            if (debug) {
+                print(x);
+            }
+            if (debug == 0) {
+                x = 7;
+            }
+            while (debug) {
+                x = 0;
+            }
+            print(x);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(propagate_constants(ast) == 1);
+        REQUIRE(dump(ast) == "main( = (debug 0) = (x 5) = (x 7) print( 7 ) )");
+        REQUIRE(run(input, true) == "7\n");
+    }
+
+    SECTION("values that differ between paths are unknown") {
+        std::string input = R"(
+            n = 10;
+            a = ?;
+            k = 3;
+            if (a) {
+                k = 4;
+            }
+            i = 0;
+            while (i < n) {
+                i += 1;
+            }
+            print(i + k + n);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        // Only n is known after the loop, and it's read twice:
+        REQUIRE(propagate_constants(ast) == 2);
+        REQUIRE(dump(ast) == "main( = (n 10) = (a scan) = (k 3) if ((a) (= (k 4))) = (i 0) "
+                             "while ((&lt; (i 10)) (+= (i 1))) print( + (+ (i k) 10) ) )");
+    }
+
+    SECTION("copies are forwarded until either variable changes") {
+        std::string input = R"(
+            fn_1 = ?;
+            fn_2 = fn_1;
+            x = fn_2 * 2;
+            fn_1 += 1;
+            y = fn_2 * 3;
+            print(x + y);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(propagate_constants(ast) == 1);
+        REQUIRE(dump(ast) == "main( = (fn_1 scan) = (fn_2 fn_1) = (x * (fn_1 2)) += (fn_1 1) "
+                             "= (y * (fn_2 3)) print( + (x y) ) )");
+    }
+
+    SECTION("same output") {
+        std::string input = R"(
+            max_border = 8;
+            cur_it     = 1;
+
+            fn   = 0;
+            fn_2 = 0;
+            fn_1 = 1;
+
+            while (cur_it < max_border) {
+                fn = fn_1 + fn_2;
+                fn_2 = fn_1;
+                fn_1 = fn;
+                cur_it += 1;
+                if (fn_2 > 100) {
+                    print(fn_2);
+                }
+            }
+
+            print(fn);
+        )";
+
+        REQUIRE(run(input, true) == run(input, false));
+        REQUIRE(run(input, true) == "21\n");
+    }
+}
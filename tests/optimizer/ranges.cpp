@@ -0,0 +1,138 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/closures.h"
+#include "paracl/optimizer/ranges.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <stdexcept>
+
+
+namespace {
+
+std::string run(std::string input, bool remove) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (remove)
+            paracl::remove_divisor_checks(ast);
+    });
+}
+
+size_t count_removed(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    return paracl::remove_divisor_checks(ast);
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("remove divisor checks") {
+    using namespace paracl;
+
+    SECTION("constant divisors") {
+        REQUIRE(count_removed(R"(
+            x = ?;
+            print(x / 3);
+            x /= -2;
+            print(x / 0);
+        )") == 2);
+    }
+
+    SECTION("loop counter that starts at 1") {
+        std::string input = R"(
+            n = 10;
+            s = 0;
+            i = 1;
+            while (i <= n) {
+                s += 2520 / i;
+                i += 1;
+            }
+            print(s);
+        )";
+
+        REQUIRE(count_removed(input) == 1);
+        REQUIRE(run(input, true) == run(input, false));
+        REQUIRE(run(input, true) == "7381\n");
+    }
+
+    SECTION("conditions narrow ranges") {
+        REQUIRE(count_removed(R"(
+            d = ?;
+            if (d > 0) {
+                print(100 / d);
+            }
+            if (0 > d) {
+                print(100 / d);
+            }
+            if (d == 5) {
+                print(100 / (d - 4));
+            }
+        )") == 3);
+
+        // Only after the first if, d can be anything:
+        REQUIRE(count_removed(R"(
+            d = ?;
+            if (d > 0) {
+                d = 0;
+            }
+            print(100 / d);
+            if (d > -10) {
+                print(100 / (d - 10));
+            }
+        )") == 1);
+    }
+
+    SECTION("divisors that can be zero keep their checks") {
+        REQUIRE(count_removed(R"(
+            d = ?;
+            print(100 / d);
+        )") == 0);
+
+        REQUIRE(count_removed(R"(
+            i = 0;
+            s = 0;
+            while (i < 10) {
+                s += 100 / (i - 5);
+                i += 1;
+            }
+        )") == 0);
+
+        // Counter wraps around, if it grows for too long:
+        REQUIRE(count_removed(R"(
+            i = 1;
+            s = 0;
+            while (s < 10) {
+                s += 100 / i;
+                i += 1;
+            }
+        )") == 0);
+
+        std::string input = R"(
+            i = 5;
+            while (i > -5) {
+                print(100 / i);
+                i -= 1;
+            }
+        )";
+
+        REQUIRE(count_removed(input) == 0);
+        REQUIRE_THROWS_AS(run(input, true), std::runtime_error);
+    }
+
+    SECTION("unchecked divisions in every engine") {
+        std::string input = R"(
+            s = 0;
+            i = 3;
+            while (i < 1000) {
+                s += (s + 1000000) / i;
+                i *= 2;
+            }
+            print(s);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE(remove_divisor_checks(ast) == 1);
+
+        std::string output = paracl::testing::capture_output(compile_scope(ast.get_scope(), ast.get_context()));
+        REQUIRE(output == run(input, false));
+    }
+}
@@ -0,0 +1,164 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/licm.h"
+#include "paracl/optimizer/ranges.h"
+#include "paracl/optimizer/remarks.h"
+#include "paracl/optimizer/unrolling.h"
+#include "catch2/catch2.h"
+
+#include <cstdio>
+#include <sstream>
+
+
+namespace {
+
+// Every remark as "line:column kind pass: message"
+std::vector<std::string> describe(const paracl::optimization_remarks &remarks) {
+    std::vector<std::string> descriptions;
+    for (const paracl::remark &current: remarks.get_remarks()) {
+        std::stringstream description;
+        if (current.range)
+            description << current.range->begin.line << ":" << current.range->begin.column + 1 << " ";
+
+        description << (current.kind == paracl::remark_kind::PASSED ? "passed " : "missed ")
+                    << current.pass << ": " << current.message;
+        descriptions.push_back(description.str());
+    }
+
+    return descriptions;
+}
+
+std::string get_source(std::string text, const paracl::node &tree) {
+    const paracl::text_range &range = *tree.get_range();
+    return text.substr(range.begin.point, range.end.point - range.begin.point);
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("optimization remarks") {
+    using namespace paracl;
+
+    SECTION("nodes keep their source") {
+        std::string input = "x = -?;\nwhile (x < (3 + x) * 2) {\n    print(x / 2);\n}\n";
+        paracl::ast ast(paracl::tokenize(input));
+
+        const auto &assignment = static_cast<const binary_node&>(*ast.get_scope()[0]);
+        REQUIRE(get_source(input, assignment) == "x = -?");
+        REQUIRE(get_source(input, assignment.get_right()) == "-?");
+
+        const auto &loop = static_cast<const while_node&>(*ast.get_scope()[1]);
+        REQUIRE(get_source(input, loop) == "while (x < (3 + x) * 2)");
+        REQUIRE(get_source(input, loop.get_condition()) == "x < (3 + x) * 2");
+
+        const auto &bound = static_cast<const binary_node&>(loop.get_condition()).get_right();
+        REQUIRE(get_source(input, bound) == "(3 + x) * 2");
+        REQUIRE(get_source(input, static_cast<const binary_node&>(bound).get_left()) == "(3 + x)");
+
+        REQUIRE(get_source(input, *loop.get_scope()[0]) == "print(x / 2)");
+        REQUIRE(loop.get_scope()[0]->get_range()->begin.line == 3);
+    }
+
+    SECTION("hoisted and blocked expressions") {
+        std::string input =
+            "n = ?;\n"
+            "i = 0;\n"
+            "while (i < n) {\n"
+            "    print(n * 2 + ?);\n"
+            "    print(i / n);\n"
+            "    i += 1;\n"
+            "}\n";
+
+        paracl::ast ast(paracl::tokenize(input));
+        optimization_remarks remarks;
+
+        REQUIRE(hoist_loop_invariants(ast, &remarks) == 1);
+        REQUIRE(describe(remarks) == std::vector<std::string> {
+            "4:11 missed licm: scan inside loop body prevents hoisting this invariant expression",
+            "4:11 passed licm: invariant expression is hoisted out of the loop",
+        });
+    }
+
+    SECTION("why loops aren't unrolled") {
+        std::string input =
+            "n = ?;\n"
+            "i = 0;\n"
+            "while (i < n) { n -= 1; i += 1; }\n"
+            "while (i > 0) { i += 1; }\n"
+            "while (i < n) { i += 1; print(i); }\n"
+            "while (i) { i -= 1; }\n";
+
+        paracl::ast ast(paracl::tokenize(input));
+        optimization_remarks remarks;
+
+        REQUIRE(unroll_loops(ast, &remarks) == 1);
+        REQUIRE(describe(remarks) == std::vector<std::string> {
+            "3:1 missed unrolling: loop bound changes inside the loop",
+            "4:1 missed unrolling: counter moves away from the bound",
+            "5:1 passed unrolling: loop is unrolled by a factor of 4",
+            "6:1 missed unrolling: loop condition doesn't compare a counter with a bound",
+        });
+    }
+
+    SECTION("division checks") {
+        std::string input =
+            "x = ?;\n"
+            "if (x > 0) {\n"
+            "    print(100 / x);\n"
+            "}\n"
+            "if (x < 5) {\n"
+            "    print(100 / x);\n"
+            "}\n";
+
+        paracl::ast ast(paracl::tokenize(input));
+        optimization_remarks remarks;
+
+        REQUIRE(remove_divisor_checks(ast, &remarks) == 1);
+        REQUIRE(describe(remarks) == std::vector<std::string> {
+            "3:11 passed ranges: divisor is never zero here, its check is removed",
+            "6:11 missed ranges: divisor is in [-9223372036854775808, 4], so it's checked for zero",
+        });
+    }
+
+    SECTION("machine readable form") {
+        std::string input = "i = 0;\nwhile (i < 8) {\n  i += 1;\n}\n";
+
+        optimization_remarks remarks;
+
+        paracl::ast ast(paracl::tokenize(input));
+        const node &loop = *ast.get_scope()[1];
+
+        remarks.passed("unrolling", loop, "message with \"quotes\"");
+        remarks.missed("licm", *ast.get_scope()[0], "second");
+
+        std::stringstream json;
+        remarks.dump_json(json);
+
+        REQUIRE(json.str() ==
+            "[\n"
+            "  { \"kind\": \"passed\", \"pass\": \"unrolling\", \"message\": \"message with \\\"quotes\\\"\", "
+                "\"begin\": { \"line\": 2, \"column\": 1 }, \"end\": { \"line\": 2, \"column\": 14 } },\n"
+            "  { \"kind\": \"missed\", \"pass\": \"licm\", \"message\": \"second\", "
+                "\"begin\": { \"line\": 1, \"column\": 1 }, \"end\": { \"line\": 1, \"column\": 6 } }\n"
+            "]\n");
+    }
+
+    SECTION("annotated source") {
+        paracl::file source{"loop.pcl", "i = 0;\nwhile (i < 8) {\n    i += 1;\n}\n"};
+        paracl::ast ast(paracl::tokenize(source.text));
+
+        optimization_remarks remarks;
+        unroll_loops(ast, &remarks);
+
+        std::FILE *stream = std::tmpfile();
+        remarks.print(source, stream);
+
+        std::string output(std::ftell(stream), '\0');
+        std::rewind(stream);
+        REQUIRE(std::fread(output.data(), 1, output.size(), stream) == output.size());
+        std::fclose(stream);
+
+        REQUIRE(output.starts_with("loop.pcl:2:1: remark: loop is unrolled by a factor of 4 [passed unrolling]\n"));
+        REQUIRE(output.find("while (i < 8) {") != std::string::npos);
+    }
+}
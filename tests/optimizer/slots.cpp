@@ -0,0 +1,133 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/slots.h"
+#include "paracl/optimizer/fusion.h"
+#include "paracl/optimizer/pass_manager.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+std::string run(std::string input, bool share) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (share)
+            paracl::share_variable_slots(ast);
+    });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("share variable slots") {
+    using namespace paracl;
+
+    SECTION("variables with disjoint lifetimes share slots") {
+        std::string input = R"(
+            a = 3;
+            b = a * 2;
+            c = b + 1;
+            print(c);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(share_variable_slots(ast) == 1);
+        REQUIRE(!verify_tree(ast));
+
+        context &ctx = ast.get_context();
+        REQUIRE(ctx.get_variable_count() == 2);
+        REQUIRE(ctx.find_variable("a") == 0);
+        REQUIRE(ctx.find_variable("b") == 1);
+        REQUIRE(ctx.find_variable("c") == 0);
+        REQUIRE(ctx.get_name(0) == "a");
+        REQUIRE(ctx.has_name(0, "c"));
+
+        REQUIRE(run(input, true) == "7\n");
+    }
+
+    SECTION("locals of sibling blocks share slots") {
+        std::string input = R"(
+            i = 0;
+            while (i < 3) {
+                t = i * i;
+                print(t);
+                i += 1;
+            }
+
+            j = 0;
+            while (j < 3) {
+                u = j + 1;
+                print(u);
+                j += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(share_variable_slots(ast) == 2);
+        REQUIRE(ast.get_context().get_variable_count() == 2);
+        REQUIRE(!verify_tree(ast));
+
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("values carried between iterations keep their slots") {
+        std::string input = R"(
+            i = 0;
+            s = 1;
+            while (i < 4) {
+                t = s + i;
+                if (t > 3) {
+                    d = t - 3;
+                    s = d * 2;
+                }
+                s += t;
+                i += 1;
+            }
+            print(s);
+        )";
+
+        REQUIRE(run(input, true) == run(input, false));
+    }
+
+    SECTION("dead stores still overwrite their slots") {
+        std::string input = R"(
+            a = 1;
+            b = 2;
+            print(a);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(share_variable_slots(ast) == 0);
+        REQUIRE(run(input, true) == "1\n");
+    }
+
+    SECTION("variables read before they are written keep their own slots") {
+        std::string input = R"(
+            print(x);
+            print(y);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(share_variable_slots(ast) == 0);
+        REQUIRE(ast.get_context().get_variable_count() == 2);
+    }
+
+    SECTION("trees with replacement nodes are left as they are") {
+        std::string input = R"(
+            a = 3;
+            b = a * 2;
+            c = b + 1;
+            print(c);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        REQUIRE(fuse_superinstructions(ast) > 0);
+
+        REQUIRE(share_variable_slots(ast) == 0);
+        REQUIRE(ast.get_context().get_variable_count() == 3);
+    }
+}
@@ -0,0 +1,149 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/pass_manager.h"
+#include "paracl/optimizer/specialization.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <sstream>
+#include <vector>
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(paracl::ast &ast, std::string input) {
+    std::stringstream values(input);
+    paracl::testing::scoped_rdbuf redirect(std::cin, values.rdbuf());
+
+    return paracl::testing::capture_output([&] { ast.run(); });
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("specialize program for known input") {
+    using namespace paracl;
+
+    SECTION("configuration decides control flow") {
+        std::string input = R"(
+            n = ?;
+            debug = ?;
+            s = 0;
+            i = 0;
+            while (i < n) {
+                s += i;
+                i += 1;
+            }
+            if (debug) {
+                print(n);
+            }
+            print(s * ?);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        std::vector<int64_t> known = { 10, 0 };
+
+        REQUIRE(specialize_input(ast, known) == 2);
+        REQUIRE(dump(ast) == "main( = (n 10) = (debug 0) = (s 0) = (i 0) "
+                             "while ((&lt; (i 10)) (+= (s i)) (+= (i 1))) print( * (s scan) ) )");
+        REQUIRE(run(ast, "2") == "Input: 90\n");
+    }
+
+    SECTION("reads after decided branches become known") {
+        std::string input = R"(
+            mode = ?;
+            x = 0;
+            if (mode == 1) {
+                x = ?;
+            }
+            y = ?;
+            print(x + y);
+        )";
+
+        paracl::ast first(paracl::tokenize(input));
+        std::vector<int64_t> with_branch = { 1, 5, 7 };
+
+        REQUIRE(specialize_input(first, with_branch) == 3);
+        REQUIRE(run(first, "") == "12\n");
+
+        paracl::ast second(paracl::tokenize(input));
+        std::vector<int64_t> without_branch = { 2, 5, 7 };
+
+        // Branch isn't taken, so only two values are read:
+        REQUIRE(specialize_input(second, without_branch) == 2);
+        REQUIRE(run(second, "") == "5\n");
+    }
+
+    SECTION("reads in loops stay") {
+        std::string input = R"(
+            n = ?;
+            s = 0;
+            while (n > 0) {
+                s += ?;
+                n -= 1;
+            }
+            print(s + ?);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        std::vector<int64_t> known = { 2, 10, 20, 30 };
+
+        REQUIRE(specialize_input(ast, known) == 1);
+        REQUIRE(run(ast, "10 20 30") == "Input: Input: Input: 60\n");
+    }
+
+    SECTION("same output as with the whole input") {
+        std::string input = R"(
+            a = ?;
+            b = ?;
+            if (a < b) {
+                t = a;
+                a = b;
+                b = t;
+            }
+            while (b > 0) {
+                t = a - a / b * b;
+                a = b;
+                b = t;
+            }
+            print(a * ?);
+        )";
+
+        paracl::ast original(paracl::tokenize(input));
+        std::string expected = run(original, "84 120 3");
+
+        paracl::ast specialized(paracl::tokenize(input));
+        std::vector<int64_t> known = { 84, 120 };
+
+        REQUIRE(specialize_input(specialized, known) == 2);
+        REQUIRE("Input: Input: " + run(specialized, "3") == expected);
+
+        // Saved program runs the same:
+        std::stringstream source;
+        specialized.dump_source(source);
+
+        std::string text = source.str();
+        paracl::ast reparsed(paracl::tokenize(text));
+        REQUIRE("Input: Input: " + run(reparsed, "3") == expected);
+    }
+
+    SECTION("saved program still reads input of dead stores") {
+        std::string input = R"(
+            n = ?;
+            print(1);
+        )";
+
+        paracl::ast optimized(paracl::tokenize(input));
+        pass_manager(get_default_passes()).run(optimized);
+
+        std::stringstream source;
+        optimized.dump_source(source);
+        REQUIRE(source.str() == "unused = ?;\nprint(1);\n");
+
+        std::string text = source.str();
+        paracl::ast reparsed(paracl::tokenize(text));
+        REQUIRE(run(reparsed, "5") == "Input: 1\n");
+    }
+}
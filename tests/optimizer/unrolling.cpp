@@ -0,0 +1,169 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/optimizer/unrolling.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+
+namespace {
+
+using paracl::testing::dump;
+
+std::string run(std::string input, bool unroll) {
+    return paracl::testing::run_tree(input, [&](paracl::ast &ast) {
+        if (unroll)
+            paracl::unroll_loops(ast);
+    });
+}
+
+size_t count_unrolled(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    return paracl::unroll_loops(ast);
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("unroll counting loops") {
+    using namespace paracl;
+
+    SECTION("constant bound") {
+        std::string input = R"(
+            i = 0;
+            s = 0;
+            while (i < 10) {
+                s = s + i * i;
+                i += 1;
+            }
+            print(s);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(unroll_loops(ast, 2) == 1);
+        REQUIRE(dump(ast) == "main( = (i 0) = (s 0) "
+                             "while ((&lt; (i 9)) (= (s + (s * (i i)))) (+= (i 1)) (= (s + (s * (i i)))) (+= (i 1))) "
+                             "while ((&lt; (i 10)) (= (s + (s * (i i)))) (+= (i 1))) print( s ) )");
+        REQUIRE(run(input, true) == "285\n");
+    }
+
+    SECTION("variable bound is checked for overflow") {
+        std::string input = R"(
+            n = 10;
+            i = 0;
+            while (i < n) {
+                print(i);
+                i += 3;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+
+        REQUIRE(unroll_loops(ast, 2) == 1);
+        REQUIRE(dump(ast) == "main( = (n 10) = (i 0) "
+                             "if ((&ge; (n -9223372036854775805)) (while ((&lt; (i - (n 3))) "
+                             "(print( i )) (+= (i 3)) (print( i )) (+= (i 3))))) "
+                             "while ((&lt; (i n)) (print( i )) (+= (i 3))) )");
+        REQUIRE(run(input, true) == "0\n3\n6\n9\n");
+    }
+
+    SECTION("factor depends on body size") {
+        std::string small = R"(
+            i = 0;
+            while (i < 100) {
+                i += 1;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(small));
+
+        REQUIRE(unroll_loops(ast) == 1);
+        REQUIRE(dump(ast) == "main( = (i 0) while ((&lt; (i 97)) (+= (i 1)) (+= (i 1)) (+= (i 1)) (+= (i 1))) "
+                             "while ((&lt; (i 100)) (+= (i 1))) )");
+
+        std::string large = R"(
+            i = 0;
+            s = 0;
+            while (i < 100) {
+                s = s + (i * i * i * i * i * i * i + i * i * i * i * i * i * i) * (i * i * i * i * i * i * i + 1);
+                if (s > 1000) {
+                    s = s - (i * i * i * i * i * i * i + i * i * i * i * i * i * i) / 7;
+                }
+                i += 1;
+            }
+        )";
+
+        REQUIRE(count_unrolled(large) == 0);
+    }
+
+    SECTION("loops that can't be unrolled") {
+        // Counter changes somewhere else:
+        REQUIRE(count_unrolled(R"(
+            i = 0;
+            while (i < 100) {
+                if (i == 5) {
+                    i += 2;
+                }
+                i += 1;
+            }
+        )") == 0);
+
+        // Bound changes:
+        REQUIRE(count_unrolled(R"(
+            i = 0;
+            n = 100;
+            while (i < n) {
+                n -= 1;
+                i += 1;
+            }
+        )") == 0);
+
+        // Counter moves away from the bound:
+        REQUIRE(count_unrolled(R"(
+            i = 0;
+            while (i < 100) {
+                i -= 1;
+            }
+        )") == 0);
+
+        // Moved bound would overflow:
+        REQUIRE(count_unrolled(R"(
+            i = 9223372036854775807;
+            while (i > 9223372036854775805) {
+                i -= 1;
+            }
+        )") == 0);
+
+        // Only inner loop is unrolled:
+        REQUIRE(count_unrolled(R"(
+            i = 0;
+            while (i < 10) {
+                j = 0;
+                while (j < 10) {
+                    j += 1;
+                }
+                i += 1;
+            }
+        )") == 1);
+    }
+
+    SECTION("same output") {
+        for (int n: { -5, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 }) {
+            std::string input = "n = " + std::to_string(n) + ";" + R"(
+                i = 20;
+                s = 0;
+                while (i >= n) {
+                    s = s * 3 + i;
+                    if (s > 1000) {
+                        s = s / 7;
+                    }
+                    i -= 3;
+                }
+                print(s);
+                print(i);
+            )";
+
+            REQUIRE(run(input, true) == run(input, false));
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/flat.h"
+#include "catch2/catch2.h"
+#include "common/capture.h"
+
+#include <sstream>
+#include <stdexcept>
+
+
+namespace {
+
+using paracl::testing::run_tree;
+
+std::string run_flat(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::flat_ast flat(ast.get_scope(), ast.get_context());
+
+    return paracl::testing::capture_output([&] { flat.run(ast.get_context()); });
+}
+
+// Dumps of pointer and flat trees, they have to match
+std::pair<std::string, std::string> dump_both(std::string input, bool graph) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::flat_ast flat(ast.get_scope(), ast.get_context());
+
+    std::ostringstream tree, flattened;
+    if (graph) {
+        ast.dump_gv(tree);
+        flat.dump_gv(flattened);
+    } else {
+        ast.dump(tree);
+        flat.dump(flattened);
+    }
+
+    return { tree.str(), flattened.str() };
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("flat ast") {
+    using namespace paracl;
+
+    std::string program = R"(
+        n = 10;
+        i = 0;
+        s = -1;
+        while (i < n) {
+            if (i / 3 * 3 == i) {
+                s += i * i - -2;
+            }
+            s -= 1;
+            s *= 2;
+            s /= 3;
+            print(s);
+            print((i >= 5) + (i <= 5) * 2 + (i > 5) * 4);
+            i += 1;
+        }
+        print(s + 4000000000 * 3);
+    )";
+
+    SECTION("same dump as pointer tree") {
+        auto [tree, flattened] = dump_both(program, false);
+        REQUIRE(flattened == tree);
+
+        auto [tree_graph, flattened_graph] = dump_both(program, true);
+        REQUIRE(flattened_graph == tree_graph);
+    }
+
+    SECTION("same output as pointer tree") {
+        REQUIRE(run_flat(program) == run_tree(program));
+    }
+
+    SECTION("children are indices into arrays") {
+        std::string input = "x = 1 + 2; print(x);";
+        paracl::ast ast(tokenize(input));
+        flat_ast flat(ast.get_scope(), ast.get_context());
+
+        // =, +, 1, 2, print, x
+        REQUIRE(flat.get_node_count() == 6);
+
+        flat_ast::index program = flat.get_program();
+        REQUIRE(flat.get_list_size(program) == 2);
+
+        flat_ast::index assignment = flat.get_list(program)[0];
+        REQUIRE(flat.get_kind(assignment) == flat_ast::kind::ASSIGN);
+        REQUIRE(flat.get_first(assignment) == *ast.get_context().find_variable("x"));
+
+        flat_ast::index sum = flat.get_second(assignment);
+        REQUIRE(flat.get_kind(sum) == flat_ast::kind::PLUS);
+        REQUIRE(flat.get_number(flat.get_first(sum)) == 1);
+        REQUIRE(flat.get_number(flat.get_second(sum)) == 2);
+    }
+
+    SECTION("negative and wide numbers") {
+        std::string input = "x = 0 - 1; y = 9000000000000;";
+        paracl::ast ast(tokenize(input));
+        flat_ast flat(ast.get_scope(), ast.get_context());
+
+        flat.run(ast.get_context());
+        REQUIRE(*ast.get_context().get_variable(0) == -1);
+        REQUIRE(*ast.get_context().get_variable(1) == 9000000000000);
+    }
+
+    SECTION("division by zero") {
+        REQUIRE_THROWS_AS(run_flat("x = 0; print(1 / x);"), std::runtime_error);
+        REQUIRE_THROWS_AS(run_flat("x = 0; y = 1; y /= x;"), std::runtime_error);
+    }
+
+    SECTION("unchecked divisions keep their kind") {
+        std::string input = "x = 7; y = x / 2;";
+        paracl::ast ast(tokenize(input));
+
+        auto &assignment = static_cast<binary_node&>(*ast.get_scope()[1]);
+        static_cast<divide_node&>(*assignment.get_right()).set_divisor_checked(false);
+
+        flat_ast flat(ast.get_scope(), ast.get_context());
+
+        flat_ast::index division = flat.get_second(flat.get_list(flat.get_program())[1]);
+        REQUIRE(flat.get_kind(division) == flat_ast::kind::DIVIDE_UNCHECKED);
+
+        flat.run(ast.get_context());
+        REQUIRE(*ast.get_context().get_variable(1) == 3);
+    }
+}
@@ -0,0 +1,169 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/input.h"
+#include "paracl/text/file.h"
+#include "catch2/catch2.h"
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+
+TEST_CASE("input source") {
+    using namespace paracl;
+
+    SECTION("numbers in memory") {
+        std::string text = " 0\t-42\n+7 \r\n000000000000000000000000012345 123456789012 "
+                           "9223372036854775807 -9223372036854775808";
+
+        input_source input;
+        input.read_from(text);
+
+        REQUIRE(input.read_number() == 0);
+        REQUIRE(input.read_number() == -42);
+        REQUIRE(input.read_number() == 7);
+        REQUIRE(input.read_number() == 12345);
+        REQUIRE(input.read_number() == 123456789012);
+        REQUIRE(input.read_number() == std::numeric_limits<int64_t>::max());
+        REQUIRE(input.read_number() == std::numeric_limits<int64_t>::min());
+        REQUIRE(input.get_offset() == text.size());
+
+        REQUIRE_THROWS_WITH(input.read_number(), "unexpected end of input at byte 96");
+    }
+
+    SECTION("errors report their offsets") {
+        auto read_second = [](std::string text) {
+            input_source input;
+            input.read_from(text);
+
+            input.read_number();
+            return input.read_number();
+        };
+
+        REQUIRE_THROWS_WITH(read_second("1 abc"), "malformed number at byte 2");
+        REQUIRE_THROWS_WITH(read_second("1  12x3"), "malformed number at byte 5");
+        REQUIRE_THROWS_WITH(read_second("1 12345678x"), "malformed number at byte 10");
+        REQUIRE_THROWS_WITH(read_second("1 -"), "malformed number at byte 3");
+        REQUIRE_THROWS_WITH(read_second("1 9223372036854775808"), "number out of range at byte 2");
+        REQUIRE_THROWS_WITH(read_second("1 -9223372036854775809"), "number out of range at byte 2");
+        REQUIRE_THROWS_WITH(read_second("1 100000000000000000000"), "number out of range at byte 2");
+        REQUIRE_THROWS_WITH(read_second("1 \n "), "unexpected end of input at byte 4");
+    }
+
+    SECTION("numbers across blocks of descriptor") {
+        std::FILE *file = std::tmpfile();
+        REQUIRE(file);
+
+        // Lengths vary, so numbers get split between blocks in different places:
+        int64_t expected = 0;
+        size_t count = 0;
+        for (int64_t value = 1; count < 50'000; value = value * 31 % 1'000'000'007, ++ count) {
+            int64_t number = (count % 2 ? -value : value) / static_cast<int64_t>(count % 7 + 1);
+            std::fprintf(file, "%lld%s", static_cast<long long>(number), count % 5 ? " " : "\n");
+            expected += number;
+        }
+
+        std::fflush(file);
+        std::rewind(file);
+
+        input_source input;
+        input.read_from(fileno(file));
+
+        int64_t sum = 0;
+        for (size_t i = 0; i < count; ++ i)
+            sum += input.read_number();
+
+        REQUIRE(sum == expected);
+        REQUIRE(input.get_offset() > input_source::buffer_size);
+        REQUIRE_THROWS_WITH(input.read_number(), "unexpected end of input at byte " +
+                                                 std::to_string(input.get_offset()));
+
+        std::fclose(file);
+    }
+
+#ifndef _WIN32
+    SECTION("input file that is a pipe is read from its descriptor") {
+        int ends[2];
+        REQUIRE(pipe(ends) == 0);
+        REQUIRE(write(ends[1], "1 2", 3) == 3);
+        close(ends[1]);
+
+        mapped_file file("/dev/fd/" + std::to_string(ends[0]));
+        close(ends[0]);
+        REQUIRE(file.get_descriptor() >= 0);
+
+        input_source input;
+        input.read_from(file.get_descriptor());
+
+        REQUIRE(input.read_number() == 1);
+        REQUIRE(input.read_number() == 2);
+    }
+#endif
+
+    SECTION("numbers given first are read before the target") {
+        std::string text = "3 4";
+        std::vector<int64_t> first = {1, 2};
+
+        input_source input;
+        input.read_from(text);
+        input.read_first(first);
+
+        REQUIRE(input.read_number() == 1);
+        REQUIRE(input.read_number() == 2);
+        REQUIRE(input.read_number() == 3);
+        REQUIRE(input.get_offset() == 1);
+
+        input.read_first(first);
+        input.read_from(text);
+        REQUIRE(input.read_number() == 3);
+    }
+
+    SECTION("stream is read up to the number") {
+        std::istringstream stream("  15 rest");
+
+        std::string prompts;
+        get_output().write_to(prompts);
+
+        input_source input;
+        input.read_from(stream, true);
+        REQUIRE(input.read_number() == 15);
+
+        get_output().flush();
+        get_output().write_to(std::cout);
+
+        REQUIRE(prompts == "Input: ");
+        REQUIRE(input.get_offset() == 4);
+
+        std::string rest;
+        std::getline(stream, rest);
+        REQUIRE(rest == " rest");
+    }
+
+    SECTION("programs scan from it") {
+        std::string input = R"(
+            sum = 0;
+            n = ?;
+            while (n > 0) {
+                sum += ?;
+                n -= 1;
+            }
+            print(sum);
+        )";
+
+        paracl::ast ast(tokenize(input));
+
+        std::string values = "3 10 -20 30000000000";
+        get_input().read_from(values);
+
+        std::string output;
+        get_output().write_to(output);
+
+        ast.run();
+        get_output().flush();
+
+        get_output().write_to(std::cout);
+        get_input().read_from(std::cin, true);
+
+        REQUIRE(output == "29999999990\n");
+    }
+}
@@ -0,0 +1,199 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ir/ir.h"
+#include "catch2/catch2.h"
+
+#include <algorithm>
+#include <sstream>
+
+
+namespace {
+
+std::string dump_ir(std::string input) {
+    paracl::ast ast(paracl::tokenize(input));
+    paracl::ir::function function = paracl::ir::build_ir(ast.get_scope(), ast.get_context());
+
+    std::ostringstream oss;
+    function.dump(oss);
+    return oss.str();
+}
+
+size_t count_phis(const paracl::ir::function &function) {
+    size_t phis = 0;
+    for (const auto &block: function.get_blocks()) {
+        for (const auto &value: block->get_instructions())
+            phis += value->get_opcode() == paracl::ir::opcode::PHI;
+    }
+
+    return phis;
+}
+
+} // end anonymous namespace
+
+
+TEST_CASE("build ssa form") {
+    using namespace paracl;
+
+    SECTION("no program") {
+        REQUIRE(dump_ir("") == "block0:\n    return\n");
+    }
+
+    SECTION("straight line code") {
+        std::string input = R"(
+            x = 2;
+            y = x * x;
+            x += y;
+        )";
+
+        REQUIRE(dump_ir(input) ==
+                "block0:\n"
+                "    %0 = constant 2\n"
+                "    %1 = multiply %0, %0\n"
+                "    %2 = add %0, %1\n"
+                "    store $0, %2 ; x\n"
+                "    store $1, %1 ; y\n"
+                "    return\n");
+    }
+
+    SECTION("loop and condition") {
+        std::string input = R"(
+            i = 0;
+            s = 0;
+            while (i < 10) {
+                if (i > 4) {
+                    s += i;
+                }
+                i += 1;
+            }
+            print(s);
+        )";
+
+        REQUIRE(dump_ir(input) ==
+                "block0:\n"
+                "    %0 = constant 1\n"
+                "    %1 = constant 4\n"
+                "    %2 = constant 10\n"
+                "    %3 = constant 0\n"
+                "    jump block1\n"
+                "block1: ; preds = block0, block4\n"
+                "    %4 = phi [%3, block0], [%10, block4]\n"
+                "    %5 = phi [%3, block0], [%9, block4]\n"
+                "    %6 = less %4, %2\n"
+                "    branch %6, block2, block5\n"
+                "block2: ; preds = block1\n"
+                "    %7 = bigger %4, %1\n"
+                "    branch %7, block3, block4\n"
+                "block3: ; preds = block2\n"
+                "    %8 = add %5, %4\n"
+                "    jump block4\n"
+                "block4: ; preds = block2, block3\n"
+                "    %9 = phi [%5, block2], [%8, block3]\n"
+                "    %10 = add %4, %0\n"
+                "    jump block1\n"
+                "block5: ; preds = block1\n"
+                "    print %5\n"
+                "    store $0, %4 ; i\n"
+                "    store $1, %5 ; s\n"
+                "    return\n");
+    }
+
+    SECTION("variables that loop doesn't change get no phis") {
+        std::string input = R"(
+            n = ?;
+            k = 3;
+            i = 0;
+            while (i < n) {
+                i += k;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        ir::function function = ir::build_ir(ast.get_scope(), ast.get_context());
+
+        REQUIRE(count_phis(function) == 1);
+    }
+
+    SECTION("copies of removed phis") {
+        std::string input = R"(
+            i = 0;
+            while (i < n) {
+                t = k;
+                i += 1;
+            }
+            j = 0;
+            while (j < n) {
+                j += 1;
+            }
+            print(t);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        ir::function function = ir::build_ir(ast.get_scope(), ast.get_context());
+
+        REQUIRE(count_phis(function) == 3);
+    }
+
+    SECTION("def-use chains") {
+        std::string input = R"(
+            a = ?;
+            b = a + a;
+            while (b > 0) {
+                if (b / 2 * 2 == b) {
+                    a = a * 3;
+                }
+                b -= 1;
+            }
+            print(a);
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        ir::function function = ir::build_ir(ast.get_scope(), ast.get_context());
+
+        for (const auto &block: function.get_blocks()) {
+            for (const auto &value: block->get_instructions()) {
+                for (ir::instruction *operand: value->get_operands()) {
+                    auto uses = std::count(value->get_operands().begin(), value->get_operands().end(), operand);
+                    auto users = std::count(operand->get_users().begin(), operand->get_users().end(), value.get());
+                    REQUIRE(uses == users);
+                }
+
+                for (ir::instruction *user: value->get_users()) {
+                    const auto &operands = user->get_operands();
+                    REQUIRE(std::find(operands.begin(), operands.end(), value.get()) != operands.end());
+                }
+
+                if (value->get_opcode() == ir::opcode::PHI)
+                    REQUIRE(value->get_operands().size() == block->get_predecessors().size());
+            }
+        }
+
+        // a + a is a single instruction that uses scanned value twice:
+        const auto &entry = function.get_entry()->get_instructions();
+        auto scan = std::find_if(entry.begin(), entry.end(), [](const auto &value) {
+            return value->get_opcode() == ir::opcode::SCAN;
+        });
+
+        REQUIRE(scan != entry.end());
+        REQUIRE((*scan)->get_users().size() == 3);
+    }
+
+    SECTION("graphviz dump") {
+        std::string input = R"(
+            x = 1;
+            if (x) {
+                x = 2;
+            }
+        )";
+
+        paracl::ast ast(paracl::tokenize(input));
+        ir::function function = ir::build_ir(ast.get_scope(), ast.get_context());
+
+        std::ostringstream oss;
+        function.dump_gv(oss);
+
+        REQUIRE(oss.str().starts_with("digraph"));
+        REQUIRE(oss.str().find("node0->node1") != std::string::npos);
+        REQUIRE(oss.str().find("node0->node2") != std::string::npos);
+        REQUIRE(oss.str().find("node1->node2") != std::string::npos);
+    }
+}
@@ -0,0 +1,116 @@
+#include "paracl/lexer/lexer.h"
+#include "paracl/ast/ast.h"
+#include "paracl/ast/output.h"
+#include "catch2/catch2.h"
+
+#include <limits>
+#include <sstream>
+
+#include <unistd.h>
+
+
+TEST_CASE("output sink") {
+    using namespace paracl;
+
+    SECTION("numbers are formatted in decimal") {
+        std::string buffer;
+        output_sink output;
+        output.write_to(buffer);
+
+        output.write_number(0);
+        output.put(' ');
+        output.write_number(-42);
+        output.put(' ');
+        output.write_number(std::numeric_limits<int64_t>::max());
+        output.put(' ');
+        output.write_number(std::numeric_limits<int64_t>::min());
+        output.end_line();
+
+        // Buffer target is only written when it's flushed:
+        REQUIRE(buffer.empty());
+
+        output.flush();
+        REQUIRE(buffer == "0 -42 9223372036854775807 -9223372036854775808\n");
+    }
+
+    SECTION("full buffer is flushed") {
+        std::string buffer;
+        output_sink output;
+        output.write_to(buffer);
+
+        size_t lines = output_sink::buffer_size / 4 + 1;
+        for (size_t i = 0; i < lines; ++ i) {
+            output.write_number(100);
+            output.end_line();
+        }
+
+        // Numbers are never split between flushes:
+        REQUIRE(!buffer.empty());
+        REQUIRE(buffer.size() <= output_sink::buffer_size);
+        REQUIRE(buffer.size() % 4 == 0);
+
+        output.flush();
+        REQUIRE(buffer.size() == lines * 4);
+    }
+
+    SECTION("lines and prompts are flushed by policy") {
+        std::ostringstream stream;
+        output_sink output;
+
+        output.write_to(stream, { .on_newline = false, .before_input = true });
+        output.write_number(1);
+        output.end_line();
+        REQUIRE(stream.str().empty());
+
+        output.prompt("Input: ");
+        REQUIRE(stream.str() == "1\nInput: ");
+
+        output.write_to(stream, { .on_newline = true, .before_input = false });
+        output.prompt("Input: ");
+        REQUIRE(stream.str() == "1\nInput: ");
+
+        output.end_line();
+        REQUIRE(stream.str() == "1\nInput: Input: \n");
+    }
+
+    SECTION("output to file descriptor") {
+        int pipe_ends[2];
+        REQUIRE(pipe(pipe_ends) == 0);
+
+        {
+            output_sink output;
+            output.write_to(pipe_ends[1], { .on_newline = false, .before_input = false });
+            output.write("answer ");
+            output.write_number(42);
+            output.end_line();
+
+            // Rest is flushed when sink is destroyed
+        }
+        close(pipe_ends[1]);
+
+        char text[32] = {};
+        REQUIRE(read(pipe_ends[0], text, sizeof(text)) == 10);
+        REQUIRE(std::string(text) == "answer 42\n");
+
+        close(pipe_ends[0]);
+    }
+
+    SECTION("programs print to it") {
+        std::string input = R"(
+            x = 7;
+            print(x);
+            print(-x * 3);
+        )";
+
+        paracl::ast ast(tokenize(input));
+
+        std::string buffer;
+        get_output().write_to(buffer);
+
+        ast.run();
+        get_output().flush();
+
+        get_output().write_to(std::cout);
+        REQUIRE(buffer == "7\n-21\n");
+    }
+}
@@ -164,4 +164,138 @@ TEST_CASE("parse tokens") {
 
         REQUIRE(oss.str() == "main( = (val 2) print( 1 ) print( val ) print( scan ) print( + (+ (val 1) scan) ) )");
     }
-}
\ No newline at end of file
+
+    SECTION("variables resolved to slots") {
+        std::string input = R"(
+            first  = 1;
+            second = first;
+            first  = second;
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
+        context &ctx = ast.get_context();
+
+        REQUIRE(ctx.get_variable_count() == 2);
+        REQUIRE(ctx.find_variable("first")  == 0);
+        REQUIRE(ctx.find_variable("second") == 1);
+        REQUIRE(ctx.get_name(1) == "second");
+        REQUIRE(!ctx.find_variable("third"));
+
+        const auto &last = static_cast<const binary_node&>(*ast.get_scope()[2]);
+        REQUIRE(static_cast<const id_node&>(last.get_left()).get_slot() == 0);
+        REQUIRE(static_cast<const id_node&>(last.get_right()).get_slot() == 1);
+    }
+
+    SECTION("variables scoped to blocks") {
+        std::string input = R"(
+            x = 1;
+            if (x) {
+                t = x;
+                x = t;
+            }
+            while (x < 5) {
+                t = x * 2;
+                x += t;
+            }
+            print(t);
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
+        context &ctx = ast.get_context();
+
+        // Both blocks have their own t, and t after them is another one:
+        REQUIRE(ctx.get_variable_count() == 4);
+        REQUIRE(ctx.find_variable("x") == 0);
+        REQUIRE(ctx.find_variable("t") == 3);
+        REQUIRE(ctx.get_name(1) == "t");
+        REQUIRE(ctx.get_name(2) == "t");
+
+        // Outer variables are visible in blocks:
+        const auto &loop = static_cast<const while_node&>(*ast.get_scope()[2]);
+        const auto &increment = static_cast<const binary_node&>(*loop.get_scope()[1]);
+        REQUIRE(static_cast<const id_node&>(increment.get_left()).get_slot() == 0);
+        REQUIRE(static_cast<const id_node&>(increment.get_right()).get_slot() == 2);
+    }
+
+    SECTION("nodes allocated in arena") {
+        std::string input = R"(
+            x = 1;
+            while (x < 10) {
+                print(x);
+                x *= 2;
+            }
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
+        size_t allocated = ast.get_arena().get_allocated();
+        REQUIRE(allocated > 0);
+
+        // Nodes made outside of arena come from heap, and can be mixed with parsed ones:
+        context &ctx = ast.get_context();
+        ast.get_scope().push_back(std::make_unique<id_node>("x", *ctx.find_variable("x")));
+        REQUIRE(ast.get_arena().get_allocated() == allocated);
+
+        {
+            arena::scope in_arena{ast.get_arena()};
+            ast.get_scope().push_back(std::make_unique<number_node>(42));
+        }
+        REQUIRE(ast.get_arena().get_allocated() > allocated);
+
+        // Parsed and created nodes are all freed with the tree:
+        ast.get_scope().erase(ast.get_scope().begin());
+
+        std::ostringstream oss;
+        ast.dump(oss);
+
+        REQUIRE(oss.str() == "main( while ((&lt; (x 10)) (print( x )) (*= (x 2))) x 42 )");
+    }
+
+    SECTION("dump as source") {
+        std::string input = R"(
+            n = ?;
+            x = -n * (2 - -3);
+            while (x < n / 2) {
+                x += 1;
+                if (x == 4) {
+                    print(x);
+                }
+            }
+        )";
+        auto tokens = tokenize(input);
+
+        paracl::ast ast(tokens);
+
+        // Temporaries that optimizations create have names that can't be written:
+        context &ctx = ast.get_context();
+        size_t temporary = ctx.create_variable("$t");
+        ast.get_scope().push_back(std::make_unique<assign_node>(
+            std::make_unique<id_node>("$t", temporary), std::make_unique<negate_node>(std::make_unique<number_node>(-1))));
+
+        std::ostringstream source;
+        ast.dump_source(source);
+
+        REQUIRE(source.str() == "n = ?;\n"
+                                "x = -n * (2 - -3);\n"
+                                "while (x < (n / 2)) {\n"
+                                "    x += 1;\n"
+                                "    if (x == 4) {\n"
+                                "        print(x);\n"
+                                "    }\n"
+                                "}\n"
+                                "t = (0 - -1);\n");
+
+        std::string text = source.str();
+        paracl::ast reparsed(tokenize(text));
+
+        std::ostringstream original, copy;
+        ast.dump(original);
+        reparsed.dump(copy);
+
+        REQUIRE(copy.str() == "main( = (n scan) = (x * (- (n) - (2 - (3)))) "
+                              "while ((&lt; (x / (n 2))) (+= (x 1)) (if ((== (x 4)) (print( x ))))) "
+                              "= (t - (0 - (1))) )");
+    }
+}